@@ -124,6 +124,8 @@ CAPABILITIES:
 - Read and write files anywhere on the filesystem
 - List directory contents and fast recursive file search via `search_files`
 - Read the last N lines of large files efficiently via `tail_file`
+- Search file contents natively via `grep` instead of shelling out
+- Find what is filling the disk via `disk_usage` (cached, so repeat calls are cheap)
 - Monitor CPU, memory, disk, and running processes via `system_info` and `process_list`
 - View the process tree with parent-child hierarchy via `process_tree`
 - Inspect network connections, listening ports, and interface stats via `network_connections`, `listening_ports`, `network_interfaces`
@@ -18,6 +18,7 @@ from dataclasses import dataclass, field
 from pathlib import Path
 
 from ..config import config
+from ..kernel_loader import load_kernel
 
 logger = logging.getLogger(__name__)
 
@@ -231,9 +232,8 @@ class SkillEngine:
 
     def _start_watcher(self) -> None:
         """Start the FSWatcher background thread to monitor skill directories."""
-        try:
-            import agent_kernel  # type: ignore
-        except ImportError:
+        agent_kernel = load_kernel()
+        if agent_kernel is None:
             logger.info("agent_kernel not available — skill hot-reload disabled")
             return
 
@@ -248,17 +248,20 @@ class SkillEngine:
 
         def watcher_loop():
             try:
-                watcher = agent_kernel.FSWatcher()
+                # Debounce so an editor's save (write, rename, chmod) rescans once
+                watcher = agent_kernel.FSWatcher(debounce_ms=100)
                 for d in watch_dirs:
-                    watcher.watch(d)
+                    watcher.watch(d, recursive=True)
                     logger.info("FSWatcher watching skill directory: %s", d)
 
+                overflow = agent_kernel.FSEventType.Overflow
                 while not self._watcher_stop.is_set():
                     events = watcher.poll(1000)  # 1s timeout
                     if events:
-                        # Filter for SKILL.md changes
+                        # Filter for SKILL.md changes, skill directories coming
+                        # and going, and lost events
                         relevant = any(
-                            ev.name.endswith(".md") or ev.name == ""
+                            ev.type == overflow or ev.is_dir or ev.name.endswith(".md")
                             for ev in events
                         )
                         if relevant:
@@ -12,16 +12,18 @@ import asyncio
 import json
 import logging
 import os
+import stat
+import threading
 from dataclasses import dataclass, field
 from typing import Any, Callable, Awaitable
 
+from ..kernel_async import kernel_async
+from ..kernel_loader import load_kernel
+
 logger = logging.getLogger(__name__)
 
 # Import kernel once at module level — avoids repeated try/except in every handler
-try:
-    import agent_kernel  # type: ignore
-except ImportError:
-    agent_kernel = None  # type: ignore
+agent_kernel = load_kernel()
 
 
 @dataclass(frozen=True)
@@ -106,27 +108,35 @@ class ToolRegistry:
 # ═══════════════════════════════════════════════════════════════════════════
 
 
+_sandbox_pool = None
+
+
+def _get_sandbox_pool():
+    """Shared pool of pre-spawned sandbox workers, created on first use."""
+    global _sandbox_pool
+    if _sandbox_pool is None:
+        policy = agent_kernel.SandboxPolicy()
+        policy.working_dir = "/home/agent"
+        policy.drop_privileges = False  # already running as agent user
+        policy.limits.max_memory_bytes = 512 * 1024 * 1024   # 512 MB
+        policy.limits.max_file_size = 100 * 1024 * 1024      # 100 MB
+        policy.limits.max_open_files = 256
+        policy.limits.max_processes = 64
+        policy.output_head_bytes = 16 * 1024   # bound per-stream memory
+        policy.output_tail_bytes = 64 * 1024
+        _sandbox_pool = agent_kernel.SandboxPool(policy, workers=2, max_uses=100)
+    return _sandbox_pool
+
+
 async def _execute_command(command: str, timeout: int = 30) -> str:
     """Execute a shell command using the C++ sandbox (with resource limits)."""
     if agent_kernel is not None:
         try:
-            policy = agent_kernel.SandboxPolicy()
-            policy.working_dir = "/home/agent"
-            policy.drop_privileges = False  # already running as agent user
-            policy.limits.max_memory_bytes = 512 * 1024 * 1024   # 512 MB
-            policy.limits.max_file_size = 100 * 1024 * 1024      # 100 MB
-            policy.limits.max_open_files = 256
-            policy.limits.max_processes = 64
-
+            pool = _get_sandbox_pool()
             loop = asyncio.get_running_loop()
-            if timeout > 0:
-                result = await loop.run_in_executor(
-                    None, lambda: agent_kernel.Sandbox.run_with_timeout(command, timeout, policy)
-                )
-            else:
-                result = await loop.run_in_executor(
-                    None, lambda: agent_kernel.Sandbox.run(command, policy)
-                )
+            result = await loop.run_in_executor(
+                None, lambda: pool.run(command, max(timeout, 0))
+            )
 
             output = result.stdout_output
             if result.stderr_output:
@@ -136,6 +146,14 @@ async def _execute_command(command: str, timeout: int = 30) -> str:
                 "exit_code": result.exit_code,
                 "output": output.strip()[:8000],
             }
+            if result.user_cpu_seconds >= 0:
+                resp["cpu_seconds"] = round(result.user_cpu_seconds + result.sys_cpu_seconds, 3)
+            if result.major_faults > 0:
+                resp["major_faults"] = result.major_faults
+            if result.term_signal:
+                resp["signal"] = result.term_signal
+            if result.truncated:
+                resp["truncated"] = True
             if result.timed_out:
                 resp["timed_out"] = True
                 resp["error"] = f"Command timed out after {timeout}s"
@@ -211,14 +229,62 @@ async def _list_directory(path: str = ".") -> str:
         return json.dumps({"error": str(e)})
 
 
+_INDEX_ROOT = "/home/agent"
+_file_index: Any = None
+_file_index_lock = threading.Lock()
+
+
+def _index_cache_path() -> str:
+    """Index cache in a private per-user directory, or "" to run without one.
+
+    Not /tmp: sandboxed commands run there and could plant or poison the
+    index the agent trusts.
+    """
+    base = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    cache_dir = os.path.join(base, "agent_kernel")
+    try:
+        os.makedirs(cache_dir, mode=0o700, exist_ok=True)
+        st = os.lstat(cache_dir)
+        if not stat.S_ISDIR(st.st_mode) or st.st_uid != os.getuid():
+            raise OSError(f"{cache_dir} is not a directory owned by this user")
+        if stat.S_IMODE(st.st_mode) != 0o700:
+            os.chmod(cache_dir, 0o700)
+    except OSError as e:
+        logger.warning("File index cache disabled: %s", e)
+        return ""
+    return os.path.join(cache_dir, "file_index.bin")
+
+
+def _indexed_search(path: str, pattern: str) -> list[Any]:
+    """Answer from the persistent FileIndex under _INDEX_ROOT, else walk."""
+    global _file_index
+    root = os.path.normpath(path)
+    in_root = root == _INDEX_ROOT or root.startswith(_INDEX_ROOT + "/")
+    if not in_root or not os.path.isdir(root):
+        return agent_kernel.FileUtils.search(path, pattern, 10, 100)
+    with _file_index_lock:
+        if _file_index is None:
+            cache = _index_cache_path()
+            index = agent_kernel.FileIndex(_INDEX_ROOT, cache)
+            if cache:
+                try:
+                    index.save()
+                except RuntimeError as e:
+                    logger.warning("Cannot write file index cache: %s", e)
+            _file_index = index
+    if not _file_index.fully_watched():
+        # Out of inotify watches: parts of the tree would go stale
+        return agent_kernel.FileUtils.search(path, pattern, 10, 100)
+    _file_index.update(0)
+    return _file_index.search(root, pattern, 10, 100)
+
+
 async def _search_files(pattern: str, path: str = "/home/agent") -> str:
     """Search for files matching a glob pattern using the C++ kernel."""
     if agent_kernel is not None:
         try:
             loop = asyncio.get_running_loop()
-            results = await loop.run_in_executor(
-                None, lambda: agent_kernel.FileUtils.search(path, pattern, 10, 100)
-            )
+            results = await loop.run_in_executor(None, lambda: _indexed_search(path, pattern))
             matches = [
                 {"path": r.path, "size": r.size, "is_dir": r.is_dir}
                 for r in results
@@ -244,12 +310,9 @@ async def _system_info() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        cpu, mem, disk = await asyncio.gather(
-            loop.run_in_executor(None, agent_kernel.SystemMetrics.cpu),
-            loop.run_in_executor(None, agent_kernel.SystemMetrics.memory),
-            loop.run_in_executor(None, lambda: agent_kernel.SystemMetrics.disk("/")),
-        )
+        kasync = kernel_async(agent_kernel)
+        snap = await kasync.snapshot()
+        cpu, mem, disk = snap.cpu, snap.memory, snap.disk
 
         result: dict[str, Any] = {
             "cpu": {"usage_percent": round(cpu.usage_percent, 1), "cores": cpu.core_count,
@@ -262,7 +325,7 @@ async def _system_info() -> str:
         }
 
         try:
-            cg = await loop.run_in_executor(None, agent_kernel.CgroupManager.info)
+            cg = await kasync.cgroup_info()
             result["container"] = {
                 "is_containerized": cg.is_containerized,
                 "cgroup_version": cg.cgroup_version,
@@ -285,8 +348,8 @@ async def _process_list() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        procs = await loop.run_in_executor(None, agent_kernel.ProcessManager.list_all)
+        kasync = kernel_async(agent_kernel)
+        procs = await kasync.list_processes()
         sorted_procs = sorted(procs, key=lambda p: p.rss_kb, reverse=True)[:30]
         return json.dumps({
             "processes": [
@@ -304,8 +367,8 @@ async def _process_tree() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        nodes = await loop.run_in_executor(None, agent_kernel.ProcessManager.tree)
+        kasync = kernel_async(agent_kernel)
+        nodes = await kasync.process_tree()
         tree = []
         for node in nodes[:80]:
             p = node.info
@@ -328,8 +391,8 @@ async def _network_connections(protocol: str = "tcp") -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        conns = await loop.run_in_executor(None, lambda: agent_kernel.NetworkMonitor.connections(protocol))
+        kasync = kernel_async(agent_kernel)
+        conns = await kasync.connections(protocol)
         return json.dumps({
             "protocol": protocol,
             "count": len(conns),
@@ -351,8 +414,8 @@ async def _network_interfaces() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        ifaces = await loop.run_in_executor(None, agent_kernel.NetworkMonitor.interfaces)
+        kasync = kernel_async(agent_kernel)
+        ifaces = await kasync.interfaces()
         return json.dumps({
             "interfaces": [
                 {
@@ -376,8 +439,8 @@ async def _listening_ports() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        ports = await loop.run_in_executor(None, agent_kernel.NetworkMonitor.listening_ports)
+        kasync = kernel_async(agent_kernel)
+        ports = await kasync.listening_ports()
         return json.dumps({
             "count": len(ports),
             "ports": [
@@ -393,15 +456,93 @@ async def _listening_ports() -> str:
         return json.dumps({"error": str(e)})
 
 
-async def _tail_file(path: str, lines: int = 50) -> str:
+async def _disk_usage(path: str = "/", top: int = 10) -> str:
+    """du-style breakdown of a directory tree (cached between calls)."""
+    if agent_kernel is None:
+        return json.dumps({"error": "agent_kernel not available"})
+    try:
+        kasync = kernel_async(agent_kernel)
+        report = await kasync.disk_usage(path, max(1, min(top, 50)), 3)
+        t = report.total
+        return json.dumps({
+            "path": t.path,
+            "allocated_mb": round(t.allocated_bytes / 1e6, 1),
+            "apparent_mb": round(t.apparent_bytes / 1e6, 1),
+            "files": t.files,
+            "dirs": t.dirs,
+            "largest": [
+                {"path": d.path, "allocated_mb": round(d.allocated_bytes / 1e6, 1), "files": d.files}
+                for d in report.top
+            ],
+        })
+    except Exception as e:
+        return json.dumps({"error": str(e)})
+
+
+async def _grep(pattern: str, path: str = "/home/agent", regex: bool = False,
+                ignore_case: bool = False, context: int = 0, include: str = "") -> str:
+    """Search file contents natively, without forking a shell."""
+    if agent_kernel is None:
+        return json.dumps({"error": "agent_kernel not available"})
+    try:
+        opts = agent_kernel.GrepOptions()
+        opts.regex = regex
+        opts.ignore_case = ignore_case
+        opts.context = max(0, min(context, 10))
+        opts.include = include
+        opts.skip_dirs = [".git", "node_modules", "__pycache__"]
+        opts.max_matches = 200
+        opts.max_bytes = 64 * 1024
+        kasync = kernel_async(agent_kernel)
+        result = await kasync.grep(path, pattern, opts)
+        matches = []
+        for m in result.matches:
+            entry: dict[str, Any] = {"path": m.path, "line": m.line, "text": m.text}
+            if context:
+                entry["before"] = m.before
+                entry["after"] = m.after
+            matches.append(entry)
+        return json.dumps({
+            "pattern": pattern, "root": path, "matches": matches,
+            "files_scanned": result.files_scanned, "truncated": result.truncated,
+        })
+    except Exception as e:
+        return json.dumps({"error": str(e)})
+
+
+_MAX_FOLLOWERS = 16
+_followers: dict[str, Any] = {}
+_followers_lock = threading.Lock()
+
+
+def _tail_or_follow(path: str, lines: int, follow: bool) -> tuple[str, bool]:
+    """Return (content, is_new_data). The first follow of a path tails it;
+    later ones return only what was appended since the previous call."""
+    with _followers_lock:
+        follower = _followers.get(path) if follow else None
+        if follow and follower is None:
+            content = agent_kernel.FileUtils.tail(path, lines)
+            if len(_followers) >= _MAX_FOLLOWERS:
+                _followers.pop(next(iter(_followers)))
+            _followers[path] = agent_kernel.TailFollower(path)
+            return content, False
+    if follower is None:
+        return agent_kernel.FileUtils.tail(path, lines), False
+    return follower.read(0).decode(errors="replace"), True
+
+
+async def _tail_file(path: str, lines: int = 50, follow: bool = False) -> str:
     """Read the last N lines of a file (efficient for large log files)."""
     if agent_kernel is not None:
         try:
             loop = asyncio.get_running_loop()
-            content = await loop.run_in_executor(
-                None, lambda: agent_kernel.FileUtils.tail(path, lines)
+            content, appended = await loop.run_in_executor(
+                None, lambda: _tail_or_follow(path, lines, follow)
             )
-            return json.dumps({"path": path, "lines": lines, "content": content})
+            result: dict[str, Any] = {"path": path, "lines": lines, "content": content}
+            if follow:
+                result["appended_since_last_call"] = appended
+            return json.dumps(result)
         except Exception as e:
             return json.dumps({"error": str(e)})
     else:
@@ -421,14 +562,19 @@ async def _container_info() -> str:
     if agent_kernel is None:
         return json.dumps({"error": "agent_kernel not available"})
     try:
-        loop = asyncio.get_running_loop()
-        cg = await loop.run_in_executor(None, agent_kernel.CgroupManager.info)
+        kasync = kernel_async(agent_kernel)
+        cg = await kasync.cgroup_info()
         return json.dumps({
             "is_containerized": cg.is_containerized,
             "cgroup_version": cg.cgroup_version,
             "memory_limit_mb": round(cg.memory_limit_bytes / 1e6, 1) if cg.memory_limit_bytes > 0 else "unlimited",
             "memory_usage_mb": round(cg.memory_usage_bytes / 1e6, 1) if cg.memory_usage_bytes > 0 else "unknown",
+            "memory_anon_mb": round(cg.memory_anon_bytes / 1e6, 1) if cg.memory_anon_bytes >= 0 else "unknown",
+            "memory_page_cache_mb": round(cg.memory_file_bytes / 1e6, 1) if cg.memory_file_bytes >= 0 else "unknown",
             "cpu_quota_cores": round(cg.cpu_quota, 2) if cg.cpu_quota > 0 else "unlimited",
+            "cpu_throttled_count": cg.cpu_nr_throttled if cg.cpu_nr_throttled >= 0 else "unknown",
+            "io_read_mb": round(cg.io_read_bytes / 1e6, 1) if cg.io_read_bytes >= 0 else "unknown",
+            "io_write_mb": round(cg.io_write_bytes / 1e6, 1) if cg.io_write_bytes >= 0 else "unknown",
             "pids_limit": cg.pids_limit if cg.pids_limit > 0 else "unlimited",
             "pids_current": cg.pids_current if cg.pids_current > 0 else "unknown",
         })
@@ -482,6 +628,30 @@ def create_builtin_tools() -> list[ToolDef]:
             ],
             handler=_search_files,
         ),
+        ToolDef(
+            name="grep",
+            description="Search file contents under a directory (or in one file) for a string or regex. "
+                        "Returns matching lines with line numbers; binary files, .git and node_modules are skipped.",
+            parameters=[
+                ToolParam("pattern", "string", "Text to search for (a regex when regex is true)"),
+                ToolParam("path", "string", "File or directory to search (default: /home/agent)", required=False),
+                ToolParam("regex", "boolean", "Treat pattern as an ECMAScript regex (default false)", required=False),
+                ToolParam("ignore_case", "boolean", "Case-insensitive match (default false)", required=False),
+                ToolParam("context", "integer", "Lines of context around each match (default 0, max 10)", required=False),
+                ToolParam("include", "string", "Only search file names matching this glob, e.g. '*.py'", required=False),
+            ],
+            handler=_grep,
+        ),
+        ToolDef(
+            name="disk_usage",
+            description="Show how much disk space a directory tree uses and its largest subdirectories "
+                        "(like du, without crossing mount points). Repeated calls are fast.",
+            parameters=[
+                ToolParam("path", "string", "Directory to measure (default: /)", required=False),
+                ToolParam("top", "integer", "Number of largest subdirectories to list (default 10)", required=False),
+            ],
+            handler=_disk_usage,
+        ),
         ToolDef(
             name="system_info",
             description="Get current system metrics: CPU usage, memory, disk space, load averages, and container info.",
@@ -522,10 +692,12 @@ def create_builtin_tools() -> list[ToolDef]:
         ),
         ToolDef(
             name="tail_file",
-            description="Read the last N lines of a file efficiently. Ideal for large log files.",
+            description="Read the last N lines of a file efficiently. Ideal for large log files. "
+                        "With follow, later calls return only the data appended since the previous call.",
             parameters=[
                 ToolParam("path", "string", "Absolute path to the file"),
                 ToolParam("lines", "integer", "Number of lines to read from end (default 50)", required=False),
+                ToolParam("follow", "boolean", "Follow the file like tail -f (default false)", required=False),
             ],
             handler=_tail_file,
         ),
@@ -0,0 +1,87 @@
+"""asyncio front end for the kernel's CompletionQueue.
+
+Kernel calls run on the kernel's own worker pool with the GIL released;
+their completions are signalled on an eventfd the event loop watches with
+add_reader, so awaiting one ties up no executor thread:
+
+    kernel = kernel_async(agent_kernel)
+    snap = await kernel.snapshot()
+    await kernel.readable(stream.fd())
+    events = await kernel.poll(stream, 0)
+"""
+
+from __future__ import annotations
+
+import asyncio
+from typing import Any, Callable
+
+
+class KernelAsync:
+    """Awaitable wrappers over one agent_kernel.CompletionQueue.
+
+    Any CompletionQueue method taking a leading `done` callback is exposed
+    as a future-returning attribute of the same name.
+    """
+
+    def __init__(self, kernel: Any, loop: asyncio.AbstractEventLoop, threads: int = 0) -> None:
+        self._loop = loop
+        self._queue = kernel.CompletionQueue(threads)
+        loop.add_reader(self._queue.fd(), self._queue.run_completions)
+
+    def __getattr__(self, name: str) -> Callable[..., asyncio.Future]:
+        method = getattr(self._queue, name)
+
+        def call(*args: Any, **kwargs: Any) -> asyncio.Future:
+            future = self._loop.create_future()
+
+            def done(result: Any, error: BaseException | None) -> None:
+                if future.done():  # cancelled while the kernel was working
+                    return
+                if error is not None:
+                    future.set_exception(error)
+                else:
+                    future.set_result(result)
+
+            method(done, *args, **kwargs)
+            return future
+
+        return call
+
+    async def readable(self, fd: int) -> None:
+        """Wait for a kernel object's event fd (ProcessEventStream.fd(),
+        CgroupWatcher.fd(), ...) to become readable, on the event loop
+        itself. A poll(obj, 0) then collects the events without parking a
+        worker in a blocking wait."""
+        future = self._loop.create_future()
+
+        def ready() -> None:
+            self._loop.remove_reader(fd)  # level-triggered: stop until awaited again
+            if not future.done():
+                future.set_result(None)
+
+        self._loop.add_reader(fd, ready)
+        try:
+            await future
+        finally:
+            self._loop.remove_reader(fd)
+
+    @property
+    def pending(self) -> int:
+        return self._queue.pending()
+
+    def close(self) -> None:
+        """Stop watching the eventfd. Work still running is waited for when
+        the queue is garbage collected."""
+        self._loop.remove_reader(self._queue.fd())
+
+
+_instances: dict[asyncio.AbstractEventLoop, KernelAsync] = {}
+
+
+def kernel_async(kernel: Any) -> KernelAsync:
+    """The KernelAsync for the running event loop, created on first use."""
+    loop = asyncio.get_running_loop()
+    instance = _instances.get(loop)
+    if instance is None:
+        instance = _instances[loop] = KernelAsync(kernel, loop)
+    return instance
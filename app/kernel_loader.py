@@ -0,0 +1,103 @@
+"""Import agent_kernel, preferring a build specialised for this CPU.
+
+Release builds may ship extra copies of the extension compiled with
+-march=x86-64-v2/v3/v4, one per directory under AGENT_KERNEL_VARIANTS
+(default /usr/local/lib/agent_kernel/variants/<arch>/). load_kernel()
+imports the highest level the CPU supports and registers it as
+`agent_kernel`, so later plain imports get the same module; with no usable
+variant it falls back to `import agent_kernel`. AGENT_KERNEL_MARCH forces
+a level, or "baseline" for the generic build.
+"""
+
+from __future__ import annotations
+
+import glob
+import importlib.util
+import logging
+import os
+import sys
+from types import ModuleType
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_VARIANTS_DIR = "/usr/local/lib/agent_kernel/variants"
+
+# Defining CPU flags of each x86-64 microarchitecture level, as named in
+# /proc/cpuinfo. Best first.
+_LEVELS: list[tuple[str, set[str]]] = [
+    ("x86-64-v4", {"avx512f", "avx512bw", "avx512cd", "avx512dq", "avx512vl"}),
+    ("x86-64-v3", {"avx", "avx2", "bmi1", "bmi2", "f16c", "fma", "abm", "movbe", "xsave"}),
+    ("x86-64-v2", {"cx16", "lahf_lm", "popcnt", "sse4_1", "sse4_2", "ssse3"}),
+]
+
+_kernel: ModuleType | None = None
+_variant = "unavailable"
+_loaded = False
+
+
+def cpu_flags() -> set[str]:
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("flags"):
+                    return set(line.split(":", 1)[1].split())
+    except OSError:
+        pass
+    return set()
+
+
+def supported_levels(flags: set[str]) -> list[str]:
+    """Levels these flags satisfy, best first. Each level implies the ones below."""
+    levels: list[str] = []
+    for name, required in reversed(_LEVELS):
+        if not required <= flags:
+            break
+        levels.insert(0, name)
+    return levels
+
+
+def _load_variant(path: str) -> ModuleType:
+    spec = importlib.util.spec_from_file_location("agent_kernel", path)
+    if spec is None or spec.loader is None:
+        raise ImportError(f"cannot load {path}")
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def load_kernel() -> ModuleType | None:
+    """The agent_kernel module, or None when it is not installed."""
+    global _kernel, _variant, _loaded
+    if _loaded:
+        return _kernel
+    _loaded = True
+
+    forced = os.environ.get("AGENT_KERNEL_MARCH", "")
+    if "agent_kernel" not in sys.modules and forced != "baseline":
+        root = os.environ.get("AGENT_KERNEL_VARIANTS", DEFAULT_VARIANTS_DIR)
+        candidates = [forced] if forced else supported_levels(cpu_flags())
+        for level in candidates:
+            paths = glob.glob(os.path.join(root, level, "agent_kernel*.so"))
+            if not paths:
+                continue
+            try:
+                _kernel = sys.modules["agent_kernel"] = _load_variant(paths[0])
+                _variant = level
+                break
+            except ImportError as e:
+                logger.warning("agent_kernel %s build failed to load: %s", level, e)
+
+    if _kernel is None:
+        try:
+            import agent_kernel  # type: ignore
+        except ImportError:
+            return None
+        _kernel = agent_kernel
+        _variant = "baseline"
+    logger.info("agent_kernel loaded (%s): %s", _variant, getattr(_kernel, "build_profile", "?"))
+    return _kernel
+
+
+def variant() -> str:
+    """Which build load_kernel() picked: an -march level, "baseline" or "unavailable"."""
+    return _variant
@@ -17,9 +17,12 @@ Endpoints:
     POST /api/monitor/autoheal   → Toggle auto-heal on/off
     POST /api/monitor/dismiss    → Dismiss an alert
     GET  /api/system/metrics     → System metrics (CPU, memory, disk)
+    GET  /api/system/history     → Recent metric samples from the background collector
     GET  /api/system/processes   → Process list
     GET  /api/system/network     → Network connections + interfaces
     GET  /api/system/container   → Container/cgroup information
+    GET  /api/system/kernel-stats → Kernel call counts, latencies and syscall counters
+    GET  /metrics                → The same in Prometheus text format
     GET  /api/sessions           → Active agent sessions
     GET  /api/health             → Liveness probe
     /mcp                         → FastMCP server (MCP protocol)
@@ -28,6 +31,7 @@ Endpoints:
 from __future__ import annotations
 
 import asyncio
+import heapq
 import json
 import logging
 import os
@@ -35,7 +39,7 @@ import uuid
 
 from dotenv import load_dotenv
 from fastapi import FastAPI, File, UploadFile, WebSocket, WebSocketDisconnect
-from fastapi.responses import FileResponse, JSONResponse, StreamingResponse
+from fastapi.responses import FileResponse, JSONResponse, PlainTextResponse, StreamingResponse
 from fastapi.staticfiles import StaticFiles
 from pydantic import BaseModel
 
@@ -43,16 +47,15 @@ from .agent.loop import AgentLoop, Attachment
 from .agent.tools import ToolRegistry, create_builtin_tools
 from .agent.skills import SkillEngine
 from .config import config
+from .kernel_async import kernel_async
+from .kernel_loader import load_kernel, variant as kernel_variant
 from .monitor import HealthMonitor
 from .terminal import TerminalManager
 
 load_dotenv()
 
-# Import kernel once at module level
-try:
-    import agent_kernel  # type: ignore
-except ImportError:
-    agent_kernel = None  # type: ignore
+# Import kernel once at module level (the build best suited to this CPU)
+agent_kernel = load_kernel()
 
 logging.basicConfig(level=logging.INFO, format="%(asctime)s %(levelname)-8s %(name)s %(message)s")
 logger = logging.getLogger(__name__)
@@ -67,6 +70,8 @@ skills = SkillEngine()
 agent = AgentLoop(tools, skills)
 terminal_mgr = TerminalManager()
 monitor = HealthMonitor()
+# Background sampler: 1 s ticks, 10 minutes of history
+collector = agent_kernel.MetricsCollector(1000, 600) if agent_kernel is not None else None
 
 # In-memory attachment store (attachment_id → (Attachment, upload_time))
 _uploads: dict[str, tuple[Attachment, float]] = {}
@@ -106,6 +111,15 @@ if os.path.isdir(os.path.join(STATIC_DIR, "assets")):
 async def on_startup():
     monitor.start()
     logger.info("HealthMonitor background task started")
+    if collector is not None:
+        collector.start()
+        logger.info("MetricsCollector sampling every %d ms", collector.interval_ms())
+
+
+@app.on_event("shutdown")
+async def on_shutdown():
+    if collector is not None:
+        collector.stop()
 
 
 @app.get("/")
@@ -386,12 +400,8 @@ async def monitor_dismiss(req: DismissRequest):
 async def system_metrics():
     if agent_kernel is None:
         return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
-    loop = asyncio.get_running_loop()
-    cpu, mem, disk = await asyncio.gather(
-        loop.run_in_executor(None, agent_kernel.SystemMetrics.cpu),
-        loop.run_in_executor(None, agent_kernel.SystemMetrics.memory),
-        loop.run_in_executor(None, lambda: agent_kernel.SystemMetrics.disk("/")),
-    )
+    snap = await kernel_async(agent_kernel).snapshot()
+    cpu, mem, disk = snap.cpu, snap.memory, snap.disk
     return JSONResponse({
         "cpu": {"usage_percent": round(cpu.usage_percent, 1), "cores": cpu.core_count,
                 "load": [round(cpu.load_1m, 2), round(cpu.load_5m, 2), round(cpu.load_15m, 2)]},
@@ -402,18 +412,44 @@ async def system_metrics():
     })
 
 
+@app.get("/api/system/history")
+async def system_history(n: int = 60, since: int = 0):
+    if collector is None:
+        return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
+    # Reads copy out of the ring and never wait on the sampler, so no executor
+    samples = collector.since(since) if since > 0 else collector.history(max(n, 0))
+    return JSONResponse({
+        "interval_ms": collector.interval_ms(),
+        "samples": [{
+            "ts": s.timestamp_ms,
+            "cpu": round(s.cpu_percent, 1),
+            "cores": [round(c, 1) for c in s.core_percent],
+            "load": [round(s.load_1m, 2), round(s.load_5m, 2), round(s.load_15m, 2)],
+            "mem_used_mb": (s.mem_total_kb - s.mem_available_kb) // 1024,
+            "mem_total_mb": s.mem_total_kb // 1024,
+            "disk_used_gb": round(s.disk_used_bytes / 1e9, 1),
+            "net_rx_bps": round(s.net_rx_bytes_per_sec),
+            "net_tx_bps": round(s.net_tx_bytes_per_sec),
+            "cgroup_mem_mb": s.cgroup_memory_bytes // (1024 * 1024) if s.cgroup_memory_bytes >= 0 else None,
+            "cgroup_cpu": round(s.cgroup_cpu_percent, 1) if s.cgroup_cpu_percent >= 0 else None,
+        } for s in samples],
+    })
+
+
 @app.get("/api/system/processes")
 async def system_processes():
     if agent_kernel is None:
         return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
     loop = asyncio.get_running_loop()
-    procs = await loop.run_in_executor(None, agent_kernel.ProcessManager.list_all)
-    sorted_procs = sorted(procs, key=lambda p: p.rss_kb, reverse=True)[:50]
+    # Columns come back as buffers, so only the 50 rows we return become objects
+    cols = await loop.run_in_executor(None, agent_kernel.ProcessManager.list_columns)
+    pid, state, rss = memoryview(cols.pid), memoryview(cols.state), memoryview(cols.rss_kb)
+    top = heapq.nlargest(50, range(len(rss)), key=rss.__getitem__)
     return JSONResponse({
         "processes": [
-            {"pid": p.pid, "name": p.name, "state": p.state,
-             "rss_mb": round(p.rss_kb / 1024, 1), "cmdline": p.cmdline[:200]}
-            for p in sorted_procs
+            {"pid": pid[i], "name": cols.name[i], "state": chr(state[i]),
+             "rss_mb": round(rss[i] / 1024, 1), "cmdline": cols.cmdline[i][:200]}
+            for i in top
         ]
     })
 
@@ -425,12 +461,12 @@ async def system_processes():
 async def system_network():
     if agent_kernel is None:
         return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
-    loop = asyncio.get_running_loop()
+    kasync = kernel_async(agent_kernel)
     tcp, tcp6, ifaces, listening = await asyncio.gather(
-        loop.run_in_executor(None, lambda: agent_kernel.NetworkMonitor.connections("tcp")),
-        loop.run_in_executor(None, lambda: agent_kernel.NetworkMonitor.connections("tcp6")),
-        loop.run_in_executor(None, agent_kernel.NetworkMonitor.interfaces),
-        loop.run_in_executor(None, agent_kernel.NetworkMonitor.listening_ports),
+        kasync.connections("tcp"),
+        kasync.connections("tcp6"),
+        kasync.interfaces(),
+        kasync.listening_ports(),
     )
     return JSONResponse({
         "connections": {
@@ -455,17 +491,25 @@ async def system_network():
 async def system_container():
     if agent_kernel is None:
         return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
-    loop = asyncio.get_running_loop()
-    cg = await loop.run_in_executor(None, agent_kernel.CgroupManager.info)
+    cg = await kernel_async(agent_kernel).cgroup_info()
     return JSONResponse({
         "is_containerized": cg.is_containerized,
         "cgroup_version": cg.cgroup_version,
         "memory": {
             "limit_mb": round(cg.memory_limit_bytes / 1e6, 1) if cg.memory_limit_bytes > 0 else None,
             "usage_mb": round(cg.memory_usage_bytes / 1e6, 1) if cg.memory_usage_bytes > 0 else None,
+            "anon_mb": round(cg.memory_anon_bytes / 1e6, 1) if cg.memory_anon_bytes >= 0 else None,
+            "file_mb": round(cg.memory_file_bytes / 1e6, 1) if cg.memory_file_bytes >= 0 else None,
         },
         "cpu": {
             "quota_cores": round(cg.cpu_quota, 2) if cg.cpu_quota > 0 else None,
+            "usage_sec": round(cg.cpu_usage_usec / 1e6, 1) if cg.cpu_usage_usec >= 0 else None,
+            "nr_throttled": cg.cpu_nr_throttled if cg.cpu_nr_throttled >= 0 else None,
+            "throttled_sec": round(cg.cpu_throttled_usec / 1e6, 1) if cg.cpu_throttled_usec >= 0 else None,
+        },
+        "io": {
+            "read_mb": round(cg.io_read_bytes / 1e6, 1) if cg.io_read_bytes >= 0 else None,
+            "write_mb": round(cg.io_write_bytes / 1e6, 1) if cg.io_write_bytes >= 0 else None,
         },
         "pids": {
             "limit": cg.pids_limit if cg.pids_limit > 0 else None,
@@ -474,6 +518,23 @@ async def system_container():
     })
 
 
+@app.get("/api/system/kernel-stats")
+async def system_kernel_stats():
+    if agent_kernel is None:
+        return JSONResponse({"error": "C++ kernel not available"}, status_code=503)
+    stats = agent_kernel.stats()
+    stats["probes"] = {name: p for name, p in stats["probes"].items() if p["calls"]}
+    stats["build"] = {"variant": kernel_variant(), "profile": getattr(agent_kernel, "build_profile", "unknown")}
+    return JSONResponse(stats)
+
+
+@app.get("/metrics")
+async def prometheus_metrics():
+    if agent_kernel is None:
+        return PlainTextResponse("", status_code=503)
+    return PlainTextResponse(agent_kernel.stats_prometheus(), media_type="text/plain; version=0.0.4")
+
+
 # ── Session management ──────────────────────────────────────────────────
 
 
@@ -13,6 +13,7 @@ from pathlib import Path
 from fastmcp import FastMCP
 
 from ..config import config
+from ..kernel_loader import load_kernel
 
 logger = logging.getLogger(__name__)
 
@@ -100,7 +101,9 @@ async def list_directory(path: str = "/home/agent") -> str:
 async def system_status() -> str:
     """Get current system status: CPU, memory, disk, uptime."""
     try:
-        import agent_kernel  # type: ignore
+        agent_kernel = load_kernel()
+        if agent_kernel is None:
+            raise ImportError("agent_kernel not available")
         cpu = agent_kernel.SystemMetrics.cpu()
         mem = agent_kernel.SystemMetrics.memory()
         disk = agent_kernel.SystemMetrics.disk("/")
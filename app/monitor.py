@@ -10,7 +10,10 @@ Anomaly types:
   - Disk space critically low
   - Zombie/defunct processes detected
   - Unexpected new listening ports
+  - Packet drops or errors on a network interface
   - Process crash detection (key processes disappeared)
+  - cgroup pressure stalls, memory limit hits, OOM kills and CPU throttling,
+    pushed by kernel notifications rather than sampled
 """
 
 from __future__ import annotations
@@ -22,6 +25,9 @@ from dataclasses import dataclass, field
 from enum import Enum
 from typing import Any
 
+from .kernel_async import kernel_async
+from .kernel_loader import load_kernel
+
 logger = logging.getLogger(__name__)
 
 
@@ -71,12 +77,20 @@ class HealthMonitor:
         self.mem_crit: float = 70.0
         self.disk_warn: float = 40.0
         self.disk_crit: float = 80.0
+        self.net_drop_warn: float = 10.0  # dropped or errored packets/s per interface
 
         # State tracking for deduplication
         self._known_listeners: set[int] = set()
         self._known_pids: set[int] = set()
         self._initial_scan_done: bool = False
         self._task: asyncio.Task | None = None
+        self._procs: Any = None  # agent_kernel.ProcessTable, fed by the event stream
+        self._sockets: Any = None  # agent_kernel.SocketOwnerIndex, fed by the same events
+        self._ifaces: Any = None  # agent_kernel.InterfaceSampler, one sample per health tick
+        self._dropping: set[str] = set()
+        self._zombies_checked: float = 0.0  # monotonic time of the last zombie count
+        self._proc_task: asyncio.Task | None = None
+        self._cgroup_task: asyncio.Task | None = None
         self._agent_callback: Any = None
         self._alert_counter: int = 0
 
@@ -99,6 +113,12 @@ class HealthMonitor:
         if self._task:
             self._task.cancel()
             self._task = None
+        if self._proc_task:
+            self._proc_task.cancel()
+            self._proc_task = None
+        if self._cgroup_task:
+            self._cgroup_task.cancel()
+            self._cgroup_task = None
 
     def _make_alert_id(self) -> str:
         self._alert_counter += 1
@@ -143,12 +163,14 @@ class HealthMonitor:
 
     async def _run_loop(self) -> None:
         """Main monitoring loop."""
-        try:
-            import agent_kernel  # type: ignore
-        except ImportError:
+        agent_kernel = load_kernel()
+        if agent_kernel is None:
             logger.info("agent_kernel not available — HealthMonitor disabled")
             return
 
+        self._proc_task = asyncio.ensure_future(self._watch_processes(agent_kernel))
+        self._cgroup_task = asyncio.ensure_future(self._watch_cgroup(agent_kernel))
+
         # Brief startup delay
         await asyncio.sleep(1.0)
 
@@ -164,18 +186,157 @@ class HealthMonitor:
 
             await asyncio.sleep(self.check_interval)
 
+    async def _watch_processes(self, kernel: Any) -> None:
+        """Keep the process table current from kernel process events.
+
+        Exits are reported as they happen (netlink connector, or pidfd plus a
+        1 s rescan without CAP_NET_ADMIN), so zombie detection no longer waits
+        for the next health tick. If the stream cannot start, the health tick
+        keeps counting zombies from a full process listing.
+        """
+        loop = asyncio.get_running_loop()
+        try:
+            table = kernel.ProcessTable()
+            stream = await loop.run_in_executor(None, kernel.ProcessEventStream, table)
+        except Exception:
+            logger.warning("Process event stream unavailable — zombie checks fall back to polling",
+                           exc_info=True)
+            return
+        self._procs = table
+        logger.info("Process event stream started (%s mode)", stream.mode().name)
+
+        sockets = None
+        try:
+            sockets = kernel.SocketOwnerIndex()
+            await loop.run_in_executor(None, sockets.rebuild)
+            self._sockets = sockets
+        except Exception:
+            logger.warning("Socket owner index unavailable — new ports are reported without owners",
+                           exc_info=True)
+            sockets = None
+
+        kasync = kernel_async(kernel)
+        while True:
+            try:
+                await kasync.readable(stream.fd())
+                events = await kasync.poll(stream, 0)
+                if events and sockets is not None:
+                    await kasync.apply(sockets, events)
+                # At most one count a second, however many processes exit
+                if (self.enabled and time.monotonic() - self._zombies_checked >= 1.0
+                        and any(e.type == kernel.ProcEventType.Exit for e in events)):
+                    await self._check_zombies(kernel)
+            except Exception:
+                logger.exception("Process event stream failed")
+                await asyncio.sleep(self.check_interval)
+
+    async def _watch_cgroup(self, kernel: Any) -> None:
+        """Raise alerts from cgroup notifications as they arrive.
+
+        PSI triggers fire only once a stall threshold is crossed and
+        memory.events only when a counter moves, so a healthy cgroup costs
+        nothing. An alert resolves after 30 s without a repeat.
+        """
+        kasync = kernel_async(kernel)
+        watcher = kernel.CgroupWatcher()
+        kind = kernel.CgroupEventType
+        # 2 s is the shortest PSI window allowed without CAP_SYS_RESOURCE
+        window = 2_000_000
+        armed = []
+        for resource, stall in ((kind.MemoryPressure, 200_000),
+                                (kind.CpuPressure, 1_000_000),
+                                (kind.IoPressure, 600_000)):
+            ok = watcher.add_pressure_trigger(resource, stall, window)
+            if not ok:
+                logger.warning("Could not arm %s trigger — no alerts for it", resource.name)
+            armed.append(ok)
+        armed += [watcher.watch_memory_events(), watcher.watch_cpu_throttling(1000)]
+        if not any(armed):
+            logger.info("No cgroup notifications available — cgroup watcher disabled")
+            return
+        logger.info("Cgroup watcher started on %s", watcher.path() or "/proc/pressure")
+
+        last_seen: dict[tuple[str, str], float] = {}
+        while True:
+            try:
+                try:
+                    # Without notifications, only wake while alerts await resolution
+                    await asyncio.wait_for(kasync.readable(watcher.fd()), 1.0 if last_seen else None)
+                    events = await kasync.poll(watcher, 0)
+                except asyncio.TimeoutError:
+                    events = []
+            except Exception:
+                logger.exception("Cgroup watcher failed")
+                await asyncio.sleep(self.check_interval)
+                continue
+
+            now = time.time()
+            for ev in events if self.enabled else []:
+                severity, stall = Severity.WARNING, ev.pressure.some_avg10
+                if ev.type == kind.MemoryPressure:
+                    category, title = "memory", "Memory pressure"
+                    detail = f"Tasks stalled on memory {stall:.1f}% of the last 10s"
+                elif ev.type == kind.CpuPressure:
+                    category, title = "cpu", "CPU pressure"
+                    detail = f"Runnable tasks waited for CPU {stall:.1f}% of the last 10s"
+                elif ev.type == kind.IoPressure:
+                    category, title = "disk", "I/O pressure"
+                    detail = f"Tasks stalled on I/O {stall:.1f}% of the last 10s"
+                elif ev.type == kind.CpuThrottled:
+                    category, title = "cpu", "CPU throttled"
+                    detail = (f"Throttled {ev.nr_throttled} times "
+                              f"({ev.throttled_usec / 1000:.0f} ms) by the cgroup CPU quota")
+                elif ev.oom_kill:
+                    severity, category, title = Severity.CRITICAL, "memory", "OOM kill in cgroup"
+                    detail = f"{ev.oom_kill} process(es) killed by the OOM killer"
+                elif ev.memory_max or ev.oom:
+                    category, title = "memory", "Memory limit reached"
+                    detail = f"Allocations hit memory.max {ev.memory_max + ev.oom} time(s)"
+                else:
+                    category, title = "memory", "Memory pressure"
+                    detail = f"Reclaim throttled at memory.high {ev.memory_high} time(s)"
+
+                alert = self._add_alert(severity, category, title, detail)
+                last_seen[(category, title)] = now
+                if ev.oom_kill:
+                    await self._maybe_auto_heal(alert,
+                        f"CRITICAL: the OOM killer terminated {ev.oom_kill} process(es) in this container. "
+                        f"Find what is using the memory and reduce it."
+                    )
+
+            for key, seen in list(last_seen.items()):
+                if now - seen > 30:
+                    self._resolve_alerts(*key)
+                    del last_seen[key]
+
+    async def _check_zombies(self, kernel: Any) -> None:
+        """Alert when zombie processes pile up."""
+        self._zombies_checked = time.monotonic()
+        if self._procs is not None:
+            zombies = self._procs.count_state('Z')
+        else:
+            # No event stream: count from a fresh listing, as every tick did before
+            procs = await kernel_async(kernel).list_processes()
+            zombies = sum(1 for p in procs if p.state == 'Z')
+        if zombies > 3:
+            alert = self._add_alert(
+                Severity.WARNING, "process", "Zombie processes detected",
+                f"{zombies} zombie processes found",
+            )
+            await self._maybe_auto_heal(alert,
+                f"WARNING: {zombies} zombie processes detected. "
+                f"Investigate their parent processes and clean them up."
+            )
+        else:
+            self._resolve_alerts("process", "Zombie processes detected")
+
     async def _check_health(self, kernel: Any) -> None:
         """Run all health checks."""
-        loop = asyncio.get_running_loop()
+        kasync = kernel_async(kernel)
 
-        # Gather data from C++ kernel in parallel (all release GIL)
-        cpu, mem, disk, procs, listeners = await asyncio.gather(
-            loop.run_in_executor(None, kernel.SystemMetrics.cpu),
-            loop.run_in_executor(None, kernel.SystemMetrics.memory),
-            loop.run_in_executor(None, lambda: kernel.SystemMetrics.disk("/")),
-            loop.run_in_executor(None, kernel.ProcessManager.list_all),
-            loop.run_in_executor(None, kernel.NetworkMonitor.listening_ports),
-        )
+        # One GIL-released call gathers cpu, memory, disk and listeners
+        snap = await kasync.snapshot()
+        cpu, mem, disk, listeners = snap.cpu, snap.memory, snap.disk, snap.listening
 
         # ── CPU check ────────────────────────────────────────────────
         if cpu.usage_percent >= self.cpu_crit:
@@ -183,9 +344,16 @@ class HealthMonitor:
                 Severity.CRITICAL, "cpu", "CPU critically high",
                 f"CPU at {cpu.usage_percent:.0f}% (threshold: {self.cpu_crit}%)",
             )
+            top_desc = "unknown"
+            if self._procs is not None:
+                # Events keep membership current; CPU% needs a fresh sample.
+                await kasync.diff(self._procs)
+                top = self._procs.top_by_cpu(5)
+                top_desc = ", ".join(f"{p.name} (pid {p.pid}, {p.cpu_percent:.0f}%)" for p in top)
             await self._maybe_auto_heal(alert,
                 f"CRITICAL: CPU usage is at {cpu.usage_percent:.0f}%. "
                 f"Load averages: {cpu.load_1m:.1f}, {cpu.load_5m:.1f}, {cpu.load_15m:.1f}. "
+                f"Top CPU consumers: {top_desc}. "
                 f"Investigate which processes are consuming CPU and suggest actions to reduce load."
             )
         elif cpu.usage_percent >= self.cpu_warn:
@@ -223,8 +391,15 @@ class HealthMonitor:
                 Severity.CRITICAL, "disk", "Disk critically full",
                 f"Disk at {disk.usage_percent:.0f}% ({round(disk.used_bytes / 1e9, 1)}GB / {round(disk.total_bytes / 1e9, 1)}GB)",
             )
+            heaviest = ""
+            if self.auto_heal and not alert.auto_healed:
+                # Hand the agent the breakdown up front instead of having it run du
+                usage = await kasync.disk_usage("/", 8, 3)
+                heaviest = " Largest directories: " + ", ".join(
+                    f"{d.path} ({round(d.allocated_bytes / 1e9, 1)}GB)" for d in usage.top
+                ) + "."
             await self._maybe_auto_heal(alert,
-                f"CRITICAL: Disk usage is at {disk.usage_percent:.0f}%. "
+                f"CRITICAL: Disk usage is at {disk.usage_percent:.0f}%.{heaviest} "
                 f"Find large files and directories consuming disk space and suggest cleanup actions."
             )
         elif disk.usage_percent >= self.disk_warn:
@@ -237,30 +412,46 @@ class HealthMonitor:
             self._resolve_alerts("disk", "Disk space low")
 
         # ── Zombie process check ─────────────────────────────────────
-        zombies = [p for p in procs if p.state == 'Z']
-        if len(zombies) > 3:
-            alert = self._add_alert(
-                Severity.WARNING, "process", "Zombie processes detected",
-                f"{len(zombies)} zombie processes found",
-            )
-            await self._maybe_auto_heal(alert,
-                f"WARNING: {len(zombies)} zombie processes detected. "
-                f"Investigate their parent processes and clean them up."
-            )
-        else:
-            self._resolve_alerts("process", "Zombie processes detected")
+        # Also run on exit events; here it catches zombies that were reaped.
+        await self._check_zombies(kernel)
+
+        # ── Interface drop/error rates ───────────────────────────────
+        if self._ifaces is None:
+            self._ifaces = kernel.InterfaceSampler()
+        rates = await kasync.sample(self._ifaces)
+        dropping: set[str] = set()
+        for r in rates:
+            if r.interval_sec <= 0:
+                continue  # first sighting, no rate yet
+            drops = r.rx_dropped_per_sec + r.tx_dropped_per_sec
+            errors = r.rx_errors_per_sec + r.tx_errors_per_sec
+            if drops + errors >= self.net_drop_warn:
+                dropping.add(r.name)
+                self._add_alert(
+                    Severity.WARNING, "network", f"Packet loss on {r.name}",
+                    f"{r.name}: {drops:.0f} drops/s, {errors:.0f} errors/s "
+                    f"(rx {r.rx_bytes_per_sec / 1e6:.1f} MB/s, tx {r.tx_bytes_per_sec / 1e6:.1f} MB/s)",
+                )
+        for name in self._dropping - dropping:
+            self._resolve_alerts("network", f"Packet loss on {name}")
+        self._dropping = dropping
 
         # ── New listening port detection ─────────────────────────────
         current_ports = {p.local_port for p in listeners}
         if self._initial_scan_done:
             new_ports = current_ports - self._known_listeners
+            if new_ports and self._sockets is not None:
+                listeners = await kasync.annotate(self._sockets, listeners)
             for port in new_ports:
                 matching = [p for p in listeners if p.local_port == port]
                 proto = matching[0].protocol if matching else "unknown"
                 addr = matching[0].local_addr if matching else "?"
+                owner = ""
+                if matching and matching[0].pid:
+                    owner = f" owned by {matching[0].process_name} (pid {matching[0].pid})"
                 self._add_alert(
                     Severity.INFO, "network", f"New port {port} opened",
-                    f"New {proto} listener on {addr}:{port}",
+                    f"New {proto} listener on {addr}:{port}{owner}",
                 )
         self._known_listeners = current_ports
         self._initial_scan_done = True
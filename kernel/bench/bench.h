@@ -0,0 +1,123 @@
+#pragma once
+
+// Minimal timing harness shared by the kernel microbenchmarks, and the
+// suite registry of agent_kernel_bench.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace agent_kernel::bench {
+
+struct Result {
+    std::string name;
+    int iterations;
+    double mean_us;
+    double p50_us;
+    double min_us;
+    double max_us;
+    double p90_us = 0.0;
+    double items_per_second = 0.0;   // 0 when the case has no item count
+};
+
+/// Run `fn` once to warm caches, then `iterations` timed runs.
+template <typename Fn>
+Result run(const std::string& name, int iterations, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    fn();
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = clock::now();
+        fn();
+        auto t1 = clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result r{name, iterations, 0.0, 0.0, 0.0, 0.0};
+    if (samples.empty()) return r;
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    r.mean_us = sum / static_cast<double>(samples.size());
+    r.p50_us = samples[samples.size() / 2];
+    r.p90_us = samples[samples.size() * 9 / 10];
+    r.min_us = samples.front();
+    r.max_us = samples.back();
+    return r;
+}
+
+inline void print(const Result& r) {
+    std::printf("%-40s %6d iters  mean %10.1f us  p50 %10.1f us  min %10.1f us  max %10.1f us",
+                r.name.c_str(), r.iterations, r.mean_us, r.p50_us, r.min_us, r.max_us);
+    if (r.items_per_second > 0) std::printf("  %12.0f items/s", r.items_per_second);
+    std::printf("\n");
+}
+
+/// Selects, times and collects the cases of agent_kernel_bench. Case names
+/// are "<suite>/<case>"; the filter is an ECMAScript regex searched in them.
+class Runner {
+public:
+    Runner(const std::string& filter, double scale, bool quiet)
+        : filter_(filter), scale_(scale), quiet_(quiet) {}
+
+    /// Time `fn` as bench::run() does, with `iterations` multiplied by the
+    /// scale. `items` is the work one call does (rows parsed, events
+    /// delivered), reported as a rate derived from the mean.
+    template <typename Fn>
+    void run(const std::string& name, int iterations, Fn&& fn, double items = 0) {
+        std::string full = suite_ + "/" + name;
+        if (!selected(full)) return;
+        int n = std::max(1, static_cast<int>(iterations * scale_));
+        Result r = bench::run(full, n, fn);
+        if (items > 0 && r.mean_us > 0) r.items_per_second = items * 1e6 / r.mean_us;
+        if (!quiet_) print(r);
+        results_.push_back(std::move(r));
+    }
+
+    /// Whether any of `case_names` in the current suite passes the filter;
+    /// lets a suite skip building fixtures no selected case uses.
+    bool wants(std::initializer_list<const char*> case_names) const {
+        for (const char* name : case_names) {
+            if (selected(suite_ + "/" + name)) return true;
+        }
+        return false;
+    }
+
+    void begin_suite(const std::string& suite) { suite_ = suite; }
+    const std::vector<Result>& results() const { return results_; }
+
+private:
+    bool selected(const std::string& full) const { return std::regex_search(full, filter_); }
+
+    std::regex filter_;
+    double scale_;
+    bool quiet_;
+    std::string suite_;
+    std::vector<Result> results_;
+};
+
+using SuiteFn = void (*)(Runner&);
+
+struct Suite {
+    const char* name;
+    SuiteFn fn;
+};
+
+inline std::vector<Suite>& suites() {
+    static std::vector<Suite> all;
+    return all;
+}
+
+/// Adds a suite to agent_kernel_bench; define one per suite file at
+/// namespace scope. Suites run in name order.
+struct Registration {
+    Registration(const char* name, SuiteFn fn) { suites().push_back({name, fn}); }
+};
+
+} // namespace agent_kernel::bench
@@ -0,0 +1,127 @@
+// agent_kernel_bench: every registered suite (bench/suites/*.cpp) in one
+// binary, with JSON output for bench/compare.py.
+//
+//   agent_kernel_bench [--filter REGEX] [--scale X] [--json FILE|-] [--list]
+//
+// --filter selects cases by "<suite>/<case>" name, --scale multiplies every
+// case's iteration count, and --json writes the results ("-" for stdout,
+// which silences the table). --list prints the suite names.
+
+#include "bench.h"
+#include "agent_kernel/thread_pool.h"
+
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+
+using namespace agent_kernel;
+
+namespace {
+
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+void write_json(std::FILE* f, const std::vector<bench::Result>& results) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    struct utsname uts {};
+    uname(&uts);
+
+    std::fprintf(f, "{\n  \"context\": {\n");
+    std::fprintf(f, "    \"date\": %s,\n", json_string(date).c_str());
+    std::fprintf(f, "    \"host\": %s,\n", json_string(uts.nodename).c_str());
+    std::fprintf(f, "    \"kernel\": %s,\n", json_string(uts.release).c_str());
+    std::fprintf(f, "    \"cpus\": %u,\n", usable_cpus());
+    std::fprintf(f, "    \"compiler\": %s\n", json_string(__VERSION__).c_str());
+    std::fprintf(f, "  },\n  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::fprintf(f, "%s\n    {\"name\": %s, \"iterations\": %d, \"mean_us\": %.3f, \"p50_us\": %.3f, "
+                        "\"p90_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f, \"items_per_second\": %.1f}",
+                     i ? "," : "", json_string(r.name).c_str(), r.iterations, r.mean_us, r.p50_us,
+                     r.p90_us, r.min_us, r.max_us, r.items_per_second);
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string json;
+    double scale = 1.0;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--scale") && i + 1 < argc) scale = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) json = argv[++i];
+        else if (!std::strcmp(argv[i], "--list")) list = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--filter REGEX] [--scale X] [--json FILE|-] [--list]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    auto& suites = bench::suites();
+    std::sort(suites.begin(), suites.end(),
+              [](const bench::Suite& a, const bench::Suite& b) { return std::strcmp(a.name, b.name) < 0; });
+    if (list) {
+        for (const auto& s : suites) std::printf("%s\n", s.name);
+        return 0;
+    }
+
+    std::unique_ptr<bench::Runner> runner;
+    try {
+        runner = std::make_unique<bench::Runner>(filter, scale > 0 ? scale : 1.0, json == "-");
+    } catch (const std::regex_error& e) {
+        std::fprintf(stderr, "bad --filter: %s\n", e.what());
+        return 2;
+    }
+
+    int failed = 0;
+    for (const auto& s : suites) {
+        runner->begin_suite(s.name);
+        try {
+            s.fn(*runner);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: %s\n", s.name, e.what());
+            ++failed;
+        }
+    }
+
+    if (!json.empty()) {
+        std::FILE* f = json == "-" ? stdout : std::fopen(json.c_str(), "w");
+        if (!f) {
+            std::fprintf(stderr, "cannot write %s: %s\n", json.c_str(), strerror(errno));
+            return 1;
+        }
+        write_json(f, runner->results());
+        if (f != stdout) std::fclose(f);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Compare two agent_kernel_bench --json runs.
+
+    compare.py baseline.json current.json [--threshold 10] [--metric p50_us]
+
+Prints every case present in both runs with its change, and exits 1 if any
+got slower than the threshold (in percent) allows. Cases only in one run are
+listed but never fail the comparison.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import sys
+from typing import Any
+
+
+def load(path: str) -> tuple[dict[str, Any], dict[str, dict[str, Any]]]:
+    with open(path) as f:
+        data = json.load(f)
+    return data.get("context", {}), {b["name"]: b for b in data.get("benchmarks", [])}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default 10)")
+    parser.add_argument("--metric", default="p50_us",
+                        choices=["p50_us", "p90_us", "mean_us", "min_us"],
+                        help="latency to compare (default p50_us)")
+    args = parser.parse_args()
+
+    base_ctx, base = load(args.baseline)
+    cur_ctx, cur = load(args.current)
+    for key in ("host", "cpus", "kernel", "compiler"):
+        if base_ctx.get(key) != cur_ctx.get(key):
+            print(f"note: {key} differs: {base_ctx.get(key)} -> {cur_ctx.get(key)}")
+
+    regressions = []
+    width = max((len(n) for n in base.keys() | cur.keys()), default=10)
+    print(f"{'case':<{width}}  {'baseline':>12}  {'current':>12}  {'change':>8}")
+    for name in sorted(base.keys() | cur.keys()):
+        if name not in cur or name not in base:
+            where = "baseline" if name in base else "current"
+            print(f"{name:<{width}}  (only in {where})")
+            continue
+        old, new = base[name][args.metric], cur[name][args.metric]
+        change = (new - old) / old * 100.0 if old > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        print(f"{name:<{width}}  {old:>10.1f}us  {new:>10.1f}us  {change:>+7.1f}%{flag}")
+
+    if regressions:
+        print(f"\n{len(regressions)} case(s) slower than {args.threshold:g}%: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
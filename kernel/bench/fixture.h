@@ -0,0 +1,96 @@
+#pragma once
+
+// Synthetic on-disk fixtures for the kernel benchmarks, created under /tmp
+// and removed by the caller.
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace agent_kernel::bench {
+
+inline void write_file(const std::string& path, const std::string& content) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("cannot create " + path);
+    if (::write(fd, content.data(), content.size()) != static_cast<ssize_t>(content.size())) {
+        ::close(fd);
+        throw std::runtime_error("short write to " + path);
+    }
+    ::close(fd);
+}
+
+/// Fresh directory /tmp/agent_kernel_<tag>_XXXXXX.
+inline std::string make_temp_dir(const std::string& tag) {
+    std::string tmpl = "/tmp/agent_kernel_" + tag + "_XXXXXX";
+    if (!mkdtemp(&tmpl[0])) throw std::runtime_error("mkdtemp failed");
+    return tmpl;
+}
+
+inline int remove_entry(const char* path, const struct stat*, int, struct FTW*) {
+    return ::remove(path);
+}
+
+inline void remove_tree(const std::string& root) {
+    nftw(root.c_str(), remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+/// A proc root with `count` processes (stat and cmdline only), parented
+/// four to a node so tree() has depth.
+inline std::string make_proc_fixture(int count) {
+    std::string root = make_temp_dir("procfix");
+    for (int i = 0; i < count; ++i) {
+        int pid = 100 + i;
+        std::string dir = root + "/" + std::to_string(pid);
+        mkdir(dir.c_str(), 0755);
+
+        std::string stat = std::to_string(pid) + " (worker-" + std::to_string(i % 1000) + ") S " +
+            std::to_string(i > 0 ? 100 + (i - 1) / 4 : 1) +
+            " 100 100 0 -1 4194560 2451 0 12 0 " + std::to_string(i % 500) + " 37 0 0 20 0 1 0 " +
+            std::to_string(5000 + i) + " 183500800 " + std::to_string(1024 + i % 4096) +
+            " 18446744073709551615 1 1 0 0 0 0 0 4096 17000 0 0 0 17 0 0 0 0 0 0\n";
+        write_file(dir + "/stat", stat);
+
+        std::string cmd = "/usr/bin/worker";
+        cmd.push_back('\0');
+        cmd += "--shard=" + std::to_string(i);
+        cmd.push_back('\0');
+        cmd += "--config=/etc/worker/worker.conf";
+        cmd.push_back('\0');
+        write_file(dir + "/cmdline", cmd);
+    }
+    return root;
+}
+
+/// `dirs` directories of `files_per_dir` files each, nested `depth` deep
+/// (d0/d1/...), with names ending in .log, .txt and .cpp in turn. Each file
+/// holds `file_bytes` of text lines.
+inline std::string make_file_tree(int dirs, int files_per_dir, int depth, size_t file_bytes) {
+    static const char* kExt[] = {".log", ".txt", ".cpp"};
+    std::string root = make_temp_dir("filefix");
+    std::string line = "2024-01-01T00:00:00Z worker started shard processing batch\n";
+    std::string body;
+    while (body.size() < file_bytes) body += line;
+    body.resize(file_bytes);
+
+    for (int d = 0; d < dirs; ++d) {
+        std::string dir = root;
+        for (int level = 0; level < depth; ++level) {
+            dir += "/d" + std::to_string((d >> (level * 3)) % 8) + "_" + std::to_string(level);
+            mkdir(dir.c_str(), 0755);
+        }
+        dir += "/leaf" + std::to_string(d);
+        mkdir(dir.c_str(), 0755);
+        for (int f = 0; f < files_per_dir; ++f) {
+            write_file(dir + "/file" + std::to_string(f) + kExt[f % 3], body);
+        }
+    }
+    return root;
+}
+
+} // namespace agent_kernel::bench
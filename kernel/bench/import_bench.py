@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Cold-start and per-call overhead of the agent_kernel Python module.
+
+    import_bench.py [--path DIR] [--runs 30] [--calls 20000] [--json FILE]
+
+Imports the module in --runs fresh interpreters (from DIR when given,
+otherwise from sys.path), then times a few cheap calls in this one. The
+JSON has the agent_kernel_bench layout, so two builds can be diffed with
+compare.py; the context adds the module's size and exported symbol count.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+from typing import Any, Callable
+
+IMPORT_SNIPPET = (
+    "import sys, time\n"
+    "if {path!r}: sys.path.insert(0, {path!r})\n"
+    "t = time.perf_counter()\n"
+    "import agent_kernel\n"
+    "print(time.perf_counter() - t)\n"
+)
+
+
+def summarize(name: str, samples_us: list[float]) -> dict[str, Any]:
+    s = sorted(samples_us)
+    return {
+        "name": name,
+        "iterations": len(s),
+        "mean_us": statistics.fmean(s),
+        "p50_us": s[len(s) // 2],
+        "p90_us": s[len(s) * 9 // 10],
+        "min_us": s[0],
+        "max_us": s[-1],
+        "items_per_second": 0.0,
+    }
+
+
+def time_import(path: str, runs: int) -> dict[str, Any]:
+    code = IMPORT_SNIPPET.format(path=path)
+    samples = []
+    for _ in range(runs):
+        out = subprocess.run([sys.executable, "-c", code], check=True, capture_output=True, text=True)
+        samples.append(float(out.stdout) * 1e6)
+    return summarize("python/import", samples)
+
+
+def time_call(name: str, fn: Callable[[], Any], calls: int, batches: int = 50) -> dict[str, Any]:
+    per_batch = max(1, calls // batches)
+    fn()
+    samples = []
+    for _ in range(batches):
+        t = time.perf_counter()
+        for _ in range(per_batch):
+            fn()
+        samples.append((time.perf_counter() - t) * 1e6 / per_batch)
+    return summarize(f"python/{name}", samples)
+
+
+def exported_symbols(so_path: str) -> int:
+    nm = shutil.which("nm")
+    if not nm:
+        return -1
+    out = subprocess.run([nm, "-D", "--defined-only", so_path], capture_output=True, text=True)
+    return len(out.stdout.splitlines()) if out.returncode == 0 else -1
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--path", default="", help="directory holding the agent_kernel module to test")
+    parser.add_argument("--runs", type=int, default=30, help="fresh-interpreter imports (default 30)")
+    parser.add_argument("--calls", type=int, default=20000, help="calls per timed function (default 20000)")
+    parser.add_argument("--json", help="write results here ('-' for stdout)")
+    args = parser.parse_args()
+
+    if args.path:
+        sys.path.insert(0, args.path)
+    import agent_kernel  # type: ignore
+
+    results = [time_import(args.path, args.runs)]
+    pid = os.getpid()
+    calls = [
+        ("send_signal_0", lambda: agent_kernel.ProcessManager.send_signal(pid, 0)),
+        ("get_info_self", lambda: agent_kernel.ProcessManager.get_info(pid)),
+        ("memory", agent_kernel.SystemMetrics.memory),
+        ("cgroup_location", agent_kernel.CgroupManager.location),
+    ]
+    for name, fn in calls:
+        results.append(time_call(name, fn, args.calls))
+
+    so_path = agent_kernel.__file__
+    context = {
+        "date": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        "host": platform.node(),
+        "kernel": platform.release(),
+        "cpus": os.cpu_count(),
+        "python": platform.python_version(),
+        "module": so_path,
+        "build_profile": getattr(agent_kernel, "build_profile", "unknown"),
+        "module_bytes": os.path.getsize(so_path),
+        "exported_symbols": exported_symbols(so_path),
+    }
+
+    if args.json != "-":
+        print(f"{so_path} ({context['build_profile']}): {context['module_bytes']} bytes, "
+              f"{context['exported_symbols']} exported symbols")
+        for r in results:
+            print(f"{r['name']:<28} {r['iterations']:6d} samples  p50 {r['p50_us']:10.2f} us  "
+                  f"min {r['min_us']:10.2f} us  max {r['max_us']:10.2f} us")
+    if args.json:
+        doc = json.dumps({"context": context, "benchmarks": results}, indent=2)
+        if args.json == "-":
+            print(doc)
+        else:
+            with open(args.json, "w") as f:
+                f.write(doc + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
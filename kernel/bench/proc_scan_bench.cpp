@@ -0,0 +1,132 @@
+// Compares the ProcScanner /proc reader against the original
+// ifstream/istringstream parser on a synthetic proc tree.
+//
+//   agent_kernel_bench_proc [--procs N] [--iterations N] [--system]
+
+#include "bench.h"
+#include "fixture.h"
+#include "agent_kernel/proc_scanner.h"
+#include "agent_kernel/thread_pool.h"
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace agent_kernel;
+
+namespace {
+
+// ── Original implementation, parameterized on the proc root ──────────
+
+std::string legacy_read_file(const std::string& path) {
+    std::ifstream f(path);
+    if (!f.is_open()) return {};
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+ProcessInfo legacy_parse_proc(const std::string& root, pid_t pid) {
+    ProcessInfo info{};
+    info.pid = pid;
+
+    std::string stat_content = legacy_read_file(root + "/" + std::to_string(pid) + "/stat");
+    if (stat_content.empty()) {
+        info.name = "?";
+        return info;
+    }
+
+    auto open = stat_content.find('(');
+    auto close = stat_content.rfind(')');
+    if (open != std::string::npos && close != std::string::npos && close > open) {
+        info.name = stat_content.substr(open + 1, close - open - 1);
+    }
+
+    std::istringstream rest(stat_content.substr(close + 2));
+    std::string field;
+    rest >> field; info.state = field.empty() ? '?' : field[0];
+    rest >> info.ppid;
+    for (int i = 5; i <= 22; ++i) rest >> field;
+    uint64_t vsize_bytes = 0, rss_pages = 0;
+    rest >> vsize_bytes >> rss_pages;
+    info.vsize_kb = vsize_bytes / 1024;
+    info.rss_kb = (rss_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE))) / 1024;
+    info.cpu_percent = 0.0;
+
+    std::string cmdline = legacy_read_file(root + "/" + std::to_string(pid) + "/cmdline");
+    for (auto& c : cmdline) {
+        if (c == '\0') c = ' ';
+    }
+    if (!cmdline.empty() && cmdline.back() == ' ') cmdline.pop_back();
+    info.cmdline = cmdline.empty() ? ("[" + info.name + "]") : cmdline;
+
+    struct stat proc_stat;
+    std::string proc_path = root + "/" + std::to_string(pid);
+    if (::stat(proc_path.c_str(), &proc_stat) == 0) {
+        info.uid = proc_stat.st_uid;
+    }
+    return info;
+}
+
+std::vector<ProcessInfo> legacy_list_all(const std::string& root) {
+    std::vector<ProcessInfo> procs;
+    DIR* dir = opendir(root.c_str());
+    if (!dir) return procs;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        const char* n = entry->d_name;
+        if (*n < '0' || *n > '9') continue;
+        procs.push_back(legacy_parse_proc(root, static_cast<pid_t>(std::atoi(n))));
+    }
+    closedir(dir);
+    return procs;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    int procs = 10000;
+    int iterations = 20;
+    bool system = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--procs") && i + 1 < argc) procs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--system")) system = true;
+    }
+
+    std::string root = bench::make_proc_fixture(procs);
+    std::printf("fixture: %s (%d processes)\n", root.c_str(), procs);
+
+    {
+        ProcScanner scanner(root);
+        size_t legacy_n = 0, scanner_n = 0, parallel_n = 0;
+        bench::print(bench::run("legacy ifstream list_all", iterations,
+                                [&] { legacy_n = legacy_list_all(root).size(); }));
+        bench::print(bench::run("ProcScanner::scan", iterations,
+                                [&] { scanner_n = scanner.scan().size(); }));
+        auto& pool = ThreadPool::shared();
+        bench::print(bench::run("ProcScanner::scan (" + std::to_string(pool.size()) + " workers)",
+                                iterations,
+                                [&] { parallel_n = scanner.scan(pool).size(); }));
+        if (legacy_n != scanner_n || scanner_n != parallel_n) {
+            std::fprintf(stderr, "mismatch: legacy=%zu scanner=%zu parallel=%zu\n",
+                         legacy_n, scanner_n, parallel_n);
+        }
+    }
+
+    if (system) {
+        bench::print(bench::run("legacy ifstream list_all (/proc)", iterations,
+                                [&] { legacy_list_all("/proc"); }));
+        bench::print(bench::run("ProcScanner::scan (/proc)", iterations,
+                                [&] { ProcScanner::system().scan(); }));
+    }
+
+    bench::remove_tree(root);
+    return 0;
+}
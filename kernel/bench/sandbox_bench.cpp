@@ -0,0 +1,163 @@
+// Round-trip latency of a trivial command through the original
+// two-reader-thread / 50 ms waitpid-polling executor versus the epoll one,
+// the SandboxPool workers, and fork() versus spawn_process() with an
+// inflated parent RSS.
+//
+//   agent_kernel_bench_sandbox [--iterations N] [--batch N] [--rss-mb N]
+
+#include "bench.h"
+#include "agent_kernel/sandbox.h"
+#include "agent_kernel/sandbox_pool.h"
+#include "agent_kernel/spawn.h"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace agent_kernel;
+
+namespace {
+
+// ── Original implementation (limits/env handling omitted) ────────────
+
+std::string legacy_read_pipe(int fd) {
+    std::string result;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        result.append(buf, static_cast<size_t>(n));
+    }
+    return result;
+}
+
+ExecutionResult legacy_run_with_timeout(const std::string& command, int timeout_seconds) {
+    int stdout_pipe[2], stderr_pipe[2];
+    if (pipe(stdout_pipe) != 0 || pipe(stderr_pipe) != 0) {
+        throw std::runtime_error(std::string("pipe failed: ") + strerror(errno));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error(std::string("fork failed: ") + strerror(errno));
+    if (pid == 0) {
+        close(stdout_pipe[0]);
+        close(stderr_pipe[0]);
+        dup2(stdout_pipe[1], STDOUT_FILENO);
+        dup2(stderr_pipe[1], STDERR_FILENO);
+        close(stdout_pipe[1]);
+        close(stderr_pipe[1]);
+        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
+        _exit(127);
+    }
+    close(stdout_pipe[1]);
+    close(stderr_pipe[1]);
+
+    std::string out_str, err_str;
+    std::thread t_out([&]{ out_str = legacy_read_pipe(stdout_pipe[0]); });
+    std::thread t_err([&]{ err_str = legacy_read_pipe(stderr_pipe[0]); });
+
+    ExecutionResult result{};
+    int status = 0;
+    if (timeout_seconds > 0) {
+        auto deadline = start + std::chrono::seconds(timeout_seconds);
+        bool exited = false;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (waitpid(pid, &status, WNOHANG) > 0) {
+                exited = true;
+                result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!exited) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            result.timed_out = true;
+            result.exit_code = -1;
+        }
+    } else {
+        waitpid(pid, &status, 0);
+        result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    t_out.join();
+    t_err.join();
+    close(stdout_pipe[0]);
+    close(stderr_pipe[0]);
+    result.stdout_output = std::move(out_str);
+    result.stderr_output = std::move(err_str);
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+pid_t legacy_fork_spawn(const std::string& command) {
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error(std::string("fork failed: ") + strerror(errno));
+    if (pid == 0) {
+        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
+        _exit(127);
+    }
+    return pid;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    int iterations = 200;
+    int batch = 16;
+    int rss_mb = 1024;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) batch = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--rss-mb") && i + 1 < argc) rss_mb = std::atoi(argv[++i]);
+    }
+
+    SandboxPolicy policy;
+    policy.working_dir.clear();
+
+    bench::print(bench::run("legacy run (no timeout)", iterations,
+                            [&] { legacy_run_with_timeout("true", 0); }));
+    bench::print(bench::run("legacy run_with_timeout", iterations,
+                            [&] { legacy_run_with_timeout("true", 30); }));
+    bench::print(bench::run("Sandbox::run", iterations,
+                            [&] { Sandbox::run("true", policy); }));
+    bench::print(bench::run("Sandbox::run_with_timeout", iterations,
+                            [&] { Sandbox::run_with_timeout("true", 30, policy); }));
+
+    std::vector<std::string> commands(static_cast<size_t>(batch), "true");
+    int batch_iterations = std::max(1, iterations / batch);
+    bench::print(bench::run("legacy x" + std::to_string(batch) + " sequential", batch_iterations, [&] {
+        for (const auto& c : commands) legacy_run_with_timeout(c, 30);
+    }));
+    bench::print(bench::run("Sandbox::run_batch x" + std::to_string(batch), batch_iterations,
+                            [&] { Sandbox::run_batch(commands, 30, policy); }));
+
+    {
+        SandboxPool pool(policy, 2, 1000);
+        bench::print(bench::run("SandboxPool::run", iterations, [&] { pool.run("true"); }));
+        bench::print(bench::run("SandboxPool::run_with_timeout", iterations, [&] { pool.run("true", 30); }));
+    }
+
+    // Touch the ballast so fork() has real page tables to copy.
+    size_t ballast_size = static_cast<size_t>(rss_mb) << 20;
+    std::unique_ptr<char[]> ballast(new char[ballast_size]);
+    std::memset(ballast.get(), 1, ballast_size);
+
+    SpawnOptions options;
+    options.path = "/bin/sh";
+    options.argv = {"sh", "-c", "true"};
+    std::string suffix = " (" + std::to_string(rss_mb) + " MB RSS)";
+    bench::print(bench::run("fork+exec+wait" + suffix, iterations,
+                            [&] { waitpid(legacy_fork_spawn("true"), nullptr, 0); }));
+    bench::print(bench::run("spawn_process+wait" + suffix, iterations,
+                            [&] { waitpid(spawn_process(options), nullptr, 0); }));
+    return 0;
+}
@@ -0,0 +1,56 @@
+// FileUtils search, du, tail and grep on a generated tree of ~10k files.
+
+#include "../bench.h"
+#include "../fixture.h"
+#include "agent_kernel/disk_usage.h"
+#include "agent_kernel/file_utils.h"
+
+#include <string>
+
+using namespace agent_kernel;
+
+namespace {
+
+constexpr int kDirs = 256;
+constexpr int kFilesPerDir = 40;
+constexpr int kFiles = kDirs * kFilesPerDir;
+constexpr size_t kLogBytes = 16 << 20;
+
+void run_files(bench::Runner& bench) {
+    if (!bench.wants({"search_names", "search_with_size", "search_first_200", "dir_size_cold",
+                      "dir_size_cached", "grep_literal_miss", "tail_50", "tail_1000"})) {
+        return;
+    }
+    std::string root = bench::make_file_tree(kDirs, kFilesPerDir, 3, 2048);
+
+    bench.run("search_names", 50, [&] { FileUtils::search(root, "*.log", 10, kFiles, false); }, kFiles);
+    bench.run("search_with_size", 50, [&] { FileUtils::search(root, "*.log", 10, kFiles, true); }, kFiles);
+    bench.run("search_first_200", 200, [&] { FileUtils::search(root, "*.log"); });
+
+    bench.run("dir_size_cold", 20, [&] {
+        DiskUsage::shared().clear();
+        FileUtils::dir_size(root);
+    }, kFiles);
+    bench.run("dir_size_cached", 200, [&] { FileUtils::dir_size(root); }, kFiles);
+
+    // A literal no file contains: every byte is scanned, nothing is reported.
+    bench.run("grep_literal_miss", 10, [&] { FileUtils::grep(root, "cache miss"); }, kFiles);
+
+    if (bench.wants({"tail_50", "tail_1000"})) {
+        std::string log = root + "/big.log";
+        std::string body;
+        for (int i = 0; body.size() < kLogBytes; ++i) {
+            body += "2024-01-01T00:00:00Z request " + std::to_string(i) + " served in 12ms\n";
+        }
+        bench::write_file(log, body);
+        bench.run("tail_50", 2000, [&] { FileUtils::tail(log, 50); });
+        bench.run("tail_1000", 2000, [&] { FileUtils::tail(log, 1000); });
+    }
+
+    DiskUsage::shared().clear();
+    bench::remove_tree(root);
+}
+
+const bench::Registration kRegistration("files", run_files);
+
+} // anonymous namespace
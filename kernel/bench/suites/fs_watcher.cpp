@@ -0,0 +1,66 @@
+// FSWatcher event throughput: create and delete a batch of files in a
+// watched directory and poll until every event has been delivered.
+
+#include "../bench.h"
+#include "../fixture.h"
+#include "agent_kernel/fs_watcher.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace agent_kernel;
+
+namespace {
+
+constexpr int kFiles = 1000;
+
+// Poll until `want` events of `type` arrived; gives up after a second of silence.
+void drain(FSWatcher& watcher, std::vector<FSEvent>& events, FSEventType type, int want) {
+    int seen = 0;
+    while (seen < want) {
+        if (watcher.poll_into(events, 1000) == 0) {
+            std::fprintf(stderr, "fs_watcher: %d of %d events arrived\n", seen, want);
+            return;
+        }
+        for (const auto& ev : events) seen += ev.type == type;
+    }
+}
+
+void run_cycle(FSWatcher& watcher, std::vector<FSEvent>& events, const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) ::close(fd);
+    }
+    drain(watcher, events, FSEventType::Created, kFiles);
+    for (const auto& path : paths) ::unlink(path.c_str());
+    drain(watcher, events, FSEventType::Deleted, kFiles);
+}
+
+void run_fs_watcher(bench::Runner& bench) {
+    if (!bench.wants({"create_delete", "create_delete_recursive"})) return;
+    std::string dir = bench::make_temp_dir("watchfix");
+    std::vector<std::string> paths;
+    for (int i = 0; i < kFiles; ++i) paths.push_back(dir + "/f" + std::to_string(i));
+    std::vector<FSEvent> events;
+
+    {
+        FSWatcher watcher;
+        watcher.watch(dir);
+        bench.run("create_delete", 20, [&] { run_cycle(watcher, events, paths); }, 2 * kFiles);
+    }
+    {
+        FSWatcher watcher;
+        watcher.watch(dir, static_cast<uint32_t>(FSEventType::All), true);
+        bench.run("create_delete_recursive", 20, [&] { run_cycle(watcher, events, paths); }, 2 * kFiles);
+    }
+
+    bench::remove_tree(dir);
+}
+
+const bench::Registration kRegistration("fs_watcher", run_fs_watcher);
+
+} // anonymous namespace
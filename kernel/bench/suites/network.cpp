@@ -0,0 +1,58 @@
+// The /proc/net parser on synthetic 100k-row tcp and tcp6 tables.
+
+#include "../bench.h"
+#include "../fixture.h"
+#include "agent_kernel/network.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace agent_kernel;
+
+namespace {
+
+constexpr int kRows = 100000;
+
+const char kHeader[] =
+    "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+
+// A mix of ESTABLISHED, LISTEN and TIME_WAIT rows.
+const char* const kStates[] = {"01", "0A", "06"};
+
+std::string make_table(bool v6) {
+    std::string table = kHeader;
+    char row[256];
+    for (int i = 0; i < kRows; ++i) {
+        const char* st = kStates[i % 3];
+        int n;
+        if (v6) {
+            n = std::snprintf(row, sizeof(row),
+                "%6d: 0000000000000000FFFF00000100007F:%04X 0000000000000000FFFF0000%08X:%04X %s "
+                "00000000:00000000 00:00000000 00000000  1000        0 %d 1 0000000000000000 20 4 30 10 -1\n",
+                i, 8000 + i % 1000, 0x0A000000 + i, 1024 + i % 60000, st, 100000 + i);
+        } else {
+            n = std::snprintf(row, sizeof(row),
+                "%6d: 0100007F:%04X %08X:%04X %s "
+                "00000000:00000000 00:00000000 00000000  1000        0 %d 1 0000000000000000 20 4 30 10 -1\n",
+                i, 8000 + i % 1000, 0x0A000000 + i, 1024 + i % 60000, st, 100000 + i);
+        }
+        table.append(row, static_cast<size_t>(n));
+    }
+    return table;
+}
+
+void run_network(bench::Runner& bench) {
+    if (!bench.wants({"parse_tcp", "parse_tcp6"})) return;
+    std::string dir = bench::make_temp_dir("netfix");
+    bench::write_file(dir + "/tcp", make_table(false));
+    bench::write_file(dir + "/tcp6", make_table(true));
+
+    bench.run("parse_tcp", 20, [&] { NetworkMonitor::parse_table(dir + "/tcp", "tcp"); }, kRows);
+    bench.run("parse_tcp6", 20, [&] { NetworkMonitor::parse_table(dir + "/tcp6", "tcp6"); }, kRows);
+
+    bench::remove_tree(dir);
+}
+
+const bench::Registration kRegistration("network", run_network);
+
+} // anonymous namespace
@@ -0,0 +1,34 @@
+// ProcessManager listing and tree building on the live /proc, and
+// ProcScanner on a synthetic proc root of known size.
+
+#include "../bench.h"
+#include "../fixture.h"
+#include "agent_kernel/process.h"
+#include "agent_kernel/proc_scanner.h"
+#include "agent_kernel/thread_pool.h"
+
+using namespace agent_kernel;
+
+namespace {
+
+constexpr int kSyntheticProcs = 5000;
+
+void run_process(bench::Runner& bench) {
+    bench.run("list_all", 200, [] { ProcessManager::list_all(); });
+    bench.run("list_all_parallel", 200, [] { ProcessManager::list_all(true); });
+    bench.run("list_columns", 200, [] { ProcessManager::list_columns(); });
+    bench.run("tree", 200, [] { ProcessManager::tree(); });
+
+    if (!bench.wants({"scan_synthetic", "scan_synthetic_parallel"})) return;
+    std::string root = bench::make_proc_fixture(kSyntheticProcs);
+    {
+        ProcScanner scanner(root);
+        bench.run("scan_synthetic", 20, [&] { scanner.scan(); }, kSyntheticProcs);
+        bench.run("scan_synthetic_parallel", 20, [&] { scanner.scan(ThreadPool::shared()); }, kSyntheticProcs);
+    }
+    bench::remove_tree(root);
+}
+
+const bench::Registration kRegistration("process", run_process);
+
+} // anonymous namespace
@@ -0,0 +1,33 @@
+// Round-trip latency of a trivial command through each executor.
+
+#include "../bench.h"
+#include "agent_kernel/sandbox.h"
+#include "agent_kernel/sandbox_pool.h"
+
+#include <string>
+#include <vector>
+
+using namespace agent_kernel;
+
+namespace {
+
+constexpr int kBatch = 8;
+
+void run_sandbox(bench::Runner& bench) {
+    SandboxPolicy policy;
+    policy.working_dir.clear();
+
+    bench.run("run", 100, [&] { Sandbox::run("true", policy); });
+    bench.run("run_with_timeout", 100, [&] { Sandbox::run_with_timeout("true", 30, policy); });
+
+    std::vector<std::string> commands(kBatch, "true");
+    bench.run("run_batch_x8", 20, [&] { Sandbox::run_batch(commands, 30, policy); }, kBatch);
+
+    if (!bench.wants({"pool_run"})) return;
+    SandboxPool pool(policy, 2, 1000);
+    bench.run("pool_run", 200, [&] { pool.run("true", 30); });
+}
+
+const bench::Registration kRegistration("sandbox", run_sandbox);
+
+} // anonymous namespace
@@ -2,18 +2,191 @@
 #include <pybind11/stl.h>
 
 #include "agent_kernel/metrics.h"
+#include "agent_kernel/metrics_collector.h"
 #include "agent_kernel/process.h"
+#include "agent_kernel/process_sampler.h"
+#include "agent_kernel/process_table.h"
+#include "agent_kernel/process_events.h"
 #include "agent_kernel/fs_watcher.h"
 #include "agent_kernel/sandbox.h"
+#include "agent_kernel/sandbox_pool.h"
 #include "agent_kernel/network.h"
+#include "agent_kernel/interface_sampler.h"
+#include "agent_kernel/socket_owner.h"
 #include "agent_kernel/cgroup.h"
+#include "agent_kernel/cgroup_watcher.h"
 #include "agent_kernel/file_utils.h"
+#include "agent_kernel/disk_usage.h"
+#include "agent_kernel/file_index.h"
+#include "agent_kernel/tail_follower.h"
+#include "agent_kernel/completion_queue.h"
+#include "agent_kernel/stats.h"
+
+// Set by CMake, e.g. "Release lto pgo=use" or "Release lto march=x86-64-v3".
+#ifndef AGENT_KERNEL_BUILD_PROFILE
+#define AGENT_KERNEL_BUILD_PROFILE "unknown"
+#endif
 
 namespace py = pybind11;
 using namespace agent_kernel;
 
+namespace {
+
+// Read-only buffer over one array of a column set. `owner` keeps the set
+// alive for as long as a memoryview or NumPy array still points into it.
+struct ColumnView {
+    std::shared_ptr<const void> owner;
+    const void* data;
+    py::ssize_t rows;
+    py::ssize_t cols;   // 0 for a 1-D column
+    py::ssize_t itemsize;
+    std::string format;
+};
+
+struct StringColumnView {
+    std::shared_ptr<const void> owner;
+    const StringColumn* column;
+};
+
+struct InternedColumnView {
+    std::shared_ptr<const void> owner;
+    const InternedColumn* column;
+};
+
+template <typename T>
+ColumnView column_view(std::shared_ptr<const void> owner, const std::vector<T>& v,
+                       size_t rows, size_t cols = 0) {
+    return {std::move(owner), v.data(), static_cast<py::ssize_t>(rows), static_cast<py::ssize_t>(cols),
+            static_cast<py::ssize_t>(sizeof(T)), py::format_descriptor<T>::format()};
+}
+
+// Column sets are handed to Python by shared_ptr so views can share ownership.
+template <typename Owner, typename T>
+void def_column(py::class_<Owner, std::shared_ptr<Owner>>& cls, const char* name, std::vector<T> Owner::*member) {
+    cls.def_property_readonly(name, [member](std::shared_ptr<Owner> self) {
+        const auto& v = (*self).*member;
+        return column_view(self, v, v.size());
+    });
+}
+
+template <typename Owner>
+void def_column(py::class_<Owner, std::shared_ptr<Owner>>& cls, const char* name, StringColumn Owner::*member) {
+    cls.def_property_readonly(name, [member](std::shared_ptr<Owner> self) {
+        return StringColumnView{self, &((*self).*member)};
+    });
+}
+
+template <typename Owner>
+void def_column(py::class_<Owner, std::shared_ptr<Owner>>& cls, const char* name, InternedColumn Owner::*member) {
+    cls.def_property_readonly(name, [member](std::shared_ptr<Owner> self) {
+        return InternedColumnView{self, &((*self).*member)};
+    });
+}
+
+size_t check_index(py::ssize_t i, size_t size) {
+    if (i < 0) i += static_cast<py::ssize_t>(size);
+    if (i < 0 || static_cast<size_t>(i) >= size) throw py::index_error();
+    return static_cast<size_t>(i);
+}
+
+// cmdlines are not guaranteed to be UTF-8
+py::str to_str(std::string_view s) {
+    PyObject* obj = PyUnicode_DecodeUTF8(s.data(), static_cast<Py_ssize_t>(s.size()), "replace");
+    if (!obj) throw py::error_already_set();
+    return py::reinterpret_steal<py::str>(obj);
+}
+
+template <typename Column>
+py::list to_list(const Column& c) {
+    py::list out(c.size());
+    for (size_t i = 0; i < c.size(); ++i) out[i] = to_str(c.at(i));
+    return out;
+}
+
+// Run fn() on the queue's workers without the GIL, then call
+// done(result, None) or done(None, RuntimeError) from run_completions() on
+// the loop thread. `keep` is only released there, so an object fn points
+// into outlives the work.
+template <typename Fn>
+void submit_async(CompletionQueue& q, py::function done, Fn fn, py::object keep = py::none()) {
+    using Result = decltype(fn());
+    struct Slot {
+        std::optional<Result> value;
+        std::string error;
+    };
+    auto slot = std::make_shared<Slot>();
+    q.submit(
+        [slot, fn]() mutable {
+            try {
+                slot->value.emplace(fn());
+            } catch (const std::exception& e) {
+                slot->error = e.what();
+            } catch (...) {
+                slot->error = "unknown error";
+            }
+        },
+        [slot, done = std::move(done), keep = std::move(keep)]() {
+            try {
+                if (slot->value) {
+                    done(py::cast(std::move(*slot->value)), py::none());
+                } else {
+                    done(py::none(), py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(slot->error));
+                }
+            } catch (py::error_already_set& e) {
+                e.restore();
+                PyErr_WriteUnraisable(done.ptr());
+            }
+        });
+}
+
+// The Python wrapper already owning `obj`, to hold it across async work.
+template <typename T>
+py::object owner_of(T& obj) {
+    return py::cast(&obj, py::return_value_policy::reference);
+}
+
+} // anonymous namespace
+
 PYBIND11_MODULE(agent_kernel, m) {
     m.doc() = "MuchovhaOS C++ kernel runtime — process management, filesystem watching, sandboxing, system metrics, networking, cgroups, file utilities";
+    m.attr("build_profile") = AGENT_KERNEL_BUILD_PROFILE;
+
+    // ── Columnar Exports ────────────────────────────────────────────────
+
+    py::class_<ColumnView>(m, "Column", py::buffer_protocol())
+        .def_buffer([](ColumnView& c) {
+            if (c.cols == 0) {
+                return py::buffer_info(const_cast<void*>(c.data), c.itemsize, c.format, 1,
+                                       {c.rows}, {c.itemsize}, true);
+            }
+            return py::buffer_info(const_cast<void*>(c.data), c.itemsize, c.format, 2,
+                                   {c.rows, c.cols}, {c.itemsize * c.cols, c.itemsize}, true);
+        })
+        .def("__len__", [](const ColumnView& c) { return c.rows; });
+
+    py::class_<StringColumnView>(m, "StringColumn")
+        .def("__len__", [](const StringColumnView& v) { return v.column->size(); })
+        .def("__getitem__", [](const StringColumnView& v, py::ssize_t i) {
+            return to_str(v.column->at(check_index(i, v.column->size())));
+        })
+        .def("tolist", [](const StringColumnView& v) { return to_list(*v.column); })
+        .def_property_readonly("bytes", [](const StringColumnView& v) {
+            return column_view(v.owner, v.column->bytes, v.column->bytes.size());
+        })
+        .def_property_readonly("offsets", [](const StringColumnView& v) {
+            return column_view(v.owner, v.column->offsets, v.column->offsets.size());
+        });
+
+    py::class_<InternedColumnView>(m, "InternedColumn")
+        .def("__len__", [](const InternedColumnView& v) { return v.column->size(); })
+        .def("__getitem__", [](const InternedColumnView& v, py::ssize_t i) {
+            return to_str(v.column->at(check_index(i, v.column->size())));
+        })
+        .def("tolist", [](const InternedColumnView& v) { return to_list(*v.column); })
+        .def_property_readonly("codes", [](const InternedColumnView& v) {
+            return column_view(v.owner, v.column->codes, v.column->codes.size());
+        })
+        .def_property_readonly("values", [](const InternedColumnView& v) { return to_list(v.column->values); });
 
     // ── Metrics ─────────────────────────────────────────────────────────
 
@@ -39,11 +212,76 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readonly("available_bytes", &DiskInfo::available_bytes)
         .def_readonly("usage_percent", &DiskInfo::usage_percent);
 
+    py::class_<SystemSnapshot>(m, "SystemSnapshot")
+        .def_readonly("cpu", &SystemSnapshot::cpu)
+        .def_readonly("memory", &SystemSnapshot::memory)
+        .def_readonly("disk", &SystemSnapshot::disk)
+        .def_readonly("listening", &SystemSnapshot::listening)
+        .def_readonly("procs_running", &SystemSnapshot::procs_running)
+        .def_readonly("procs_blocked", &SystemSnapshot::procs_blocked)
+        .def_readonly("threads_total", &SystemSnapshot::threads_total);
+
     py::class_<SystemMetrics>(m, "SystemMetrics")
         .def_static("cpu", &SystemMetrics::cpu, py::call_guard<py::gil_scoped_release>())
         .def_static("memory", &SystemMetrics::memory, py::call_guard<py::gil_scoped_release>())
         .def_static("disk", &SystemMetrics::disk, py::arg("path") = "/", py::call_guard<py::gil_scoped_release>())
-        .def_static("all_disks", &SystemMetrics::all_disks, py::call_guard<py::gil_scoped_release>());
+        .def_static("all_disks", &SystemMetrics::all_disks, py::call_guard<py::gil_scoped_release>())
+        .def_static("snapshot", &SystemMetrics::snapshot, py::arg("disk_path") = "/",
+                    py::call_guard<py::gil_scoped_release>());
+
+    py::class_<MetricsSample>(m, "MetricsSample")
+        .def_readonly("timestamp_ms", &MetricsSample::timestamp_ms)
+        .def_readonly("cpu_percent", &MetricsSample::cpu_percent)
+        .def_readonly("core_count", &MetricsSample::core_count)
+        .def_property_readonly("core_percent", [](const MetricsSample& s) {
+            return std::vector<float>(s.core_percent, s.core_percent + s.core_count);
+        })
+        .def_readonly("load_1m", &MetricsSample::load_1m)
+        .def_readonly("load_5m", &MetricsSample::load_5m)
+        .def_readonly("load_15m", &MetricsSample::load_15m)
+        .def_readonly("mem_total_kb", &MetricsSample::mem_total_kb)
+        .def_readonly("mem_available_kb", &MetricsSample::mem_available_kb)
+        .def_readonly("swap_used_kb", &MetricsSample::swap_used_kb)
+        .def_readonly("disk_total_bytes", &MetricsSample::disk_total_bytes)
+        .def_readonly("disk_used_bytes", &MetricsSample::disk_used_bytes)
+        .def_readonly("net_rx_bytes_per_sec", &MetricsSample::net_rx_bytes_per_sec)
+        .def_readonly("net_tx_bytes_per_sec", &MetricsSample::net_tx_bytes_per_sec)
+        .def_readonly("cgroup_memory_bytes", &MetricsSample::cgroup_memory_bytes)
+        .def_readonly("cgroup_cpu_percent", &MetricsSample::cgroup_cpu_percent);
+
+    py::class_<MetricsColumns, std::shared_ptr<MetricsColumns>> metrics_columns(m, "MetricsColumns");
+    metrics_columns
+        .def("__len__", &MetricsColumns::size)
+        .def_readonly("cores", &MetricsColumns::cores)
+        .def_property_readonly("core_percent", [](std::shared_ptr<MetricsColumns> self) {
+            return column_view(self, self->core_percent, self->size(), self->cores);
+        });
+    def_column(metrics_columns, "timestamp_ms", &MetricsColumns::timestamp_ms);
+    def_column(metrics_columns, "cpu_percent", &MetricsColumns::cpu_percent);
+    def_column(metrics_columns, "load_1m", &MetricsColumns::load_1m);
+    def_column(metrics_columns, "load_5m", &MetricsColumns::load_5m);
+    def_column(metrics_columns, "load_15m", &MetricsColumns::load_15m);
+    def_column(metrics_columns, "mem_total_kb", &MetricsColumns::mem_total_kb);
+    def_column(metrics_columns, "mem_available_kb", &MetricsColumns::mem_available_kb);
+    def_column(metrics_columns, "swap_used_kb", &MetricsColumns::swap_used_kb);
+    def_column(metrics_columns, "disk_used_bytes", &MetricsColumns::disk_used_bytes);
+    def_column(metrics_columns, "net_rx_bytes_per_sec", &MetricsColumns::net_rx_bytes_per_sec);
+    def_column(metrics_columns, "net_tx_bytes_per_sec", &MetricsColumns::net_tx_bytes_per_sec);
+    def_column(metrics_columns, "cgroup_memory_bytes", &MetricsColumns::cgroup_memory_bytes);
+    def_column(metrics_columns, "cgroup_cpu_percent", &MetricsColumns::cgroup_cpu_percent);
+
+    py::class_<MetricsCollector>(m, "MetricsCollector")
+        .def(py::init<int, size_t, const std::string&>(),
+             py::arg("interval_ms") = 1000, py::arg("capacity") = 600, py::arg("disk_path") = "/")
+        .def("start", &MetricsCollector::start)
+        .def("stop", &MetricsCollector::stop, py::call_guard<py::gil_scoped_release>())
+        .def("running", &MetricsCollector::running)
+        .def("latest", &MetricsCollector::latest)
+        .def("history", &MetricsCollector::history, py::arg("n") = 600)
+        .def("since", &MetricsCollector::since, py::arg("timestamp_ms"))
+        .def("columns", &MetricsCollector::columns, py::arg("n") = 600)
+        .def("capacity", &MetricsCollector::capacity)
+        .def("interval_ms", &MetricsCollector::interval_ms);
 
     // ── Process Management ──────────────────────────────────────────────
 
@@ -56,7 +294,8 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readonly("vsize_kb", &ProcessInfo::vsize_kb)
         .def_readonly("cpu_percent", &ProcessInfo::cpu_percent)
         .def_readonly("cmdline", &ProcessInfo::cmdline)
-        .def_readonly("uid", &ProcessInfo::uid);
+        .def_readonly("uid", &ProcessInfo::uid)
+        .def_readonly("start_time", &ProcessInfo::start_time);
 
     py::class_<ProcessTreeNode>(m, "ProcessTreeNode")
         .def_readonly("info", &ProcessTreeNode::info)
@@ -70,15 +309,80 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readwrite("max_open_files", &ResourceLimits::max_open_files)
         .def_readwrite("max_processes", &ResourceLimits::max_processes);
 
+    py::class_<ProcessColumns, std::shared_ptr<ProcessColumns>> process_columns(m, "ProcessColumns");
+    process_columns.def("__len__", &ProcessColumns::size);
+    def_column(process_columns, "pid", &ProcessColumns::pid);
+    def_column(process_columns, "ppid", &ProcessColumns::ppid);
+    def_column(process_columns, "uid", &ProcessColumns::uid);
+    def_column(process_columns, "state", &ProcessColumns::state);
+    def_column(process_columns, "rss_kb", &ProcessColumns::rss_kb);
+    def_column(process_columns, "vsize_kb", &ProcessColumns::vsize_kb);
+    def_column(process_columns, "start_time", &ProcessColumns::start_time);
+    def_column(process_columns, "cpu_percent", &ProcessColumns::cpu_percent);
+    def_column(process_columns, "name", &ProcessColumns::name);
+    def_column(process_columns, "cmdline", &ProcessColumns::cmdline);
+
     py::class_<ProcessManager>(m, "ProcessManager")
-        .def_static("list_all", &ProcessManager::list_all, py::call_guard<py::gil_scoped_release>())
+        .def_static("list_all", &ProcessManager::list_all, py::arg("parallel") = false,
+                     py::call_guard<py::gil_scoped_release>())
+        .def_static("list_columns", &ProcessManager::list_columns, py::arg("parallel") = false,
+                     py::call_guard<py::gil_scoped_release>())
         .def_static("get_info", &ProcessManager::get_info, py::arg("pid"), py::call_guard<py::gil_scoped_release>())
         .def_static("send_signal", &ProcessManager::send_signal, py::arg("pid"), py::arg("signal"))
         .def_static("spawn", &ProcessManager::spawn, py::arg("command"), py::arg("limits") = ResourceLimits{},
                      py::call_guard<py::gil_scoped_release>())
-        .def_static("tree", &ProcessManager::tree, py::call_guard<py::gil_scoped_release>())
+        .def_static("tree", py::overload_cast<bool>(&ProcessManager::tree), py::arg("parallel") = false,
+                     py::call_guard<py::gil_scoped_release>())
+        .def_static("tree", py::overload_cast<pid_t>(&ProcessManager::tree), py::arg("root_pid"),
+                     py::call_guard<py::gil_scoped_release>())
         .def_static("children", &ProcessManager::children, py::arg("pid"), py::call_guard<py::gil_scoped_release>());
 
+    py::class_<ProcessSampler>(m, "ProcessSampler")
+        .def(py::init<>())
+        .def("sample", &ProcessSampler::sample, py::call_guard<py::gil_scoped_release>())
+        .def("tracked", &ProcessSampler::tracked);
+
+    py::class_<ProcessDelta>(m, "ProcessDelta")
+        .def_readonly("spawned", &ProcessDelta::spawned)
+        .def_readonly("changed", &ProcessDelta::changed)
+        .def_readonly("exited", &ProcessDelta::exited)
+        .def_readonly("execed", &ProcessDelta::execed);
+
+    py::class_<ProcessTable>(m, "ProcessTable")
+        .def(py::init<>())
+        .def("diff", &ProcessTable::diff, py::call_guard<py::gil_scoped_release>())
+        .def("size", &ProcessTable::size)
+        .def("state_counts", &ProcessTable::state_counts)
+        .def("count_state", &ProcessTable::count_state, py::arg("state"))
+        .def("top_by_rss", &ProcessTable::top_by_rss, py::arg("n") = 10)
+        .def("top_by_cpu", &ProcessTable::top_by_cpu, py::arg("n") = 10)
+        .def("snapshot", &ProcessTable::snapshot, py::call_guard<py::gil_scoped_release>())
+        .def("columns", &ProcessTable::columns, py::call_guard<py::gil_scoped_release>());
+
+    py::enum_<ProcEventType>(m, "ProcEventType")
+        .value("Fork", ProcEventType::Fork)
+        .value("Exec", ProcEventType::Exec)
+        .value("Exit", ProcEventType::Exit);
+
+    py::class_<ProcEvent>(m, "ProcEvent")
+        .def_readonly("type", &ProcEvent::type)
+        .def_readonly("pid", &ProcEvent::pid)
+        .def_readonly("ppid", &ProcEvent::ppid)
+        .def_readonly("exit_code", &ProcEvent::exit_code);
+
+    py::class_<ProcessEventStream> proc_stream(m, "ProcessEventStream");
+    py::enum_<ProcessEventStream::Mode>(proc_stream, "Mode")
+        .value("Netlink", ProcessEventStream::Mode::Netlink)
+        .value("Polling", ProcessEventStream::Mode::Polling);
+    proc_stream
+        .def(py::init<ProcessTable&, int>(), py::arg("table"), py::arg("rescan_interval_ms") = 1000,
+             py::keep_alive<1, 2>(), py::call_guard<py::gil_scoped_release>())
+        .def("mode", &ProcessEventStream::mode)
+        .def("track", &ProcessEventStream::track, py::arg("pid"))
+        .def("poll", &ProcessEventStream::poll, py::arg("timeout_ms") = 100,
+             py::call_guard<py::gil_scoped_release>())
+        .def("fd", &ProcessEventStream::fd);
+
     // ── Filesystem Watcher ──────────────────────────────────────────────
 
     py::enum_<FSEventType>(m, "FSEventType")
@@ -86,16 +390,21 @@ PYBIND11_MODULE(agent_kernel, m) {
         .value("Modified", FSEventType::Modified)
         .value("Deleted", FSEventType::Deleted)
         .value("Moved", FSEventType::Moved)
-        .value("All", FSEventType::All);
+        .value("All", FSEventType::All)
+        .value("Overflow", FSEventType::Overflow);
 
     py::class_<FSEvent>(m, "FSEvent")
         .def_readonly("type", &FSEvent::type)
         .def_readonly("path", &FSEvent::path)
-        .def_readonly("name", &FSEvent::name);
+        .def_readonly("name", &FSEvent::name)
+        .def_readonly("is_dir", &FSEvent::is_dir);
 
     py::class_<FSWatcher>(m, "FSWatcher")
-        .def(py::init<>())
-        .def("watch", &FSWatcher::watch, py::arg("path"), py::arg("mask") = static_cast<uint32_t>(FSEventType::All))
+        .def(py::init<int>(), py::arg("debounce_ms") = 0)
+        .def("watch", &FSWatcher::watch, py::arg("path"), py::arg("mask") = static_cast<uint32_t>(FSEventType::All),
+             py::arg("recursive") = false, py::call_guard<py::gil_scoped_release>())
+        .def("watch_mount", &FSWatcher::watch_mount,
+             py::arg("path"), py::arg("mask") = static_cast<uint32_t>(FSEventType::All))
         .def("unwatch", &FSWatcher::unwatch, py::arg("wd"))
         .def("poll", &FSWatcher::poll, py::arg("timeout_ms") = 100, py::call_guard<py::gil_scoped_release>())
         .def("watch_count", &FSWatcher::watch_count);
@@ -108,21 +417,71 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readwrite("working_dir", &SandboxPolicy::working_dir)
         .def_readwrite("env", &SandboxPolicy::env)
         .def_readwrite("drop_privileges", &SandboxPolicy::drop_privileges)
-        .def_readwrite("restrict_network", &SandboxPolicy::restrict_network);
+        .def_readwrite("restrict_network", &SandboxPolicy::restrict_network)
+        .def_readwrite("use_cgroup", &SandboxPolicy::use_cgroup)
+        .def_readwrite("cpu_cores", &SandboxPolicy::cpu_cores)
+        .def_readwrite("output_head_bytes", &SandboxPolicy::output_head_bytes)
+        .def_readwrite("output_tail_bytes", &SandboxPolicy::output_tail_bytes);
 
     py::class_<ExecutionResult>(m, "ExecutionResult")
         .def_readonly("exit_code", &ExecutionResult::exit_code)
         .def_readonly("stdout_output", &ExecutionResult::stdout_output)
         .def_readonly("stderr_output", &ExecutionResult::stderr_output)
         .def_readonly("elapsed_seconds", &ExecutionResult::elapsed_seconds)
-        .def_readonly("timed_out", &ExecutionResult::timed_out);
+        .def_readonly("timed_out", &ExecutionResult::timed_out)
+        .def_readonly("truncated", &ExecutionResult::truncated)
+        .def_readonly("memory_peak_bytes", &ExecutionResult::memory_peak_bytes)
+        .def_readonly("cpu_usage_usec", &ExecutionResult::cpu_usage_usec)
+        .def_readonly("cpu_throttled_usec", &ExecutionResult::cpu_throttled_usec)
+        .def_readonly("term_signal", &ExecutionResult::term_signal)
+        .def_readonly("user_cpu_seconds", &ExecutionResult::user_cpu_seconds)
+        .def_readonly("sys_cpu_seconds", &ExecutionResult::sys_cpu_seconds)
+        .def_readonly("max_rss_kb", &ExecutionResult::max_rss_kb)
+        .def_readonly("minor_faults", &ExecutionResult::minor_faults)
+        .def_readonly("major_faults", &ExecutionResult::major_faults)
+        .def_readonly("voluntary_switches", &ExecutionResult::voluntary_switches)
+        .def_readonly("involuntary_switches", &ExecutionResult::involuntary_switches);
 
     py::class_<Sandbox>(m, "Sandbox")
         .def_static("run", &Sandbox::run, py::arg("command"), py::arg("policy") = SandboxPolicy{},
                      py::call_guard<py::gil_scoped_release>())
         .def_static("run_with_timeout", &Sandbox::run_with_timeout,
                      py::arg("command"), py::arg("timeout_seconds"), py::arg("policy") = SandboxPolicy{},
-                     py::call_guard<py::gil_scoped_release>());
+                     py::call_guard<py::gil_scoped_release>())
+        .def_static("run_batch", &Sandbox::run_batch,
+                     py::arg("commands"), py::arg("timeout_seconds") = 0, py::arg("policy") = SandboxPolicy{},
+                     py::call_guard<py::gil_scoped_release>())
+        .def_static("run_streaming",
+                     [](const std::string& command, int timeout_seconds, const py::function& on_output,
+                        const SandboxPolicy& policy) {
+                         // on_output(stream, chunk: bytes), called with the GIL held per chunk
+                         OutputCallback cb = [&on_output](int stream, const char* data, size_t size) {
+                             py::gil_scoped_acquire gil;
+                             on_output(stream, py::bytes(data, size));
+                         };
+                         py::gil_scoped_release release;
+                         return Sandbox::run_streaming(command, timeout_seconds, cb, policy);
+                     },
+                     py::arg("command"), py::arg("timeout_seconds"), py::arg("on_output"),
+                     py::arg("policy") = SandboxPolicy{});
+
+    py::class_<SandboxPool>(m, "SandboxPool")
+        .def(py::init<const SandboxPolicy&, size_t, size_t>(),
+             py::arg("policy") = SandboxPolicy{}, py::arg("workers") = 2, py::arg("max_uses") = 100)
+        .def("run", &SandboxPool::run, py::arg("command"), py::arg("timeout_seconds") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("run_streaming",
+             [](SandboxPool& pool, const std::string& command, int timeout_seconds, const py::function& on_output) {
+                 OutputCallback cb = [&on_output](int stream, const char* data, size_t size) {
+                     py::gil_scoped_acquire gil;
+                     on_output(stream, py::bytes(data, size));
+                 };
+                 py::gil_scoped_release release;
+                 return pool.run_streaming(command, timeout_seconds, cb);
+             },
+             py::arg("command"), py::arg("timeout_seconds"), py::arg("on_output"))
+        .def("size", &SandboxPool::size)
+        .def("max_uses", &SandboxPool::max_uses);
 
     // ── Network Monitor ─────────────────────────────────────────────────
 
@@ -134,7 +493,24 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readonly("remote_port", &ConnectionInfo::remote_port)
         .def_readonly("state", &ConnectionInfo::state)
         .def_readonly("uid", &ConnectionInfo::uid)
-        .def_readonly("inode", &ConnectionInfo::inode);
+        .def_readonly("inode", &ConnectionInfo::inode)
+        .def_readonly("rtt_us", &ConnectionInfo::rtt_us)
+        .def_readonly("retransmits", &ConnectionInfo::retransmits)
+        .def_readonly("bytes_acked", &ConnectionInfo::bytes_acked)
+        .def_readonly("bytes_received", &ConnectionInfo::bytes_received)
+        .def_readonly("pid", &ConnectionInfo::pid)
+        .def_readonly("process_name", &ConnectionInfo::process_name);
+
+    py::class_<ConnectionColumns, std::shared_ptr<ConnectionColumns>> connection_columns(m, "ConnectionColumns");
+    connection_columns.def("__len__", &ConnectionColumns::size);
+    def_column(connection_columns, "protocol", &ConnectionColumns::protocol);
+    def_column(connection_columns, "local_addr", &ConnectionColumns::local_addr);
+    def_column(connection_columns, "local_port", &ConnectionColumns::local_port);
+    def_column(connection_columns, "remote_addr", &ConnectionColumns::remote_addr);
+    def_column(connection_columns, "remote_port", &ConnectionColumns::remote_port);
+    def_column(connection_columns, "state", &ConnectionColumns::state);
+    def_column(connection_columns, "uid", &ConnectionColumns::uid);
+    def_column(connection_columns, "inode", &ConnectionColumns::inode);
 
     py::class_<InterfaceStats>(m, "InterfaceStats")
         .def_readonly("name", &InterfaceStats::name)
@@ -149,12 +525,66 @@ PYBIND11_MODULE(agent_kernel, m) {
 
     py::class_<NetworkMonitor>(m, "NetworkMonitor")
         .def_static("connections", &NetworkMonitor::connections, py::arg("protocol") = "tcp",
+                     py::arg("tcp_info") = false, py::call_guard<py::gil_scoped_release>())
+        .def_static("connections_in_state", &NetworkMonitor::connections_in_state, py::arg("protocol"),
+                     py::arg("states"), py::arg("tcp_info") = false, py::call_guard<py::gil_scoped_release>())
+        .def_static("connection_columns", &NetworkMonitor::connection_columns, py::arg("protocol") = "all",
                      py::call_guard<py::gil_scoped_release>())
         .def_static("listening_ports", &NetworkMonitor::listening_ports,
                      py::call_guard<py::gil_scoped_release>())
+        .def_static("backend", &NetworkMonitor::backend)
+        .def_static("parse_table", &NetworkMonitor::parse_table,
+                     py::arg("path"), py::arg("protocol") = "tcp",
+                     py::call_guard<py::gil_scoped_release>())
         .def_static("interfaces", &NetworkMonitor::interfaces,
                      py::call_guard<py::gil_scoped_release>());
 
+    py::class_<InterfaceRates>(m, "InterfaceRates")
+        .def_readonly("name", &InterfaceRates::name)
+        .def_readonly("up", &InterfaceRates::up)
+        .def_readonly("loopback", &InterfaceRates::loopback)
+        .def_readonly("interval_sec", &InterfaceRates::interval_sec)
+        .def_readonly("rx_bytes_per_sec", &InterfaceRates::rx_bytes_per_sec)
+        .def_readonly("tx_bytes_per_sec", &InterfaceRates::tx_bytes_per_sec)
+        .def_readonly("rx_packets_per_sec", &InterfaceRates::rx_packets_per_sec)
+        .def_readonly("tx_packets_per_sec", &InterfaceRates::tx_packets_per_sec)
+        .def_readonly("rx_errors_per_sec", &InterfaceRates::rx_errors_per_sec)
+        .def_readonly("tx_errors_per_sec", &InterfaceRates::tx_errors_per_sec)
+        .def_readonly("rx_dropped_per_sec", &InterfaceRates::rx_dropped_per_sec)
+        .def_readonly("tx_dropped_per_sec", &InterfaceRates::tx_dropped_per_sec)
+        .def_readonly("totals", &InterfaceRates::totals);
+
+    py::class_<InterfaceSampler>(m, "InterfaceSampler")
+        .def(py::init<>())
+        .def("sample", &InterfaceSampler::sample, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SocketOwner>(m, "SocketOwner")
+        .def_readonly("pid", &SocketOwner::pid)
+        .def_readonly("name", &SocketOwner::name);
+
+    py::class_<SocketOwnerIndex>(m, "SocketOwnerIndex")
+        .def(py::init<int>(), py::arg("full_rescan_interval_ms") = 5000)
+        .def("rebuild", &SocketOwnerIndex::rebuild, py::call_guard<py::gil_scoped_release>())
+        .def("apply", py::overload_cast<const ProcessDelta&>(&SocketOwnerIndex::apply), py::arg("delta"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("apply", py::overload_cast<const std::vector<ProcEvent>&>(&SocketOwnerIndex::apply),
+             py::arg("events"), py::call_guard<py::gil_scoped_release>())
+        .def("refresh", &SocketOwnerIndex::refresh, py::arg("pids"), py::call_guard<py::gil_scoped_release>())
+        .def("lookup", [](const SocketOwnerIndex& idx, uint64_t inode) -> std::optional<SocketOwner> {
+            SocketOwner owner;
+            if (!idx.lookup(inode, owner)) return std::nullopt;
+            return owner;
+        }, py::arg("inode"))
+        // Lists are converted by value, so hand back the annotated copy
+        .def("annotate", [](SocketOwnerIndex& idx, std::vector<ConnectionInfo> conns) {
+            {
+                py::gil_scoped_release release;
+                idx.annotate(conns);
+            }
+            return conns;
+        }, py::arg("connections"))
+        .def("size", &SocketOwnerIndex::size);
+
     // ── Cgroup / Container ──────────────────────────────────────────────
 
     py::class_<CgroupInfo>(m, "CgroupInfo")
@@ -162,13 +592,70 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readonly("is_containerized", &CgroupInfo::is_containerized)
         .def_readonly("memory_limit_bytes", &CgroupInfo::memory_limit_bytes)
         .def_readonly("memory_usage_bytes", &CgroupInfo::memory_usage_bytes)
+        .def_readonly("memory_anon_bytes", &CgroupInfo::memory_anon_bytes)
+        .def_readonly("memory_file_bytes", &CgroupInfo::memory_file_bytes)
         .def_readonly("cpu_quota", &CgroupInfo::cpu_quota)
+        .def_readonly("cpu_usage_usec", &CgroupInfo::cpu_usage_usec)
+        .def_readonly("cpu_nr_periods", &CgroupInfo::cpu_nr_periods)
+        .def_readonly("cpu_nr_throttled", &CgroupInfo::cpu_nr_throttled)
+        .def_readonly("cpu_throttled_usec", &CgroupInfo::cpu_throttled_usec)
+        .def_readonly("io_read_bytes", &CgroupInfo::io_read_bytes)
+        .def_readonly("io_write_bytes", &CgroupInfo::io_write_bytes)
+        .def_readonly("io_read_ops", &CgroupInfo::io_read_ops)
+        .def_readonly("io_write_ops", &CgroupInfo::io_write_ops)
         .def_readonly("pids_limit", &CgroupInfo::pids_limit)
         .def_readonly("pids_current", &CgroupInfo::pids_current);
 
+    py::class_<CgroupLocation>(m, "CgroupLocation")
+        .def_readonly("version", &CgroupLocation::version)
+        .def_readonly("unified", &CgroupLocation::unified)
+        .def_readonly("memory", &CgroupLocation::memory)
+        .def_readonly("cpu", &CgroupLocation::cpu)
+        .def_readonly("cpuacct", &CgroupLocation::cpuacct)
+        .def_readonly("pids", &CgroupLocation::pids)
+        .def_readonly("io", &CgroupLocation::io);
+
     py::class_<CgroupManager>(m, "CgroupManager")
         .def_static("info", &CgroupManager::info, py::call_guard<py::gil_scoped_release>())
-        .def_static("is_in_container", &CgroupManager::is_in_container, py::call_guard<py::gil_scoped_release>());
+        .def_static("is_in_container", &CgroupManager::is_in_container, py::call_guard<py::gil_scoped_release>())
+        .def_static("location", &CgroupManager::location, py::return_value_policy::reference,
+                    py::call_guard<py::gil_scoped_release>());
+
+    py::enum_<CgroupEventType>(m, "CgroupEventType")
+        .value("MemoryPressure", CgroupEventType::MemoryPressure)
+        .value("CpuPressure", CgroupEventType::CpuPressure)
+        .value("IoPressure", CgroupEventType::IoPressure)
+        .value("MemoryEvents", CgroupEventType::MemoryEvents)
+        .value("CpuThrottled", CgroupEventType::CpuThrottled);
+
+    py::class_<PressureStats>(m, "PressureStats")
+        .def_readonly("some_avg10", &PressureStats::some_avg10)
+        .def_readonly("some_avg60", &PressureStats::some_avg60)
+        .def_readonly("full_avg10", &PressureStats::full_avg10)
+        .def_readonly("full_avg60", &PressureStats::full_avg60)
+        .def_readonly("some_total_us", &PressureStats::some_total_us)
+        .def_readonly("full_total_us", &PressureStats::full_total_us);
+
+    py::class_<CgroupEvent>(m, "CgroupEvent")
+        .def_readonly("type", &CgroupEvent::type)
+        .def_readonly("timestamp_ms", &CgroupEvent::timestamp_ms)
+        .def_readonly("pressure", &CgroupEvent::pressure)
+        .def_readonly("memory_high", &CgroupEvent::memory_high)
+        .def_readonly("memory_max", &CgroupEvent::memory_max)
+        .def_readonly("oom", &CgroupEvent::oom)
+        .def_readonly("oom_kill", &CgroupEvent::oom_kill)
+        .def_readonly("nr_throttled", &CgroupEvent::nr_throttled)
+        .def_readonly("throttled_usec", &CgroupEvent::throttled_usec);
+
+    py::class_<CgroupWatcher>(m, "CgroupWatcher")
+        .def(py::init<const std::string&>(), py::arg("cgroup_dir") = "")
+        .def("add_pressure_trigger", &CgroupWatcher::add_pressure_trigger, py::arg("resource"),
+             py::arg("stall_us"), py::arg("window_us"), py::arg("full") = false)
+        .def("watch_memory_events", &CgroupWatcher::watch_memory_events)
+        .def("watch_cpu_throttling", &CgroupWatcher::watch_cpu_throttling, py::arg("interval_ms") = 1000)
+        .def("poll", &CgroupWatcher::poll, py::arg("timeout_ms") = 1000, py::call_guard<py::gil_scoped_release>())
+        .def("fd", &CgroupWatcher::fd)
+        .def("path", &CgroupWatcher::path);
 
     // ── File Utilities ──────────────────────────────────────────────────
 
@@ -177,15 +664,248 @@ PYBIND11_MODULE(agent_kernel, m) {
         .def_readonly("size", &FileSearchResult::size)
         .def_readonly("is_dir", &FileSearchResult::is_dir);
 
+    py::class_<GrepOptions>(m, "GrepOptions")
+        .def(py::init<>())
+        .def_readwrite("regex", &GrepOptions::regex)
+        .def_readwrite("ignore_case", &GrepOptions::ignore_case)
+        .def_readwrite("context", &GrepOptions::context)
+        .def_readwrite("max_depth", &GrepOptions::max_depth)
+        .def_readwrite("include", &GrepOptions::include)
+        .def_readwrite("skip_dirs", &GrepOptions::skip_dirs)
+        .def_readwrite("max_matches", &GrepOptions::max_matches)
+        .def_readwrite("max_bytes", &GrepOptions::max_bytes)
+        .def_readwrite("max_line_length", &GrepOptions::max_line_length)
+        .def_readwrite("max_file_size", &GrepOptions::max_file_size);
+
+    py::class_<GrepMatch>(m, "GrepMatch")
+        .def_readonly("path", &GrepMatch::path)
+        .def_readonly("line", &GrepMatch::line)
+        .def_property_readonly("text", [](const GrepMatch& g) { return to_str(g.text); })
+        .def_property_readonly("before", [](const GrepMatch& g) { return to_list(g.before); })
+        .def_property_readonly("after", [](const GrepMatch& g) { return to_list(g.after); });
+
+    py::class_<GrepResult>(m, "GrepResult")
+        .def_readonly("matches", &GrepResult::matches)
+        .def_readonly("files_scanned", &GrepResult::files_scanned)
+        .def_readonly("bytes_scanned", &GrepResult::bytes_scanned)
+        .def_readonly("truncated", &GrepResult::truncated);
+
     py::class_<FileUtils>(m, "FileUtils")
         .def_static("search", &FileUtils::search,
                      py::arg("root"), py::arg("pattern"),
-                     py::arg("max_depth") = 10, py::arg("max_results") = 200,
+                     py::arg("max_depth") = 10, py::arg("max_results") = 200, py::arg("with_size") = true,
                      py::call_guard<py::gil_scoped_release>())
         .def_static("tail", &FileUtils::tail,
                      py::arg("path"), py::arg("lines") = 50,
                      py::call_guard<py::gil_scoped_release>())
+        .def_static("grep",
+                     py::overload_cast<const std::string&, const std::string&, const GrepOptions&>(&FileUtils::grep),
+                     py::arg("root"), py::arg("pattern"), py::arg("options") = GrepOptions{},
+                     py::call_guard<py::gil_scoped_release>())
+        // Matches are handed to `callback` as files finish; returning False stops
+        .def_static("grep_stream",
+                     [](const std::string& root, const std::string& pattern, py::function callback,
+                        const GrepOptions& options) {
+                         py::gil_scoped_release release;
+                         return FileUtils::grep(root, pattern, options, [&](const GrepMatch& match) {
+                             py::gil_scoped_acquire acquire;
+                             py::object ret = callback(match);
+                             return ret.is_none() || ret.cast<bool>();
+                         });
+                     },
+                     py::arg("root"), py::arg("pattern"), py::arg("callback"), py::arg("options") = GrepOptions{})
         .def_static("dir_size", &FileUtils::dir_size,
                      py::arg("path"),
                      py::call_guard<py::gil_scoped_release>());
+
+    py::class_<FileIndex>(m, "FileIndex")
+        .def(py::init<const std::string&, const std::string&, std::vector<std::string>>(),
+             py::arg("root"), py::arg("cache_path") = "", py::arg("skip_dirs") = std::vector<std::string>{},
+             py::call_guard<py::gil_scoped_release>())
+        .def("update", &FileIndex::update, py::arg("timeout_ms") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("search", &FileIndex::search,
+             py::arg("root"), py::arg("pattern"), py::arg("max_depth") = 10, py::arg("max_results") = 200,
+             py::call_guard<py::gil_scoped_release>())
+        .def("save", &FileIndex::save, py::arg("path") = "",
+             py::call_guard<py::gil_scoped_release>())
+        .def("revalidate", &FileIndex::revalidate, py::call_guard<py::gil_scoped_release>())
+        .def("root", &FileIndex::root)
+        .def("size", &FileIndex::size)
+        .def("fully_watched", &FileIndex::fully_watched)
+        .def("loaded_from_cache", &FileIndex::loaded_from_cache);
+
+    py::class_<DirUsage>(m, "DirUsage")
+        .def_readonly("path", &DirUsage::path)
+        .def_readonly("apparent_bytes", &DirUsage::apparent_bytes)
+        .def_readonly("allocated_bytes", &DirUsage::allocated_bytes)
+        .def_readonly("files", &DirUsage::files)
+        .def_readonly("dirs", &DirUsage::dirs)
+        .def_readonly("depth", &DirUsage::depth);
+
+    py::class_<DiskUsageReport>(m, "DiskUsageReport")
+        .def_readonly("total", &DiskUsageReport::total)
+        .def_readonly("top", &DiskUsageReport::top)
+        .def_readonly("scanned_dirs", &DiskUsageReport::scanned_dirs)
+        .def_readonly("cached_dirs", &DiskUsageReport::cached_dirs);
+
+    // The shared instance is the one FileUtils.dir_size warms
+    py::class_<DiskUsage>(m, "DiskUsage")
+        .def(py::init<int64_t>(), py::arg("max_age_ms") = 30000)
+        .def_static("shared", &DiskUsage::shared, py::return_value_policy::reference)
+        .def("scan", &DiskUsage::scan,
+             py::arg("root"), py::arg("top_n") = 10, py::arg("top_depth") = 3, py::arg("one_filesystem") = true,
+             py::call_guard<py::gil_scoped_release>())
+        .def("clear", &DiskUsage::clear)
+        .def("cached", &DiskUsage::cached);
+
+    // Appended data may end mid-character, so read() returns bytes
+    py::class_<TailFollower>(m, "TailFollower")
+        .def(py::init<const std::string&, bool>(), py::arg("path"), py::arg("from_end") = true)
+        .def("read", [](TailFollower& self, int timeout_ms, size_t max_bytes) {
+                 std::string data;
+                 {
+                     py::gil_scoped_release release;
+                     data = self.read(timeout_ms, max_bytes);
+                 }
+                 return py::bytes(data);
+             },
+             py::arg("timeout_ms") = 0, py::arg("max_bytes") = 64 * 1024)
+        .def("offset", &TailFollower::offset)
+        .def("path", &TailFollower::path);
+
+    // ── Instrumentation ─────────────────────────────────────────────────
+
+    m.def("stats", [] {
+        KernelStats st = Stats::snapshot();
+        py::dict probes;
+        for (const auto& p : st.probes) {
+            py::dict d;
+            d["calls"] = p.calls;
+            d["errors"] = p.errors;
+            d["total_seconds"] = static_cast<double>(p.total_ns) / 1e9;
+            d["max_seconds"] = static_cast<double>(p.max_ns) / 1e9;
+            d["p50_seconds"] = static_cast<double>(p.quantile_ns(0.50)) / 1e9;
+            d["p90_seconds"] = static_cast<double>(p.quantile_ns(0.90)) / 1e9;
+            d["p99_seconds"] = static_cast<double>(p.quantile_ns(0.99)) / 1e9;
+            probes[py::str(p.name)] = d;
+        }
+        py::dict syscalls;
+        for (const auto& s : st.syscalls) syscalls[py::str(s.first)] = s.second;
+        py::dict out;
+        out["probes"] = probes;
+        out["syscalls"] = syscalls;
+        out["procfs_bytes"] = st.procfs_bytes;
+        out["threads"] = st.threads;
+        return out;
+    }, "Call counts, latency quantiles and syscall counters per kernel entry point");
+    m.def("stats_prometheus", &Stats::prometheus,
+          "stats() in the Prometheus text exposition format, with full histograms");
+
+    // ── Async Completion ────────────────────────────────────────────────
+
+    // Each method queues one kernel call and returns at once; `done(result,
+    // error)` is called from run_completions(), which an event loop runs
+    // when fd() becomes readable (see app/kernel_async.py).
+    py::class_<CompletionQueue>(m, "CompletionQueue")
+        .def(py::init<unsigned>(), py::arg("threads") = 0)
+        .def("fd", &CompletionQueue::fd)
+        .def("run_completions", &CompletionQueue::run_completions)
+        .def("pending", &CompletionQueue::pending)
+        .def("threads", &CompletionQueue::threads)
+        .def("snapshot", [](CompletionQueue& q, py::function done, const std::string& disk_path) {
+                 submit_async(q, std::move(done), [disk_path] { return SystemMetrics::snapshot(disk_path); });
+             },
+             py::arg("done"), py::arg("disk_path") = "/")
+        .def("cgroup_info", [](CompletionQueue& q, py::function done) {
+                 submit_async(q, std::move(done), [] { return CgroupManager::info(); });
+             },
+             py::arg("done"))
+        .def("list_processes", [](CompletionQueue& q, py::function done, bool parallel) {
+                 submit_async(q, std::move(done), [parallel] { return ProcessManager::list_all(parallel); });
+             },
+             py::arg("done"), py::arg("parallel") = false)
+        .def("process_tree", [](CompletionQueue& q, py::function done, bool parallel) {
+                 submit_async(q, std::move(done), [parallel] { return ProcessManager::tree(parallel); });
+             },
+             py::arg("done"), py::arg("parallel") = false)
+        .def("connections", [](CompletionQueue& q, py::function done, const std::string& protocol, bool tcp_info) {
+                 submit_async(q, std::move(done), [protocol, tcp_info] {
+                     return NetworkMonitor::connections(protocol, tcp_info);
+                 });
+             },
+             py::arg("done"), py::arg("protocol") = "tcp", py::arg("tcp_info") = false)
+        .def("listening_ports", [](CompletionQueue& q, py::function done) {
+                 submit_async(q, std::move(done), [] { return NetworkMonitor::listening_ports(); });
+             },
+             py::arg("done"))
+        .def("interfaces", [](CompletionQueue& q, py::function done) {
+                 submit_async(q, std::move(done), [] { return NetworkMonitor::interfaces(); });
+             },
+             py::arg("done"))
+        .def("search", [](CompletionQueue& q, py::function done, const std::string& root, const std::string& pattern,
+                          int max_depth, int max_results, bool with_size) {
+                 submit_async(q, std::move(done), [=] {
+                     return FileUtils::search(root, pattern, max_depth, max_results, with_size);
+                 });
+             },
+             py::arg("done"), py::arg("root"), py::arg("pattern"),
+             py::arg("max_depth") = 10, py::arg("max_results") = 200, py::arg("with_size") = true)
+        .def("grep", [](CompletionQueue& q, py::function done, const std::string& root, const std::string& pattern,
+                        const GrepOptions& options) {
+                 submit_async(q, std::move(done), [=] { return FileUtils::grep(root, pattern, options); });
+             },
+             py::arg("done"), py::arg("root"), py::arg("pattern"), py::arg("options") = GrepOptions{})
+        .def("tail", [](CompletionQueue& q, py::function done, const std::string& path, int lines) {
+                 submit_async(q, std::move(done), [=] { return FileUtils::tail(path, lines); });
+             },
+             py::arg("done"), py::arg("path"), py::arg("lines") = 50)
+        .def("disk_usage", [](CompletionQueue& q, py::function done, const std::string& root, size_t top_n,
+                              int top_depth, bool one_filesystem) {
+                 submit_async(q, std::move(done), [=] {
+                     return DiskUsage::shared().scan(root, top_n, top_depth, one_filesystem);
+                 });
+             },
+             py::arg("done"), py::arg("root"), py::arg("top_n") = 10, py::arg("top_depth") = 3,
+             py::arg("one_filesystem") = true)
+        // Instance calls hold the object until their completion has run
+        .def("poll", [](CompletionQueue& q, py::function done, ProcessEventStream& stream, int timeout_ms) {
+                 submit_async(q, std::move(done), [&stream, timeout_ms] { return stream.poll(timeout_ms); },
+                              owner_of(stream));
+             },
+             py::arg("done"), py::arg("source"), py::arg("timeout_ms") = 1000)
+        .def("poll", [](CompletionQueue& q, py::function done, CgroupWatcher& watcher, int timeout_ms) {
+                 submit_async(q, std::move(done), [&watcher, timeout_ms] { return watcher.poll(timeout_ms); },
+                              owner_of(watcher));
+             },
+             py::arg("done"), py::arg("source"), py::arg("timeout_ms") = 1000)
+        .def("poll", [](CompletionQueue& q, py::function done, FSWatcher& watcher, int timeout_ms) {
+                 submit_async(q, std::move(done), [&watcher, timeout_ms] { return watcher.poll(timeout_ms); },
+                              owner_of(watcher));
+             },
+             py::arg("done"), py::arg("source"), py::arg("timeout_ms") = 1000)
+        .def("diff", [](CompletionQueue& q, py::function done, ProcessTable& table) {
+                 submit_async(q, std::move(done), [&table] { return table.diff(); }, owner_of(table));
+             },
+             py::arg("done"), py::arg("table"))
+        .def("sample", [](CompletionQueue& q, py::function done, InterfaceSampler& sampler) {
+                 submit_async(q, std::move(done), [&sampler] { return sampler.sample(); }, owner_of(sampler));
+             },
+             py::arg("done"), py::arg("sampler"))
+        .def("apply", [](CompletionQueue& q, py::function done, SocketOwnerIndex& index,
+                         std::vector<ProcEvent> events) {
+                 submit_async(q, std::move(done), [&index, events] {
+                     index.apply(events);
+                     return nullptr;
+                 }, owner_of(index));
+             },
+             py::arg("done"), py::arg("index"), py::arg("events"))
+        .def("annotate", [](CompletionQueue& q, py::function done, SocketOwnerIndex& index,
+                            std::vector<ConnectionInfo> conns) {
+                 submit_async(q, std::move(done), [&index, conns]() mutable {
+                     index.annotate(conns);
+                     return conns;
+                 }, owner_of(index));
+             },
+             py::arg("done"), py::arg("index"), py::arg("connections"));
 }
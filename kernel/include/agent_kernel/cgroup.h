@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <sys/types.h>
 
 namespace agent_kernel {
 
@@ -12,22 +14,106 @@ struct CgroupInfo {
     // Memory
     int64_t memory_limit_bytes;    // -1 if unlimited
     int64_t memory_usage_bytes;    // -1 if unavailable
+    int64_t memory_anon_bytes;     // memory.stat anon (v1: rss), -1 if unavailable
+    int64_t memory_file_bytes;     // memory.stat file (v1: cache), -1 if unavailable
 
     // CPU
     double cpu_quota;              // Number of cores (e.g. 2.0), -1 if unlimited
+    int64_t cpu_usage_usec;        // cpu.stat usage_usec (v1: cpuacct.usage), -1 if unavailable
+    int64_t cpu_nr_periods;        // cpu.stat enforcement periods, -1 without a quota controller
+    int64_t cpu_nr_throttled;
+    int64_t cpu_throttled_usec;
+
+    // I/O, summed over devices; -1 if unavailable
+    int64_t io_read_bytes;
+    int64_t io_write_bytes;
+    int64_t io_read_ops;
+    int64_t io_write_ops;
 
     // PIDs
     int64_t pids_limit;            // -1 if unlimited
     int64_t pids_current;          // -1 if unavailable
 };
 
+/// Where this process's cgroup lives, from /proc/self/cgroup and the cgroup
+/// mounts in /proc/self/mountinfo. Each controller directory is the v1
+/// hierarchy when that controller is mounted as v1 (hybrid systems), the v2
+/// directory otherwise; empty when the controller is unavailable.
+struct CgroupLocation {
+    int version = 0;          // 2 unified only, 1 if any controller is on v1, 0 if none
+    std::string unified;      // v2 directory (pressure, memory.events)
+    std::string memory;
+    std::string cpu;
+    std::string cpuacct;
+    std::string pids;
+    std::string io;           // io (v2) or blkio (v1)
+};
+
 class CgroupManager {
 public:
-    /// Read cgroup limits and usage for the current process.
+    /// Read cgroup limits and usage for the current process. Files are
+    /// opened once and re-read with pread, so this is cheap to poll.
     static CgroupInfo info();
 
-    /// Quick check: are we inside a container?
+    /// Quick check: are we inside a container? Computed once.
     static bool is_in_container();
+
+    /// This process's cgroup directories, resolved on first use. A process
+    /// moved to another cgroup afterwards keeps reporting the first one.
+    static const CgroupLocation& location();
+};
+
+/// Short-lived cgroup v2 child for a single command.
+///
+/// Created under a delegated parent: $AGENT_KERNEL_CGROUP_ROOT if set,
+/// otherwise this process's own cgroup. The memory, cpu and pids
+/// controllers are enabled in the parent's subtree_control where possible;
+/// the parent and the controllers that took are probed once per process.
+/// Destruction kills anything left inside with one cgroup.kill (SIGKILL of
+/// each member on kernels without it), waits on cgroup.events until the
+/// cgroup is unpopulated and removes the directory, so it can take a few
+/// milliseconds; keep it off latency-sensitive paths.
+class TransientCgroup {
+public:
+    struct Limits {
+        int64_t memory_max = -1;   // memory.max bytes, -1 = unlimited
+        double cpu_max = -1.0;     // cpu.max in cores, -1 = unlimited
+        int64_t pids_max = -1;     // pids.max, -1 = unlimited
+    };
+
+    /// nullptr if cgroup v2 is unavailable, the parent is not writable, or a
+    /// requested limit's controller is not enabled.
+    static std::unique_ptr<TransientCgroup> create(const Limits& limits);
+
+    ~TransientCgroup();
+
+    TransientCgroup(const TransientCgroup&) = delete;
+    TransientCgroup& operator=(const TransientCgroup&) = delete;
+
+    /// Write end of cgroup.procs; writing "0" moves the writer in.
+    int procs_fd() const noexcept;
+
+    /// Absolute path of the cgroup directory.
+    const std::string& path() const noexcept;
+
+    /// SIGKILL every process in the cgroup without waiting for them to exit.
+    void kill_all();
+
+    /// memory.peak, or -1 if the kernel does not provide it.
+    int64_t memory_peak_bytes() const;
+
+    /// cpu.stat usage_usec / throttled_usec, -1 if unavailable.
+    int64_t cpu_usage_usec() const;
+    int64_t cpu_throttled_usec() const;
+
+private:
+    TransientCgroup(std::string path, int dir_fd, int procs_fd);
+
+    int64_t read_stat(const char* file, const char* key) const;
+
+    std::string path_;
+    int dir_fd_ = -1;
+    int procs_fd_ = -1;
 };
 
 } // namespace agent_kernel
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace agent_kernel {
+
+enum class CgroupEventType : uint32_t {
+    MemoryPressure = 0x01,   // PSI trigger on memory.pressure
+    CpuPressure    = 0x02,   // PSI trigger on cpu.pressure
+    IoPressure     = 0x04,   // PSI trigger on io.pressure
+    MemoryEvents   = 0x08,   // memory.events counters moved (high, max, oom, oom_kill)
+    CpuThrottled   = 0x10,   // cpu.stat nr_throttled moved
+};
+
+/// One line pair of a *.pressure file; -1 where the kernel omits it.
+struct PressureStats {
+    double some_avg10 = -1;      // % of the last 10 s some task stalled
+    double some_avg60 = -1;
+    double full_avg10 = -1;      // % of the last 10 s all tasks stalled
+    double full_avg60 = -1;
+    int64_t some_total_us = -1;
+    int64_t full_total_us = -1;
+};
+
+struct CgroupEvent {
+    CgroupEventType type;
+    int64_t timestamp_ms;        // wall clock
+
+    PressureStats pressure;      // pressure events
+
+    // MemoryEvents: increments since the previous reading
+    int64_t memory_high = 0;
+    int64_t memory_max = 0;
+    int64_t oom = 0;
+    int64_t oom_kill = 0;
+
+    // CpuThrottled: increments since the previous reading
+    int64_t nr_throttled = 0;
+    int64_t throttled_usec = 0;
+};
+
+/// Push-style cgroup health events on one epoll descriptor.
+///
+/// PSI triggers ("some 100000 1000000" written to a *.pressure file) wake
+/// the kernel side only when the stall threshold is crossed within the
+/// window, and memory.events raises a file-modified notification whenever a
+/// counter moves, so nothing is read while the cgroup is healthy. On cgroup
+/// v1, OOMs are delivered through an eventfd registered on memory.oom_control.
+/// cpu.stat has no notification; watch_cpu_throttling() re-reads it from a
+/// timerfd. fd() can be handed to an event loop.
+class CgroupWatcher {
+public:
+    /// Watch `cgroup_dir`, or this process's own cgroup when empty. Pressure
+    /// files missing from the cgroup fall back to /proc/pressure (host-wide).
+    explicit CgroupWatcher(const std::string& cgroup_dir = "");
+    ~CgroupWatcher();
+
+    CgroupWatcher(const CgroupWatcher&) = delete;
+    CgroupWatcher& operator=(const CgroupWatcher&) = delete;
+
+    /// Fire `resource` (a *Pressure type) when tasks stall for stall_us
+    /// within any window_us. `full` watches the all-tasks-stalled line.
+    /// A window the kernel rejects for lack of CAP_SYS_RESOURCE is retried
+    /// rounded up to a multiple of 2 s, stall_us scaled to match. Returns
+    /// false if PSI is unavailable or the trigger was rejected.
+    bool add_pressure_trigger(CgroupEventType resource, int64_t stall_us, int64_t window_us, bool full = false);
+
+    /// Report memory.events (v2) or OOM notifications (v1). False if neither
+    /// is available.
+    bool watch_memory_events();
+
+    /// Report cpu.stat throttling, checked every interval_ms. False if the
+    /// cgroup has no throttling counters.
+    bool watch_cpu_throttling(int interval_ms = 1000);
+
+    /// Wait up to timeout_ms and return what happened.
+    std::vector<CgroupEvent> poll(int timeout_ms = 1000);
+
+    /// epoll descriptor that becomes readable when poll() has work.
+    int fd() const noexcept;
+
+    /// cgroup v2 directory being watched, empty if none was found.
+    const std::string& path() const noexcept;
+
+private:
+    enum class Kind { Trigger, MemoryEvents, OomEventfd, CpuTimer };
+    struct Source {
+        Kind kind;
+        CgroupEventType type;
+        int fd;
+        int stats_fd;     // file re-read when the source fires; -1 if fd itself
+    };
+
+    void add_source(Source s, uint32_t events);
+    bool read_memory_events(CgroupEvent& ev);
+    bool read_cpu_stat(CgroupEvent& ev);
+
+    std::string path_;        // cgroup v2 directory
+    std::string memory_v1_;   // cgroup v1 memory directory
+    std::string cpu_v1_;      // cgroup v1 cpu directory
+    int epoll_fd_ = -1;
+    std::vector<Source> sources_;
+
+    // Previous counter values, for increments
+    int64_t prev_high_ = 0, prev_max_ = 0, prev_oom_ = 0, prev_oom_kill_ = 0;
+    int64_t prev_nr_throttled_ = -1, prev_throttled_usec_ = 0;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <vector>
+
+namespace agent_kernel {
+
+/// Strings packed end to end in one arena: entry i is
+/// bytes[offsets[i], offsets[i + 1]). Same layout as an Arrow utf8 column,
+/// so both buffers can be handed out without copying.
+struct StringColumn {
+    std::vector<char> bytes;
+    std::vector<uint32_t> offsets{0};
+
+    size_t size() const noexcept { return offsets.size() - 1; }
+
+    std::string_view at(size_t i) const noexcept {
+        return {bytes.data() + offsets[i], offsets[i + 1] - offsets[i]};
+    }
+
+    void reserve(size_t n, size_t avg_len) {
+        offsets.reserve(n + 1);
+        bytes.reserve(n * avg_len);
+    }
+
+    void push_back(std::string_view s) {
+        bytes.insert(bytes.end(), s.begin(), s.end());
+        offsets.push_back(static_cast<uint32_t>(bytes.size()));
+    }
+};
+
+/// Dictionary-encoded strings for low-cardinality fields (process names,
+/// protocols, TCP states): codes[i] indexes `values`, and every distinct
+/// string is stored once.
+class InternedColumn {
+public:
+    std::vector<int32_t> codes;
+    StringColumn values;
+
+    size_t size() const noexcept { return codes.size(); }
+    std::string_view at(size_t i) const noexcept { return values.at(static_cast<size_t>(codes[i])); }
+
+    void push_back(std::string_view s) {
+        if ((values.size() + 1) * 2 > slots_.size()) rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        size_t mask = slots_.size() - 1;
+        size_t i = std::hash<std::string_view>{}(s) & mask;
+        for (; slots_[i] >= 0; i = (i + 1) & mask) {
+            if (values.at(static_cast<size_t>(slots_[i])) == s) {
+                codes.push_back(slots_[i]);
+                return;
+            }
+        }
+        auto code = static_cast<int32_t>(values.size());
+        values.push_back(s);
+        slots_[i] = code;
+        codes.push_back(code);
+    }
+
+private:
+    // Open-addressed table of codes, probed by comparing against `values`
+    // itself, so a hit costs no allocation and copies stay self-contained.
+    void rehash(size_t n) {
+        slots_.assign(n, -1);
+        for (size_t code = 0; code < values.size(); ++code) {
+            size_t i = std::hash<std::string_view>{}(values.at(code)) & (n - 1);
+            while (slots_[i] >= 0) i = (i + 1) & (n - 1);
+            slots_[i] = static_cast<int32_t>(code);
+        }
+    }
+
+    std::vector<int32_t> slots_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "agent_kernel/thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace agent_kernel {
+
+/// Work run on a private pool whose completions are announced on an eventfd.
+///
+/// submit() hands `work` to a worker and parks `complete`; once the work has
+/// returned its id is queued and the eventfd counter bumped. An event loop
+/// watches fd() and calls run_completions() on its own thread, which is
+/// where every `complete` runs and is destroyed — so completions may hold
+/// objects that are only safe to touch from that thread (e.g. Python
+/// callbacks under the GIL) while workers never see them.
+class CompletionQueue {
+public:
+    /// `threads` workers; 0 picks usable_cpus() + 4, since queued work is
+    /// mostly blocking reads and polls rather than CPU. Throws
+    /// std::runtime_error if the eventfd cannot be created.
+    explicit CompletionQueue(unsigned threads = 0);
+
+    /// Waits for submitted work to finish; completions not yet run are
+    /// dropped without being called.
+    ~CompletionQueue();
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    /// Run `work` on a worker, then `complete` from run_completions().
+    /// Neither may throw; capture the result or error of `work` for `complete`.
+    void submit(std::function<void()> work, std::function<void()> complete);
+
+    /// Run the completions of all work finished so far and reset the
+    /// eventfd. Returns how many ran. Call from one thread only.
+    size_t run_completions();
+
+    /// Nonblocking eventfd, readable while completions are waiting.
+    int fd() const noexcept;
+
+    /// Submitted work whose completion has not run yet.
+    size_t pending() const noexcept;
+
+    /// Number of worker threads.
+    unsigned threads() const noexcept;
+
+private:
+    int event_fd_ = -1;
+    std::mutex mtx_;   // waiting_, ready_, next_id_
+    std::unordered_map<uint64_t, std::function<void()>> waiting_;
+    std::vector<uint64_t> ready_;
+    uint64_t next_id_ = 0;
+    std::atomic<size_t> pending_{0};
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace agent_kernel {
+
+class ThreadPool;
+
+/// One directory entry handed to a DirWalker visitor. `dir_fd` stays open
+/// for the duration of the call, so fstatat(dir_fd, name, ...) works
+/// without building the full path.
+struct WalkEntry {
+    std::string_view dir;    // path of the containing directory
+    const char* name;        // NUL-terminated entry name
+    unsigned char type;      // DT_REG, DT_DIR, DT_LNK, ... (never DT_UNKNOWN)
+    int dir_fd;
+    int depth;               // 0 for entries directly under the root
+
+    std::string path() const;
+};
+
+struct WalkOptions {
+    int max_depth = 10;          // deepest directory level whose entries are listed
+    bool skip_hidden = false;    // skip names starting with '.'
+    std::vector<std::string> skip_dirs;  // directory names visited but not descended into
+};
+
+/// Parallel directory walker.
+///
+/// Directories are read with getdents64 and opened relative to their
+/// parent (openat, O_NOFOLLOW), so no path is built per entry and symlinks
+/// are never followed. Each thread owns a deque of pending directories and
+/// steals from the others when its own runs dry. The visitor runs
+/// concurrently on several threads and returns false to stop the walk.
+class DirWalker {
+public:
+    using Visitor = std::function<bool(const WalkEntry&)>;
+
+    /// Walk `root` on the shared thread pool.
+    static void walk(const std::string& root, const WalkOptions& options, const Visitor& visit);
+
+    /// Walk `root` with `pool` (the calling thread takes part too).
+    static void walk(const std::string& root, const WalkOptions& options, const Visitor& visit,
+                     ThreadPool& pool);
+};
+
+} // namespace agent_kernel
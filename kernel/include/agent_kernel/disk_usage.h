@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+namespace agent_kernel {
+
+/// Totals for one directory tree.
+struct DirUsage {
+    std::string path;
+    uint64_t apparent_bytes = 0;    // st_size of regular files
+    uint64_t allocated_bytes = 0;   // st_blocks * 512 of every entry, directories included
+    uint64_t files = 0;             // non-directory entries
+    uint64_t dirs = 0;              // directories below this one
+    int depth = 0;                  // 0 for the scanned root
+};
+
+struct DiskUsageReport {
+    DirUsage total;
+    std::vector<DirUsage> top;      // heaviest subdirectories by allocated bytes, any depth
+    uint64_t scanned_dirs = 0;      // directories listed during this scan
+    uint64_t cached_dirs = 0;       // directories answered from the cache
+};
+
+/// Parallel `du` with a per-directory cache.
+///
+/// Directories are opened relative to their parent (openat, O_NOFOLLOW) and
+/// entries fstatat'ed against that fd. Files with several links are counted
+/// once per (dev, inode). Each directory's own entries are cached under its
+/// mtime; a directory whose mtime is unchanged and whose record is younger
+/// than max_age_ms is not listed again, only its subdirectories are visited.
+/// The age limit bounds how long files growing in place go unnoticed,
+/// since that does not touch the directory mtime.
+class DiskUsage {
+public:
+    explicit DiskUsage(int64_t max_age_ms = 30000);
+
+    DiskUsage(const DiskUsage&) = delete;
+    DiskUsage& operator=(const DiskUsage&) = delete;
+
+    /// Measure `root`, reporting the `top_n` heaviest subdirectories no
+    /// deeper than `top_depth`. With `one_filesystem`, mount points below
+    /// root are not entered (du -x). Throws std::runtime_error if root
+    /// cannot be opened.
+    DiskUsageReport scan(const std::string& root, size_t top_n = 10, int top_depth = 3,
+                         bool one_filesystem = true);
+
+    /// Forget all cached directories.
+    void clear();
+
+    /// Number of cached directories.
+    size_t cached() const;
+
+    /// Process-wide instance used by FileUtils::dir_size.
+    static DiskUsage& shared();
+
+private:
+    struct Link {
+        dev_t dev;
+        ino_t ino;
+        uint64_t apparent;
+        uint64_t allocated;
+    };
+    struct Record {
+        dev_t dev;
+        ino_t ino;
+        int64_t mtime_ns;
+        std::chrono::steady_clock::time_point scanned;
+        uint64_t apparent = 0;           // own entries with a single link
+        uint64_t allocated = 0;
+        uint64_t files = 0;
+        std::vector<Link> links;         // own entries with several links
+        std::vector<std::string> subdirs;
+    };
+
+    friend struct DiskUsageScan;
+
+    int64_t max_age_ms_;
+    std::unordered_map<std::string, Record> cache_;
+    mutable std::mutex mtx_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "file_utils.h"
+#include "fs_watcher.h"
+
+namespace agent_kernel {
+
+class GlobMatcher;
+
+/// In-memory filename index of one directory tree, kept current by inotify.
+///
+/// Entries are fixed-size records (parent id, name slice, depth, type,
+/// size, mtime) over one name arena, with name and extension hash indexes so
+/// "Makefile" or "*.py" queries touch only matching entries; other patterns
+/// scan the contiguous records. Every directory gets an FSWatcher watch
+/// before it is first read, and update() re-stats whatever the events name,
+/// rescanning new directories; after an inotify queue overflow it
+/// revalidates every directory.
+///
+/// save() writes the records to a flat file that the constructor can mmap
+/// back in. A loaded index is revalidated by re-stating its directories and
+/// re-reading only those whose mtime changed, so a restart costs one stat per
+/// directory instead of a full walk. Size changes of files inside unchanged
+/// directories are picked up once they are next modified.
+class FileIndex {
+public:
+    /// Index `root`, loading `cache_path` if it holds an index of the same
+    /// root. Directories named in `skip_dirs` are indexed but not entered.
+    /// Throws std::runtime_error if root cannot be opened.
+    explicit FileIndex(const std::string& root, const std::string& cache_path = "",
+                       std::vector<std::string> skip_dirs = {});
+    ~FileIndex();
+
+    FileIndex(const FileIndex&) = delete;
+    FileIndex& operator=(const FileIndex&) = delete;
+
+    /// Apply pending filesystem events, waiting up to timeout_ms for the
+    /// first. Returns the number of events applied.
+    size_t update(int timeout_ms = 0);
+
+    /// Same contract as FileUtils::search over the indexed tree; `root` must
+    /// be the indexed root or a directory below it.
+    std::vector<FileSearchResult> search(const std::string& root, const std::string& pattern,
+                                         int max_depth = 10, int max_results = 200) const;
+
+    /// Write the index to `path` (default: the cache path), atomically.
+    void save(const std::string& path = "") const;
+
+    /// Re-stat every directory and rescan those that changed.
+    void revalidate();
+
+    const std::string& root() const noexcept { return root_; }
+
+    /// Number of indexed files and directories.
+    size_t size() const;
+
+    /// False if some directories could not be watched (inotify watch limit).
+    bool fully_watched() const;
+
+    /// Whether the constructor started from the cache file.
+    bool loaded_from_cache() const noexcept { return loaded_; }
+
+    /// Fixed-size record; also the on-disk layout.
+    struct Entry {
+        uint32_t parent;     // index of the containing directory; root is 0
+        uint32_t name_off;   // name is names[name_off, name_off + name_len)
+        uint32_t name_len;
+        uint16_t depth;      // 0 for the root, 1 for its entries
+        uint8_t type;        // DT_REG, DT_DIR, ...
+        uint8_t live;        // 0 once removed; dropped by compaction
+        uint64_t size;
+        int64_t mtime_ns;
+    };
+
+private:
+    std::string_view name_of(uint32_t id) const;
+    std::string path_of(uint32_t id) const;
+    uint32_t add_entry(uint32_t parent, std::string_view name, uint8_t type, uint64_t size, int64_t mtime_ns);
+    void index_names(uint32_t id);
+    void remove_subtree(uint32_t id);
+    void sync_dir(uint32_t id, const std::string& path);
+    void watch_dir(uint32_t id, const std::string& path);
+    void apply_event(const std::string& dir, const std::string& name);
+    void revalidate_locked();
+    void rebuild_maps();
+    void compact();
+    bool load(const std::string& path);
+    void build();
+    uint32_t find_dir(const std::string& path) const;
+    void match_into(uint32_t id, uint32_t base, int max_depth, const GlobMatcher& matcher,
+                    std::vector<uint32_t>& out, size_t limit) const;
+
+    std::string root_;
+    std::string cache_path_;
+    std::vector<std::string> skip_dirs_;
+    std::vector<Entry> entries_;
+    std::vector<char> names_;
+    size_t live_ = 0;
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> children_;   // directory id -> entries
+    std::unordered_map<std::string, uint32_t> dirs_;                 // directory path -> id
+    std::unordered_map<std::string, std::vector<uint32_t>> by_name_; // lower-cased name -> ids
+    std::unordered_map<std::string, std::vector<uint32_t>> by_ext_;  // lower-cased extension -> ids
+    std::unordered_map<uint32_t, int> watches_;                      // directory id -> watch descriptor
+
+    std::unique_ptr<FSWatcher> watcher_;
+    std::vector<FSEvent> events_;   // reused by update()
+    size_t unwatched_ = 0;
+    bool loaded_ = false;
+    std::mutex poll_mtx_;      // serializes update(); the watcher is single-threaded
+    mutable std::mutex mtx_;   // guards everything else
+};
+
+} // namespace agent_kernel
@@ -1,31 +1,83 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
+#include <sys/types.h>
 
 namespace agent_kernel {
 
+/// Upper bound on what FileUtils::tail returns.
+constexpr size_t kTailMaxBytes = 64 * 1024;
+
+/// pread() until `count` bytes, EOF or an error; returns the bytes read.
+size_t pread_full(int fd, char* buf, size_t count, off_t offset);
+
 struct FileSearchResult {
     std::string path;
     uint64_t size;
     bool is_dir;
 };
 
+struct GrepOptions {
+    bool regex = false;              // ECMAScript regex; otherwise a literal string
+    bool ignore_case = false;
+    int context = 0;                 // lines reported before and after each match
+    int max_depth = 10;
+    std::string include;             // glob on file names, e.g. "*.log"; empty = all
+    std::vector<std::string> skip_dirs;
+    int max_matches = 200;
+    size_t max_bytes = 256 * 1024;   // budget for reported text, context included
+    size_t max_line_length = 512;    // longer lines are cut when reported
+    uint64_t max_file_size = 256ull * 1024 * 1024;
+};
+
+struct GrepMatch {
+    std::string path;
+    uint64_t line;                   // 1-based
+    std::string text;
+    std::vector<std::string> before;
+    std::vector<std::string> after;
+};
+
+struct GrepResult {
+    std::vector<GrepMatch> matches;  // sorted by path, then line
+    uint64_t files_scanned = 0;
+    uint64_t bytes_scanned = 0;
+    bool truncated = false;          // stopped at max_matches or max_bytes
+};
+
 class FileUtils {
 public:
-    /// Recursive glob search. Returns matching paths up to max_results.
+    /// Recursive glob search (case-insensitive, on the shared thread pool).
+    /// Stops as soon as max_results paths have matched; results are sorted
+    /// by path. Without `with_size`, sizes are 0 and no entry is stat'ed.
     static std::vector<FileSearchResult> search(
         const std::string& root,
         const std::string& pattern,
         int max_depth = 10,
-        int max_results = 200
+        int max_results = 200,
+        bool with_size = true
     );
 
-    /// Read the last N lines of a file efficiently.
+    /// Last N lines of a file, at most kTailMaxBytes of them. Reads only the
+    /// final kTailMaxBytes with one pread, whatever the file size.
     static std::string tail(const std::string& path, int lines = 50);
 
-    /// Recursively compute directory size in bytes.
+    /// Search the contents of `root` (a file, or a tree walked in parallel)
+    /// line by line. Files containing a NUL byte in their first 8 KB are
+    /// skipped as binary. Throws std::regex_error on a bad regex.
+    static GrepResult grep(const std::string& root, const std::string& pattern, const GrepOptions& options = {});
+
+    /// Streaming grep(): `on_match` is called once per match, one call at a
+    /// time, as files finish; returning false stops the search. The result
+    /// carries the counters only.
+    static GrepResult grep(const std::string& root, const std::string& pattern, const GrepOptions& options,
+                           const std::function<bool(const GrepMatch&)>& on_match);
+
+    /// Apparent size of the regular files under `path`, in bytes, without
+    /// crossing mount points; 0 if it cannot be opened. See DiskUsage.
     static uint64_t dir_size(const std::string& path);
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -14,38 +15,77 @@ enum class FSEventType : uint32_t {
     Deleted  = 0x04,
     Moved    = 0x08,
     All      = 0x0F,
+    /// Events were lost (kernel queue overflow, or a new directory under a
+    /// recursive watch could not be watched). path and name are empty;
+    /// callers should rescan whatever they track. Always reported.
+    Overflow = 0x10,
 };
 
 struct FSEvent {
     FSEventType type;
-    std::string path;
-    std::string name;
+    std::string path;   // directory the event happened in
+    std::string name;   // entry within it; empty for Overflow
+    bool is_dir = false;
 };
 
-/// inotify-based filesystem watcher.
+/// inotify-based filesystem watcher, with optional fanotify mount marks.
+///
+/// poll() drains everything queued into one 64 KB buffer, optionally keeps
+/// reading until `debounce_ms` pass without new events, and folds repeats
+/// of the same event for the same path into one.
 class FSWatcher {
 public:
-    FSWatcher();
+    explicit FSWatcher(int debounce_ms = 0);
     ~FSWatcher();
 
     FSWatcher(const FSWatcher&) = delete;
     FSWatcher& operator=(const FSWatcher&) = delete;
 
-    /// Add a directory to watch. Returns watch descriptor.
-    int watch(const std::string& path, uint32_t mask = static_cast<uint32_t>(FSEventType::All));
+    /// Add a directory to watch. Returns watch descriptor. With `recursive`,
+    /// every subdirectory is watched too, including ones created later;
+    /// entries found while adding a new directory are reported as Created.
+    int watch(const std::string& path, uint32_t mask = static_cast<uint32_t>(FSEventType::All),
+              bool recursive = false);
 
-    /// Remove a watch by descriptor.
+    /// Watch the whole filesystem containing `path` through fanotify
+    /// (FAN_MARK_FILESYSTEM with FAN_REPORT_DFID_NAME), with no per-directory
+    /// watch limit. Needs CAP_SYS_ADMIN and Linux 5.9+; throws otherwise.
+    void watch_mount(const std::string& path, uint32_t mask = static_cast<uint32_t>(FSEventType::All));
+
+    /// Remove a watch by descriptor; for a recursive watch, its whole tree.
     void unwatch(int wd);
 
     /// Poll for events with timeout in milliseconds. Returns collected events.
     std::vector<FSEvent> poll(int timeout_ms = 100);
 
-    /// Number of active watches.
+    /// poll() into `out`, reusing its elements' string storage. Returns the
+    /// number of events, which is also out.size().
+    size_t poll_into(std::vector<FSEvent>& out, int timeout_ms = 100);
+
+    /// Number of active inotify watches.
     size_t watch_count() const noexcept;
 
 private:
+    struct Watch {
+        std::string path;
+        uint32_t mask;
+        int root;        // wd of the recursive watch this belongs to, or -1
+    };
+    struct Batch;
+    struct Mount;
+
+    int add_watch(const std::string& path, uint32_t mask, int root);
+    void add_tree(const std::string& path, uint32_t mask, int root, Batch* created);
+    void remove_tree(const std::string& path, int root);
+    bool drain_inotify(Batch& batch);
+    bool drain_fanotify(Batch& batch);
+
     int inotify_fd_;
-    std::unordered_map<int, std::string> watch_paths_;
+    int fanotify_fd_ = -1;
+    int debounce_ms_;
+    std::unique_ptr<char[]> buf_;
+    std::unordered_map<int, Watch> watch_paths_;
+    std::unique_ptr<Mount> mount_;
 };
 
 } // namespace agent_kernel
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace agent_kernel {
+
+/// A glob pattern compiled once and matched against many file names, with
+/// the same results as fnmatch(pattern, name, flags) without FNM_PATHNAME
+/// or FNM_PERIOD.
+///
+/// Patterns that are a literal, "lit*", "*lit", "*lit*" or "*" become plain
+/// comparisons; other patterns without brackets or escapes use an iterative
+/// '*'/'?' matcher, and only the rest go through fnmatch().
+class GlobMatcher {
+public:
+    enum class Kind { Any, Exact, Prefix, Suffix, Contains, Wildcard, Fnmatch };
+
+    explicit GlobMatcher(std::string pattern, bool case_insensitive = true);
+
+    /// `name` must be NUL-terminated when the fnmatch() path is used, which
+    /// is always the case for dirent names.
+    bool match(std::string_view name) const;
+
+    const std::string& pattern() const noexcept { return pattern_; }
+    Kind kind() const noexcept { return kind_; }
+
+    /// For Exact/Prefix/Suffix/Contains, the literal part (lower-cased when
+    /// matching case-insensitively).
+    const std::string& literal() const noexcept { return literal_; }
+
+private:
+
+    bool equal(std::string_view a, std::string_view b) const;
+    bool wildcard(std::string_view name) const;
+
+    std::string pattern_;
+    std::string literal_;   // lower-cased when case-insensitive
+    Kind kind_;
+    bool fold_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "network.h"
+
+namespace agent_kernel {
+
+/// Per-second interface throughput between two InterfaceSampler samples.
+struct InterfaceRates {
+    std::string name;
+    bool up;
+    bool loopback;
+    double interval_sec;      // 0 for an interface seen for the first time
+    double rx_bytes_per_sec;
+    double tx_bytes_per_sec;
+    double rx_packets_per_sec;
+    double tx_packets_per_sec;
+    double rx_errors_per_sec;
+    double tx_errors_per_sec;
+    double rx_dropped_per_sec;
+    double tx_dropped_per_sec;
+    InterfaceStats totals;    // cumulative counters at this sample
+};
+
+/// Stateful interface lister that turns cumulative counters into rates.
+///
+/// Each sample() reads the link counters once (RTM_GETLINK with
+/// IFLA_STATS64, or /proc/net/dev without netlink) and diffs them against
+/// the previous sample of the same interface using CLOCK_MONOTONIC time,
+/// so nothing sleeps. An interface whose ifindex changed was recreated and
+/// starts fresh. A counter that went backwards is treated as a 32-bit wrap
+/// when the old value sat in the top half of the 32-bit range, otherwise as
+/// a reset.
+class InterfaceSampler {
+public:
+    InterfaceSampler() = default;
+
+    InterfaceSampler(const InterfaceSampler&) = delete;
+    InterfaceSampler& operator=(const InterfaceSampler&) = delete;
+
+    /// Read all interfaces and compute rates since the previous call.
+    std::vector<InterfaceRates> sample();
+
+private:
+    struct Prev {
+        InterfaceStats stats;
+        int ifindex;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    std::unordered_map<std::string, Prev> prev_;
+    std::mutex mtx_;
+};
+
+} // namespace agent_kernel
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "network.h"
+
 namespace agent_kernel {
 
 struct CpuInfo {
@@ -30,12 +33,27 @@ struct DiskInfo {
     double usage_percent;
 };
 
+/// Everything a health check needs, gathered in one call.
+struct SystemSnapshot {
+    CpuInfo cpu;
+    MemInfo memory;
+    DiskInfo disk;
+    std::vector<ConnectionInfo> listening;
+    uint32_t procs_running;    // /proc/stat
+    uint32_t procs_blocked;
+    uint32_t threads_total;    // /proc/loadavg
+};
+
 class SystemMetrics {
 public:
     static CpuInfo cpu();
     static MemInfo memory();
     static DiskInfo disk(const std::string& path = "/");
     static std::vector<DiskInfo> all_disks();
+
+    /// cpu(), memory(), disk(disk_path) and listening ports in one call.
+    /// The procfs files stay open between calls and are re-read with pread.
+    static SystemSnapshot snapshot(const std::string& disk_path = "/");
 };
 
 } // namespace agent_kernel
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace agent_kernel {
+
+/// One collector tick. Plain data so the ring can copy it without locks.
+struct MetricsSample {
+    static constexpr size_t kMaxCores = 128;
+
+    int64_t timestamp_ms;             // wall clock, ms since the epoch
+    float cpu_percent;                // aggregate over all cores
+    uint16_t core_count;              // valid entries in core_percent
+    float core_percent[kMaxCores];
+    float load_1m;
+    float load_5m;
+    float load_15m;
+    uint64_t mem_total_kb;
+    uint64_t mem_available_kb;
+    uint64_t swap_used_kb;
+    uint64_t disk_total_bytes;
+    uint64_t disk_used_bytes;
+    double net_rx_bytes_per_sec;      // summed over non-loopback interfaces
+    double net_tx_bytes_per_sec;
+    int64_t cgroup_memory_bytes;      // -1 if unavailable
+    float cgroup_cpu_percent;         // 100 = one core; -1 if unavailable
+};
+
+/// A window of samples as columns, oldest first. core_percent is row-major,
+/// size() rows by `cores` columns; cores a sample did not report are 0.
+struct MetricsColumns {
+    size_t cores = 0;
+    std::vector<int64_t> timestamp_ms;
+    std::vector<float> cpu_percent;
+    std::vector<float> core_percent;
+    std::vector<float> load_1m;
+    std::vector<float> load_5m;
+    std::vector<float> load_15m;
+    std::vector<uint64_t> mem_total_kb;
+    std::vector<uint64_t> mem_available_kb;
+    std::vector<uint64_t> swap_used_kb;
+    std::vector<uint64_t> disk_used_bytes;
+    std::vector<double> net_rx_bytes_per_sec;
+    std::vector<double> net_tx_bytes_per_sec;
+    std::vector<int64_t> cgroup_memory_bytes;
+    std::vector<float> cgroup_cpu_percent;
+
+    size_t size() const noexcept { return timestamp_ms.size(); }
+};
+
+/// Opt-in background sampler. A dedicated thread reads procfs/cgroupfs
+/// every `interval_ms` into a fixed ring of MetricsSample slots, each guarded
+/// by a seqlock: the single writer never waits, and readers copy the latest
+/// sample or a window of history without blocking it or each other.
+class MetricsCollector {
+public:
+    explicit MetricsCollector(int interval_ms = 1000, size_t capacity = 600,
+                              const std::string& disk_path = "/");
+    ~MetricsCollector();
+
+    MetricsCollector(const MetricsCollector&) = delete;
+    MetricsCollector& operator=(const MetricsCollector&) = delete;
+
+    /// Start the sampling thread; no-op if already running.
+    void start();
+
+    /// Stop and join the sampling thread. History is kept.
+    void stop();
+
+    bool running() const noexcept;
+
+    /// Most recent sample, if any has been taken.
+    std::optional<MetricsSample> latest() const;
+
+    /// Up to the last `n` samples, oldest first.
+    std::vector<MetricsSample> history(size_t n) const;
+
+    /// Samples taken since `timestamp_ms` (exclusive), oldest first.
+    std::vector<MetricsSample> since(int64_t timestamp_ms) const;
+
+    /// history(n) as columns.
+    MetricsColumns columns(size_t n) const;
+
+    size_t capacity() const noexcept;
+    int interval_ms() const noexcept;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};   // odd while the writer is inside
+        MetricsSample sample;
+    };
+    struct Sources;
+
+    void run();
+    void publish(const MetricsSample& s);
+    bool read_slot(uint64_t index, MetricsSample& out) const;
+
+    int interval_ms_;
+    std::string disk_path_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    std::atomic<uint64_t> written_{0};  // samples published so far
+
+    std::unique_ptr<Sources> sources_;
+    std::thread thread_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stop_requested_ = false;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace agent_kernel
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "columns.h"
+
 namespace agent_kernel {
 
 struct ConnectionInfo {
@@ -15,6 +17,29 @@ struct ConnectionInfo {
     std::string state;       // ESTABLISHED, LISTEN, TIME_WAIT, etc.
     int uid;
     uint64_t inode;
+    // TCP only, from netlink tcp_info when requested; -1 otherwise
+    int64_t rtt_us = -1;
+    int64_t retransmits = -1;
+    int64_t bytes_acked = -1;
+    int64_t bytes_received = -1;
+    // Owning process, filled in by SocketOwnerIndex::annotate(); 0 if unknown
+    int pid = 0;
+    std::string process_name;
+};
+
+/// Struct-of-arrays connection listing; addresses and states are interned.
+struct ConnectionColumns {
+    InternedColumn protocol;
+    InternedColumn local_addr;
+    std::vector<uint16_t> local_port;
+    InternedColumn remote_addr;
+    std::vector<uint16_t> remote_port;
+    InternedColumn state;
+    std::vector<int32_t> uid;
+    std::vector<uint64_t> inode;
+
+    size_t size() const noexcept { return inode.size(); }
+    void push_back(const ConnectionInfo& c);
 };
 
 struct InterfaceStats {
@@ -32,11 +57,30 @@ struct InterfaceStats {
 class NetworkMonitor {
 public:
     /// List all connections for a given protocol (tcp, tcp6, udp, udp6).
-    static std::vector<ConnectionInfo> connections(const std::string& protocol = "tcp");
+    /// With `tcp_info`, TCP rows also carry RTT, retransmits and byte
+    /// counters (netlink backend only).
+    static std::vector<ConnectionInfo> connections(const std::string& protocol = "tcp", bool tcp_info = false);
+
+    /// Connections whose state is one of `states` (names as in
+    /// ConnectionInfo::state). Filtered in the kernel when netlink is used.
+    static std::vector<ConnectionInfo> connections_in_state(const std::string& protocol,
+                                                            const std::vector<std::string>& states,
+                                                            bool tcp_info = false);
+
+    /// connections() as columns. "all" covers tcp, tcp6, udp and udp6.
+    static ConnectionColumns connection_columns(const std::string& protocol = "all");
 
     /// List only listening ports.
     static std::vector<ConnectionInfo> listening_ports();
 
+    /// "netlink" when sock_diag answers queries, else "procfs".
+    static std::string backend();
+
+    /// Parse a file in /proc/net/<protocol> format, such as another
+    /// namespace's /proc/<pid>/net/tcp6 or a synthetic table. Empty if it
+    /// cannot be read or `protocol` is unknown.
+    static std::vector<ConnectionInfo> parse_table(const std::string& path, const std::string& protocol = "tcp");
+
     /// Get interface statistics from /proc/net/dev.
     static std::vector<InterfaceStats> interfaces();
 };
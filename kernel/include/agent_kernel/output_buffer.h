@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace agent_kernel {
+
+/// Accumulates one output stream of a command. Unbounded by default; with
+/// limits it keeps only the first `head_bytes` and a ring of the last
+/// `tail_bytes`, so memory per command stays fixed however chatty it is.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(size_t head_bytes = 0, size_t tail_bytes = 0);
+
+    void append(const char* data, size_t size);
+
+    /// Bytes seen so far, kept or not.
+    uint64_t total() const noexcept;
+
+    /// Whether anything was dropped between head and tail.
+    bool truncated() const noexcept;
+
+    /// Kept output; if truncated, head and tail are joined by a
+    /// "[... N bytes omitted ...]" line. Leaves the buffer empty.
+    std::string take();
+
+private:
+    size_t head_limit_;
+    size_t tail_limit_;
+    bool bounded_;
+    std::string head_;
+    std::string tail_;        // ring once it reaches tail_limit_
+    size_t tail_start_ = 0;   // oldest byte in the ring
+    uint64_t total_ = 0;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace agent_kernel {
+
+/// Whitespace-separated field tokenizer over procfs text. Never reads past
+/// `end`; numbers stop at the first non-digit.
+struct FieldCursor {
+    const char* p;
+    const char* end;
+
+    bool at_end() const { return p >= end; }
+
+    void skip_spaces() {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    }
+
+    void skip_field() {
+        skip_spaces();
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\n') ++p;
+    }
+
+    void skip_fields(int n) {
+        for (int i = 0; i < n; ++i) skip_field();
+    }
+
+    /// Move to the start of the next line.
+    void next_line() {
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+    }
+
+    /// True (and consumed) if the cursor is at `lit`.
+    bool consume(const char* lit) {
+        const char* q = p;
+        while (*lit) {
+            if (q >= end || *q != *lit) return false;
+            ++q;
+            ++lit;
+        }
+        p = q;
+        return true;
+    }
+
+    /// Skip past the next occurrence of `c` on the current line.
+    bool skip_past(char c) {
+        while (p < end && *p != c && *p != '\n') ++p;
+        if (p >= end || *p != c) return false;
+        ++p;
+        return true;
+    }
+
+    char next_char() {
+        skip_spaces();
+        if (p >= end) return '?';
+        char c = *p;
+        skip_field();
+        return c;
+    }
+
+    int64_t next_int() {
+        skip_spaces();
+        bool neg = (p < end && *p == '-');
+        if (neg) ++p;
+        uint64_t v = next_uint_digits();
+        return neg ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    }
+
+    uint64_t next_uint() {
+        skip_spaces();
+        return next_uint_digits();
+    }
+
+    /// Hex digits (no prefix), at most `max_digits` of them.
+    uint64_t next_hex(int max_digits = 16) {
+        skip_spaces();
+        uint64_t v = 0;
+        for (int i = 0; i < max_digits && p < end; ++i, ++p) {
+            char c = *p;
+            unsigned d;
+            if (c >= '0' && c <= '9') d = static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') d = static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') d = static_cast<unsigned>(c - 'A' + 10);
+            else break;
+            v = (v << 4) | d;
+        }
+        return v;
+    }
+
+    /// Decimal with an optional fraction ("0.52"), as in /proc/loadavg.
+    double next_double() {
+        skip_spaces();
+        double v = static_cast<double>(next_uint_digits());
+        if (p < end && *p == '.') {
+            ++p;
+            double scale = 0.1;
+            while (p < end && *p >= '0' && *p <= '9') {
+                v += (*p - '0') * scale;
+                scale *= 0.1;
+                ++p;
+            }
+        }
+        return v;
+    }
+
+private:
+    uint64_t next_uint_digits() {
+        uint64_t v = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            v = v * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+        return v;
+    }
+};
+
+/// A procfs file held open and re-read from offset 0 with pread() into a
+/// buffer that is reused (and only grows) across reads. Not thread-safe.
+class ProcFile {
+public:
+    explicit ProcFile(std::string path, size_t initial_capacity = 4096);
+
+    /// `name` opened relative to `dir_fd`, which must outlive this object.
+    /// A negative dir_fd makes every read() fail without a syscall.
+    ProcFile(int dir_fd, std::string name, size_t initial_capacity = 4096);
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    /// Re-read the whole file. False if it cannot be opened or read; the
+    /// open is retried on the next call. An empty path is never opened.
+    bool read();
+
+    const char* data() const noexcept { return buf_.data(); }
+    size_t size() const noexcept { return size_; }
+    FieldCursor cursor() const noexcept { return {buf_.data(), buf_.data() + size_}; }
+
+private:
+    std::string path_;
+    int dir_fd_;
+    int fd_ = -1;
+    std::vector<char> buf_;
+    size_t size_ = 0;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "process.h"
+
+namespace agent_kernel {
+
+class ThreadPool;
+
+/// Cumulative CPU time of a process, in clock ticks (sysconf(_SC_CLK_TCK)).
+struct ProcTimes {
+    uint64_t utime;
+    uint64_t stime;
+};
+
+/// Allocation-light /proc reader.
+///
+/// Holds a directory fd on the proc root, lists PIDs with getdents64 and reads
+/// <pid>/stat and <pid>/cmdline with openat() + read() into per-thread buffers.
+/// Fields are tokenized in place, so the only per-PID heap allocations are the
+/// result strings themselves. Safe to share between threads.
+class ProcScanner {
+public:
+    /// Open the proc root. `proc_root` is overridable for synthetic fixtures.
+    explicit ProcScanner(const std::string& proc_root = "/proc");
+    ~ProcScanner();
+
+    ProcScanner(const ProcScanner&) = delete;
+    ProcScanner& operator=(const ProcScanner&) = delete;
+
+    /// PIDs currently present under the proc root, in directory order.
+    std::vector<pid_t> pids() const;
+
+    /// Parse a single PID into `out`, and its CPU ticks into `times` when
+    /// given. Returns false if the process is gone.
+    bool read(pid_t pid, ProcessInfo& out, ProcTimes* times = nullptr) const;
+
+    /// Direct children of `pid`, from /proc/<pid>/task/*/children. Returns
+    /// false when the kernel lacks CONFIG_PROC_CHILDREN; a vanished process
+    /// simply has no children.
+    bool children_of(pid_t pid, std::vector<pid_t>& out) const;
+
+    /// pids() followed by read() on each; vanished processes are skipped.
+    std::vector<ProcessInfo> scan() const;
+
+    /// Same as scan(), but the PID list is split into shards that are parsed
+    /// on `pool` and merged back in directory order.
+    std::vector<ProcessInfo> scan(ThreadPool& pool) const;
+
+    /// Shared scanner over the real /proc, opened on first use.
+    static const ProcScanner& system();
+
+private:
+    int root_fd_;
+};
+
+} // namespace agent_kernel
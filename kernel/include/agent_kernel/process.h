@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <sys/types.h>
 
+#include "columns.h"
+
 namespace agent_kernel {
 
 struct ProcessInfo {
@@ -14,9 +16,10 @@ struct ProcessInfo {
     char state;            // R, S, D, Z, T, etc.
     uint64_t rss_kb;       // resident set size
     uint64_t vsize_kb;     // virtual memory size
-    double cpu_percent;    // approximate
+    double cpu_percent;    // 100 = one core; filled in by ProcessSampler
     std::string cmdline;
     uid_t uid;
+    uint64_t start_time;   // clock ticks after boot; (pid, start_time) is unique
 };
 
 struct ResourceLimits {
@@ -27,6 +30,24 @@ struct ResourceLimits {
     int64_t max_processes = 64;     // RLIMIT_NPROC
 };
 
+/// Struct-of-arrays process listing: row i of every column is one process.
+struct ProcessColumns {
+    std::vector<int32_t> pid;
+    std::vector<int32_t> ppid;
+    std::vector<uint32_t> uid;
+    std::vector<uint8_t> state;
+    std::vector<uint64_t> rss_kb;
+    std::vector<uint64_t> vsize_kb;
+    std::vector<uint64_t> start_time;
+    std::vector<double> cpu_percent;
+    InternedColumn name;
+    StringColumn cmdline;
+
+    size_t size() const noexcept { return pid.size(); }
+    void reserve(size_t n);
+    void push_back(const ProcessInfo& p);
+};
+
 struct ProcessTreeNode {
     ProcessInfo info;
     int depth;
@@ -34,8 +55,12 @@ struct ProcessTreeNode {
 
 class ProcessManager {
 public:
-    /// List all running processes by reading /proc.
-    static std::vector<ProcessInfo> list_all();
+    /// List all running processes by reading /proc. With `parallel`, the PID
+    /// list is sharded across the shared worker pool.
+    static std::vector<ProcessInfo> list_all(bool parallel = false);
+
+    /// list_all() as columns, for callers that filter or aggregate in bulk.
+    static ProcessColumns list_columns(bool parallel = false);
 
     /// Get info for a specific PID.
     static ProcessInfo get_info(pid_t pid);
@@ -47,9 +72,13 @@ public:
     static pid_t spawn(const std::string& command, const ResourceLimits& limits = {});
 
     /// Build a process tree: flat list sorted in depth-first order with depth field.
-    static std::vector<ProcessTreeNode> tree();
+    static std::vector<ProcessTreeNode> tree(bool parallel = false);
+
+    /// Subtree rooted at `root_pid` (depth 0), read without a full /proc scan
+    /// when the kernel exposes /proc/<pid>/task/<tid>/children.
+    static std::vector<ProcessTreeNode> tree(pid_t root_pid);
 
-    /// Get children of a specific PID.
+    /// Get direct children of a specific PID.
     static std::vector<ProcessInfo> children(pid_t pid);
 };
 
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+#include "process_table.h"
+
+namespace agent_kernel {
+
+enum class ProcEventType : uint32_t {
+    Fork = 0x01,
+    Exec = 0x02,
+    Exit = 0x04,
+};
+
+struct ProcEvent {
+    ProcEventType type;
+    pid_t pid;
+    pid_t ppid;        // Fork: parent; otherwise 0
+    int exit_code;     // Exit: exit status or -signal; -1 if unknown
+};
+
+/// Event-driven process change source that keeps a ProcessTable current.
+///
+/// Prefers the netlink process connector (PROC_EVENT_FORK/EXEC/EXIT), which
+/// needs CAP_NET_ADMIN in the initial network namespace and is only used
+/// once the kernel acknowledges the subscription (it silently ignores it
+/// from a non-initial PID or user namespace). Otherwise falls back to a
+/// diff() of the table every `rescan_interval_ms`, plus pidfd exit
+/// notification for processes registered with track(); every child started
+/// through spawn_process (ProcessManager::spawn, Sandbox, SandboxPool
+/// workers) is registered with each polling stream automatically. Either
+/// way only the affected PIDs are re-read, and fd() can be handed to an
+/// event loop.
+class ProcessEventStream {
+public:
+    enum class Mode { Netlink, Polling };
+
+    /// Seeds `table` with a full scan. The table must outlive the stream.
+    explicit ProcessEventStream(ProcessTable& table, int rescan_interval_ms = 1000);
+    ~ProcessEventStream();
+
+    ProcessEventStream(const ProcessEventStream&) = delete;
+    ProcessEventStream& operator=(const ProcessEventStream&) = delete;
+
+    /// Which source is delivering events.
+    Mode mode() const noexcept;
+
+    /// Get an exit event for a child we spawned (ProcessManager::spawn,
+    /// Sandbox) via pidfd, without waiting for the next rescan. The child is
+    /// not reaped. Returns false if pidfds are unavailable or the process is
+    /// already gone. No-op in netlink mode, which already sees every exit.
+    bool track(pid_t pid);
+
+    /// track() `pid` on every polling stream; called by spawn_process.
+    static void track_spawned(pid_t pid);
+
+    /// Wait up to timeout_ms for events, apply them to the table and return
+    /// them. Overflowed netlink queues are resynced with a full diff().
+    std::vector<ProcEvent> poll(int timeout_ms = 100);
+
+    /// epoll descriptor that becomes readable when poll() has work.
+    int fd() const noexcept;
+
+private:
+    bool open_netlink();
+    void drain_netlink(std::vector<ProcEvent>& events, std::vector<pid_t>& touched, bool& resync);
+    void rescan(std::vector<ProcEvent>& events);
+
+    ProcessTable& table_;
+    Mode mode_ = Mode::Polling;
+    int epoll_fd_ = -1;
+    int netlink_fd_ = -1;
+    int timer_fd_ = -1;
+    std::mutex pidfds_mtx_;                  // track() may run on any thread
+    std::unordered_map<int, pid_t> pidfds_;  // pidfd -> pid
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <sys/types.h>
+
+#include "process.h"
+
+namespace agent_kernel {
+
+/// Stateful process lister that fills in real per-process CPU%.
+///
+/// Each sample() is one /proc scan. The previous utime+stime of every
+/// process is kept in a flat open-addressing table keyed by (pid, start_time),
+/// so CPU% is the tick delta since the last sample — no sleeping. Processes
+/// seen for the first time report their lifetime average instead. Entries for
+/// processes that have exited are dropped at the end of each sample.
+class ProcessSampler {
+public:
+    ProcessSampler();
+
+    ProcessSampler(const ProcessSampler&) = delete;
+    ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+    /// Scan all processes and compute CPU% since the previous call.
+    std::vector<ProcessInfo> sample();
+
+    /// Number of processes currently tracked.
+    size_t tracked() const;
+
+private:
+    struct Slot {
+        pid_t pid;             // 0 = empty
+        uint32_t generation;   // last sample() that saw this pid
+        uint64_t start_time;
+        uint64_t ticks;        // utime + stime
+    };
+
+    Slot* find_or_insert(pid_t pid);
+    void erase_at(size_t idx);
+    void grow();
+    void sweep();
+
+    std::vector<Slot> slots_;  // power-of-two capacity, linear probing
+    size_t count_ = 0;
+    uint32_t generation_ = 0;
+    double prev_time_ = 0.0;   // CLOCK_BOOTTIME seconds at last sample
+    mutable std::mutex mtx_;
+};
+
+} // namespace agent_kernel
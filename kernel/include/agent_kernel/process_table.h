@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+#include "process.h"
+#include "process_sampler.h"
+
+namespace agent_kernel {
+
+/// What changed between two ProcessTable refreshes.
+struct ProcessDelta {
+    std::vector<ProcessInfo> spawned;  // new (pid, start_time) pairs
+    std::vector<ProcessInfo> changed;  // ppid, name or cmdline differs, or state moved into/out of Z or D
+    std::vector<pid_t> exited;         // gone since the previous refresh
+    std::vector<pid_t> execed;         // subset of changed whose name or cmdline differs
+};
+
+/// Incremental process table.
+///
+/// Keeps the latest snapshot (with sampler CPU%) inside the kernel so callers
+/// only marshal what changed, and answers aggregate queries without copying
+/// the whole table out. A reused PID is reported as exited + spawned.
+class ProcessTable {
+public:
+    ProcessTable() = default;
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    /// Rescan /proc and return the changes since the previous call. The
+    /// first call reports every process as spawned.
+    ProcessDelta diff();
+
+    /// Re-read only the given PIDs (plus any zombies in the table, whose
+    /// reaping produces no event) and return what changed. Entries keep their
+    /// last CPU% until the next diff().
+    ProcessDelta update(const std::vector<pid_t>& pids);
+
+    /// Number of processes in the current snapshot.
+    size_t size() const;
+
+    /// Process count per state character (R, S, D, Z, ...).
+    std::map<char, size_t> state_counts() const;
+
+    /// Number of processes in a given state.
+    size_t count_state(char state) const;
+
+    /// The n processes with the largest resident set.
+    std::vector<ProcessInfo> top_by_rss(size_t n) const;
+
+    /// The n processes with the highest CPU% over the last refresh.
+    std::vector<ProcessInfo> top_by_cpu(size_t n) const;
+
+    /// Copy of the full current snapshot.
+    std::vector<ProcessInfo> snapshot() const;
+
+    /// The current snapshot as columns, in no particular order.
+    ProcessColumns columns() const;
+
+private:
+    template <typename Less>
+    std::vector<ProcessInfo> top_n(size_t n, Less less) const;
+
+    ProcessSampler sampler_;
+    std::unordered_map<pid_t, ProcessInfo> procs_;
+    std::mutex refresh_mtx_;   // serializes diff() so snapshots apply in order
+    mutable std::mutex mtx_;   // guards procs_
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "network.h"
+
+namespace agent_kernel {
+
+/// One interface from an RTM_GETLINK dump.
+struct LinkRecord {
+    int ifindex;
+    unsigned flags;        // IFF_UP, IFF_LOOPBACK, ...
+    InterfaceStats stats;  // from IFLA_STATS64
+};
+
+/// NETLINK_ROUTE client for link counters, so interface stats come back as
+/// binary 64-bit values instead of /proc/net/dev text. One socket is held
+/// open and requests are serialized on it.
+class RtnlLinkReader {
+public:
+    RtnlLinkReader();
+    ~RtnlLinkReader();
+
+    RtnlLinkReader(const RtnlLinkReader&) = delete;
+    RtnlLinkReader& operator=(const RtnlLinkReader&) = delete;
+
+    /// Process-wide instance.
+    static RtnlLinkReader& shared();
+
+    /// Replace `out` with every link that reports IFLA_STATS64. False if
+    /// netlink is unavailable, the dump failed or no link had stats.
+    bool read(std::vector<LinkRecord>& out);
+
+private:
+    int fd_ = -1;
+    uint32_t seq_ = 0;
+    std::vector<char> buf_;
+    std::mutex mtx_;
+};
+
+} // namespace agent_kernel
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 #include "process.h"
@@ -12,6 +14,10 @@ struct SandboxPolicy {
     std::vector<std::string> env;          // KEY=VALUE pairs
     bool drop_privileges = true;           // setuid to nobody
     bool restrict_network = false;         // (future: network namespaces)
+    bool use_cgroup = true;                // per-command cgroup v2 when delegation allows
+    double cpu_cores = -1.0;               // cpu.max in cores (cgroup only), -1 = unlimited
+    size_t output_head_bytes = 0;          // keep only the first/last bytes of each
+    size_t output_tail_bytes = 0;          //   stream; both 0 = keep everything
 };
 
 struct ExecutionResult {
@@ -20,9 +26,36 @@ struct ExecutionResult {
     std::string stderr_output;
     double elapsed_seconds;
     bool timed_out;
+    bool truncated;                        // output exceeded the policy's head/tail bounds
+
+    // From the command's cgroup; -1 when it ran without one.
+    int64_t memory_peak_bytes;
+    int64_t cpu_usage_usec;
+    int64_t cpu_throttled_usec;
+
+    // From wait4(): the shell plus every descendant it waited for; -1 when
+    // unavailable. exit_code is -1 for a signal death, term_signal says which.
+    int term_signal = 0;                   // 0 if the command exited normally
+    double user_cpu_seconds = -1;
+    double sys_cpu_seconds = -1;
+    int64_t max_rss_kb = -1;               // largest single process, not the sum
+    int64_t minor_faults = -1;
+    int64_t major_faults = -1;
+    int64_t voluntary_switches = -1;       // blocked waiting (I/O, locks)
+    int64_t involuntary_switches = -1;     // preempted (CPU contention)
 };
 
+/// Receives output as it arrives: stream is 1 (stdout) or 2 (stderr).
+/// Throwing aborts the command (it is killed) and the error propagates.
+using OutputCallback = std::function<void(int stream, const char* data, size_t size)>;
+
 /// Sandboxed command execution with resource limits.
+///
+/// With `use_cgroup`, each command gets a TransientCgroup: max_memory_bytes
+/// becomes memory.max instead of RLIMIT_AS, max_processes also sets
+/// pids.max, and cpu_cores sets cpu.max. Anything the command leaves running
+/// is killed with the cgroup once its shell exits. Without cgroup v2
+/// delegation it silently falls back to rlimits alone.
 class Sandbox {
 public:
     /// Run a command in a sandboxed environment.
@@ -34,6 +67,24 @@ public:
         int timeout_seconds,
         const SandboxPolicy& policy = {}
     );
+
+    /// Like run_with_timeout, but deliver output chunks to `on_output` as
+    /// they are read. The result still carries the (bounded) output.
+    static ExecutionResult run_streaming(
+        const std::string& command,
+        int timeout_seconds,
+        const OutputCallback& on_output,
+        const SandboxPolicy& policy = {}
+    );
+
+    /// Run several commands concurrently under one policy, supervised from
+    /// the calling thread. Results are in command order; the timeout applies
+    /// to each command and 0 means none.
+    static std::vector<ExecutionResult> run_batch(
+        const std::vector<std::string>& commands,
+        int timeout_seconds = 0,
+        const SandboxPolicy& policy = {}
+    );
 };
 
 } // namespace agent_kernel
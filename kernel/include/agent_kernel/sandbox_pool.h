@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "sandbox.h"
+
+namespace agent_kernel {
+
+/// Pool of long-lived /bin/sh workers for running many short commands.
+///
+/// Each worker is spawned once with the policy's limits, working_dir and env
+/// already applied, then runs a small driver loop that reads commands from a
+/// socketpair and evaluates each in a subshell, so a command costs one fork
+/// of a small shell instead of spawn + exec + setup. Output streams back on
+/// per-worker pipes and the exit status on the socket. Each worker leads its
+/// own process group and is a child subreaper, so a timeout or callback
+/// error kills the whole group, command and descendants included. Workers
+/// are replaced after `max_uses` commands, after a timeout, when a command
+/// leaves background processes behind (they die with the old worker), or if
+/// they die.
+///
+/// With `use_cgroup`, each command also gets a TransientCgroup with the
+/// same limits as under Sandbox: the subshell moves itself in before running
+/// the command, and whatever is left inside is killed when it exits.
+///
+/// Differences from Sandbox: the shell only reports a signal death as status
+/// 128+N, so any status from 129 to 128+NSIG is reported as term_signal N
+/// with exit_code -1, including an explicit `exit 137`. The rlimits,
+/// including RLIMIT_AS, stay on alongside the cgroup because they are the
+/// worker's, and processes that leave both the cgroup and the process group
+/// escape the kill. CPU time and page faults are the growth of the worker's
+/// reaped-children counters in /proc/<pid>/stat, in clock ticks. max_rss_kb
+/// is the cgroup's memory.peak (the whole command, not its largest process);
+/// without a cgroup it and the cgroup fields are -1, and the context switch
+/// counts always are.
+class SandboxPool {
+public:
+    explicit SandboxPool(const SandboxPolicy& policy = {}, size_t workers = 2, size_t max_uses = 100);
+    ~SandboxPool();
+
+    SandboxPool(const SandboxPool&) = delete;
+    SandboxPool& operator=(const SandboxPool&) = delete;
+
+    /// Run a command on an idle worker, waiting for one if all are busy.
+    /// timeout_seconds <= 0 means no timeout.
+    ExecutionResult run(const std::string& command, int timeout_seconds = 0);
+
+    /// run() delivering output chunks to `on_output` as they arrive; see
+    /// Sandbox::run_streaming.
+    ExecutionResult run_streaming(const std::string& command, int timeout_seconds,
+                                  const OutputCallback& on_output);
+
+    /// Number of workers.
+    size_t size() const noexcept;
+
+    /// Commands a worker runs before it is replaced.
+    size_t max_uses() const noexcept;
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        int control_fd = -1;   // our end of the socketpair
+        int out_fd = -1;
+        int err_fd = -1;
+        int epoll_fd = -1;
+        int timer_fd = -1;
+        size_t uses = 0;
+        bool busy = false;
+        std::string pending;   // partial control line
+    };
+
+    void start(Worker& w);
+    void stop(Worker& w);
+    bool execute(Worker& w, const std::string& command, int timeout_seconds,
+                 const OutputCallback* on_output, ExecutionResult& result);
+
+    SandboxPolicy policy_;
+    size_t max_uses_;
+    std::string sentinel_;
+    std::vector<Worker> workers_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace agent_kernel {
+
+/// One socket as reported by inet_diag. Addresses stay in network byte
+/// order so nothing is formatted for rows the caller ends up dropping.
+struct SocketRecord {
+    uint8_t family;          // AF_INET or AF_INET6
+    uint8_t state;           // TCP_* state number, also used for UDP
+    uint16_t local_port;     // host order
+    uint16_t remote_port;
+    uint8_t local_addr[16];  // first 4 bytes for AF_INET
+    uint8_t remote_addr[16];
+    uint32_t uid;
+    uint64_t inode;
+    // From INET_DIAG_INFO, TCP only; -1 when not requested or unavailable
+    int64_t rtt_us;
+    int64_t retransmits;
+    int64_t bytes_acked;
+    int64_t bytes_received;
+};
+
+/// NETLINK_SOCK_DIAG client. The kernel applies the state filter itself, so
+/// a LISTEN-only query never copies established sockets to user space. One
+/// socket is held open and requests are serialized on it.
+class SockDiag {
+public:
+    /// Bitmask of TCP states (1 << TCP_LISTEN etc.).
+    static constexpr uint32_t kAllStates = 0xffffffffu;
+
+    SockDiag();
+    ~SockDiag();
+
+    SockDiag(const SockDiag&) = delete;
+    SockDiag& operator=(const SockDiag&) = delete;
+
+    /// Process-wide instance.
+    static SockDiag& shared();
+
+    /// False if netlink sock_diag could not be opened.
+    bool available() const noexcept { return fd_ >= 0; }
+
+    /// Append sockets of `family` (AF_INET/AF_INET6) and `protocol`
+    /// (IPPROTO_TCP/IPPROTO_UDP) whose state is in `states`. Returns false,
+    /// leaving `out` as it was, if the kernel cannot answer this query
+    /// (no netlink, module not loaded, permission denied).
+    bool query(int family, int protocol, uint32_t states, bool tcp_info, std::vector<SocketRecord>& out);
+
+private:
+    int fd_ = -1;
+    uint32_t seq_ = 0;
+    std::vector<char> buf_;
+    std::mutex mtx_;
+};
+
+} // namespace agent_kernel
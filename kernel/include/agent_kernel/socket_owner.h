@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+#include "network.h"
+#include "process_events.h"
+#include "process_table.h"
+
+namespace agent_kernel {
+
+struct SocketOwner {
+    pid_t pid;
+    std::string name;
+};
+
+/// Maps socket inodes to the process holding them.
+///
+/// rebuild() reads every /proc/<pid>/fd once; after that only processes
+/// reported by a ProcessTable delta or process events are re-read (spawned
+/// and execed ones scanned, exited ones dropped). Sockets opened later by a
+/// long-running process show up as misses in annotate(), which re-reads the
+/// known socket owners and, at most once per `full_rescan_interval_ms`, the
+/// whole table. A socket shared across fork() is attributed to the lowest PID.
+class SocketOwnerIndex {
+public:
+    explicit SocketOwnerIndex(int full_rescan_interval_ms = 5000);
+
+    SocketOwnerIndex(const SocketOwnerIndex&) = delete;
+    SocketOwnerIndex& operator=(const SocketOwnerIndex&) = delete;
+
+    /// Re-read the fd tables of all processes.
+    void rebuild();
+
+    /// Follow a ProcessTable::diff() / update() result.
+    void apply(const ProcessDelta& delta);
+
+    /// Follow events from ProcessEventStream::poll().
+    void apply(const std::vector<ProcEvent>& events);
+
+    /// Re-read the fd tables of the given PIDs.
+    void refresh(const std::vector<pid_t>& pids);
+
+    /// Owner of a socket inode, if known.
+    bool lookup(uint64_t inode, SocketOwner& out) const;
+
+    /// Fill pid/process_name on `conns`, repairing misses as described
+    /// above. Returns how many connections were attributed.
+    size_t annotate(std::vector<ConnectionInfo>& conns);
+
+    /// Number of socket inodes indexed.
+    size_t size() const;
+
+private:
+    struct Process {
+        std::string name;
+        std::vector<uint64_t> inodes;
+    };
+
+    void scan_locked(pid_t pid);
+    void drop_locked(pid_t pid);
+    size_t annotate_locked(std::vector<ConnectionInfo>& conns, std::vector<uint64_t>* misses);
+
+    std::unordered_map<uint64_t, pid_t> owners_;
+    std::unordered_map<pid_t, Process> procs_;     // only processes owning sockets
+    std::unordered_set<uint64_t> unresolved_;      // misses since the last full rescan
+    std::chrono::milliseconds full_rescan_interval_;
+    std::chrono::steady_clock::time_point last_full_scan_{};
+    mutable std::mutex mtx_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "process.h"
+
+namespace agent_kernel {
+
+struct SpawnOptions {
+    std::string path;                       // executable, e.g. /bin/sh
+    std::vector<std::string> argv;
+    std::vector<std::string> env;           // KEY=VALUE pairs merged over environ
+    std::string working_dir;                // empty = inherit; chdir failure exits 126
+    ResourceLimits limits;
+    int stdin_fd = -1;                      // dup2'd onto fd 0 when >= 0
+    int stdout_fd = -1;                     // dup2'd onto fd 1 when >= 0
+    int stderr_fd = -1;                     // dup2'd onto fd 2 when >= 0
+    bool close_other_fds = false;           // close every fd above 2 before execve
+    int cgroup_procs_fd = -1;               // cgroup.procs to join before execve
+    bool new_process_group = false;         // setpgid(0, 0): lead a group of its own
+    bool child_subreaper = false;           // adopt orphaned descendants (PR_SET_CHILD_SUBREAPER)
+};
+
+/// Start a child with clone(CLONE_VM | CLONE_VFORK) instead of fork(), so
+/// spawn cost does not grow with the parent's page tables. argv/envp are
+/// built beforehand and the child issues only raw syscalls (dup2, close,
+/// write, chdir, setrlimit, setpgid, prctl, sigaction, execve). Signals are
+/// blocked across the clone and reset to default in the child. Throws std::runtime_error if the clone,
+/// joining the cgroup or the execve fails; in the last two cases the child
+/// has been reaped and the program never ran.
+pid_t spawn_process(const SpawnOptions& options);
+
+} // namespace agent_kernel
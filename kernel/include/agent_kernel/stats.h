@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace agent_kernel {
+
+/// Instrumented entry points. Names (Stats::probe_name) are "<area>.<call>".
+enum class Probe : uint8_t {
+    MetricsCpu,
+    MetricsMemory,
+    MetricsDisk,
+    MetricsAllDisks,
+    MetricsSnapshot,
+    ProcessListAll,
+    ProcessListColumns,
+    ProcessGetInfo,
+    ProcessChildren,
+    ProcessTree,
+    ProcessSubtree,
+    ProcessSpawn,
+    SandboxRun,
+    SandboxRunStreaming,
+    SandboxRunBatch,
+    SandboxPoolRun,
+    NetworkConnections,
+    NetworkConnectionColumns,
+    NetworkListeningPorts,
+    NetworkInterfaces,
+    NetworkParseTable,
+    FileSearch,
+    FileTail,
+    FileGrep,
+    FileDirSize,
+    kCount
+};
+
+/// System calls counted at the kernel's own call sites (not libc's).
+enum class Syscall : uint8_t {
+    Open,       // openat
+    Read,       // read/pread
+    Getdents,
+    Stat,       // fstatat
+    Send,       // netlink sendto
+    Recv,       // netlink recv
+    Clone,      // process creation
+    kCount
+};
+
+/// One probe's totals. Latencies land in log-linear buckets: everything
+/// under 1.024 µs in bucket 0, then four per power of two up to ~137 s, so
+/// a bucket's bounds are within 25% of each other.
+struct ProbeStats {
+    std::string name;
+    uint64_t calls = 0;
+    uint64_t errors = 0;        // calls that left by an exception
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    std::vector<uint64_t> buckets;
+
+    /// Upper bound of the bucket holding the q-th quantile (0..1); 0 without calls.
+    uint64_t quantile_ns(double q) const;
+};
+
+struct KernelStats {
+    std::vector<ProbeStats> probes;      // Probe order, including unused ones
+    std::vector<std::pair<std::string, uint64_t>> syscalls;   // Syscall order
+    uint64_t procfs_bytes = 0;           // read from procfs, sysfs and cgroupfs
+    size_t threads = 0;                  // threads that have recorded anything, alive or not
+};
+
+/// Always-on counters for the kernel's hot paths.
+///
+/// Each thread records into its own block of single-writer atomics, so the
+/// recording side is a relaxed load and store per counter with no sharing;
+/// snapshot() sums every live block plus the totals of exited threads.
+/// Counters only grow.
+class Stats {
+public:
+    static constexpr size_t kBuckets = 109;
+
+    static void record_call(Probe p, uint64_t ns, bool failed) noexcept;
+    static void count(Syscall s, uint64_t n = 1) noexcept;
+    static void count_procfs_bytes(uint64_t n) noexcept;
+
+    static KernelStats snapshot();
+
+    /// snapshot() in the Prometheus text exposition format.
+    static std::string prometheus();
+
+    static const char* probe_name(Probe p) noexcept;
+    static const char* syscall_name(Syscall s) noexcept;
+    static size_t bucket_index(uint64_t ns) noexcept;
+    static uint64_t bucket_upper_ns(size_t index) noexcept;
+};
+
+/// Times the enclosing scope as one call of `probe`; an exception unwinding
+/// through it counts as an error.
+class ProbeTimer {
+public:
+    explicit ProbeTimer(Probe probe) noexcept
+        : probe_(probe), exceptions_(std::uncaught_exceptions()),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~ProbeTimer() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        Stats::record_call(probe_, static_cast<uint64_t>(ns), std::uncaught_exceptions() > exceptions_);
+    }
+
+    ProbeTimer(const ProbeTimer&) = delete;
+    ProbeTimer& operator=(const ProbeTimer&) = delete;
+
+private:
+    Probe probe_;
+    int exceptions_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "fs_watcher.h"
+
+namespace agent_kernel {
+
+/// `tail -f`: hands out the bytes appended to a file since the last read.
+///
+/// Keeps the file open with a saved offset and waits on FSWatcher IN_MODIFY
+/// instead of polling. A file that shrinks is read again from the start; a
+/// file replaced under the same name (log rotation) is drained to its end
+/// and then followed at the new inode.
+class TailFollower {
+public:
+    /// Follow `path` from its current end, or from the start with
+    /// `from_end` false. Throws std::runtime_error if it cannot be opened.
+    explicit TailFollower(const std::string& path, bool from_end = true);
+    ~TailFollower();
+
+    TailFollower(const TailFollower&) = delete;
+    TailFollower& operator=(const TailFollower&) = delete;
+
+    /// Up to max_bytes of new data, waiting up to timeout_ms for some to
+    /// arrive when there is none. Empty if nothing was appended.
+    std::string read(int timeout_ms = 0, size_t max_bytes = 64 * 1024);
+
+    /// Byte offset of the next read in the current file.
+    uint64_t offset() const;
+
+    const std::string& path() const noexcept { return path_; }
+
+private:
+    std::string read_available(size_t max_bytes);
+    bool reopen_if_rotated();
+
+    std::string path_;
+    int fd_ = -1;
+    dev_t dev_ = 0;
+    ino_t ino_ = 0;
+    uint64_t offset_ = 0;
+    int file_wd_ = -1;
+    FSWatcher watcher_;
+    std::vector<FSEvent> events_;
+    mutable std::mutex mtx_;
+};
+
+} // namespace agent_kernel
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agent_kernel {
+
+/// Small persistent worker pool shared by the kernel's parallel scans.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Queue a task for any worker. Tasks must not throw.
+    void submit(std::function<void()> task);
+
+    /// Run fn(i) for every i in [0, n) and return once all have finished.
+    /// The calling thread claims work too, so this never deadlocks when the
+    /// pool is saturated or when called from inside a pool task. The first
+    /// exception thrown by fn is rethrown here.
+    void parallel_for(size_t n, const std::function<void(size_t)>& fn);
+
+    /// Number of worker threads.
+    unsigned size() const noexcept;
+
+    /// Process-wide pool of usable_cpus() - 1 workers (at least one),
+    /// created on first use.
+    static ThreadPool& shared();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+/// CPUs this process may actually use: the smallest of the online CPU count,
+/// the scheduler affinity mask and the cgroup CPU quota (rounded up).
+unsigned usable_cpus();
+
+} // namespace agent_kernel
@@ -0,0 +1,47 @@
+#!/bin/bash
+# Optimized release build of the kernel: LTO, hidden visibility, PGO trained
+# on agent_kernel_bench, and -march variants picked by app/kernel_loader.py.
+#
+#   scripts/build_release.sh [build-dir]
+#
+# PGO=0 skips profiling. MARCH_VARIANTS overrides the variant list (default
+# x86-64-v2..v4 on x86_64, none elsewhere; empty for none). JOBS sets the
+# build parallelism.
+set -euo pipefail
+cd "$(dirname "$0")/.."
+
+BUILD=${1:-build}
+JOBS=${JOBS:-$(nproc)}
+PGO=${PGO:-1}
+if [ "$(uname -m)" = x86_64 ]; then
+    default_variants="x86-64-v2;x86-64-v3;x86-64-v4"
+else
+    default_variants=""
+fi
+MARCH_VARIANTS=${MARCH_VARIANTS-$default_variants}
+
+common=(-DCMAKE_BUILD_TYPE=Release -DAGENT_KERNEL_LTO=ON "-DAGENT_KERNEL_MARCH_VARIANTS=$MARCH_VARIANTS")
+
+if [ "$PGO" = 1 ]; then
+    # Profiles are matched by object path, so training and the final build
+    # share this tree.
+    rm -rf "$BUILD/pgo"
+    cmake -S . -B "$BUILD" "${common[@]}" -DAGENT_KERNEL_BUILD_BENCH=ON -DAGENT_KERNEL_PGO=GENERATE
+    cmake --build "$BUILD" -j"$JOBS" --target agent_kernel_bench
+    if ! "$BUILD/agent_kernel_bench" --scale 0.3 > "$BUILD/pgo-training.txt"; then
+        echo "warning: some training suites failed; see $BUILD/pgo-training.txt" >&2
+    fi
+    # Clang writes raw profiles that must be merged first
+    if compgen -G "$BUILD/pgo/*.profraw" > /dev/null; then
+        llvm-profdata merge -o "$BUILD/pgo/agent_kernel.profdata" "$BUILD"/pgo/*.profraw
+    fi
+    cmake -S . -B "$BUILD" -DAGENT_KERNEL_PGO=USE
+else
+    cmake -S . -B "$BUILD" "${common[@]}" -DAGENT_KERNEL_PGO=
+fi
+cmake --build "$BUILD" -j"$JOBS"
+
+echo "module:   $(ls "$BUILD"/agent_kernel*.so)"
+for dir in "$BUILD"/variants/*/; do
+    [ -d "$dir" ] && echo "variant:  $(ls "$dir"agent_kernel*.so)"
+done
@@ -1,116 +1,534 @@
 #include "agent_kernel/cgroup.h"
+#include "agent_kernel/proc_file.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <mutex>
 #include <sstream>
-#include <cstdlib>
-#include <sys/stat.h>
+#include <vector>
 
 namespace agent_kernel {
 
 namespace {
 
-std::string read_first_line(const std::string& path) {
-    std::ifstream f(path);
+bool file_exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::istringstream iss(s);
+    std::string item;
+    while (std::getline(iss, item, sep)) out.push_back(item);
+    return out;
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo.
+std::string unescape_octal(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '\\' && i + 3 < s.size()) {
+            out.push_back(static_cast<char>(std::strtol(s.substr(i + 1, 3).c_str(), nullptr, 8)));
+            i += 3;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+struct CgroupMount {
+    std::string root;                      // hierarchy path mounted at `point`
+    std::string point;
+    bool v2;
+    std::vector<std::string> controllers;  // v1 super options
+};
+
+std::vector<CgroupMount> cgroup_mounts() {
+    std::vector<CgroupMount> mounts;
+    std::ifstream f("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(f, line)) {
+        // id parent maj:min root point opts [optional...] - fstype source superopts
+        size_t dash = line.find(" - ");
+        if (dash == std::string::npos) continue;
+        std::istringstream pre(line.substr(0, dash)), post(line.substr(dash + 3));
+        std::string id, parent, dev, root, point, fstype, source, superopts;
+        pre >> id >> parent >> dev >> root >> point;
+        post >> fstype >> source >> superopts;
+        if (fstype != "cgroup" && fstype != "cgroup2") continue;
+        CgroupMount m{unescape_octal(root), unescape_octal(point), fstype == "cgroup2", {}};
+        if (!m.v2) m.controllers = split(superopts, ',');
+        mounts.push_back(std::move(m));
+    }
+    return mounts;
+}
+
+// Directory of cgroup `path` (as listed in /proc/self/cgroup) under mount m.
+// Without a cgroup namespace the mount root is a prefix of the path.
+std::string cgroup_dir(const CgroupMount& m, std::string path) {
+    if (m.root != "/" && path.compare(0, m.root.size(), m.root) == 0) path.erase(0, m.root.size());
+    if (path == "/") path.clear();
+    return m.point + path;
+}
+
+CgroupLocation resolve_location() {
+    CgroupLocation loc;
+    std::vector<CgroupMount> mounts = cgroup_mounts();
+    bool any_v1 = false;
+
+    std::ifstream f("/proc/self/cgroup");
     std::string line;
-    if (f.is_open()) std::getline(f, line);
-    return line;
+    while (std::getline(f, line)) {
+        size_t a = line.find(':');
+        size_t b = a == std::string::npos ? a : line.find(':', a + 1);
+        if (b == std::string::npos) continue;
+        std::vector<std::string> controllers = split(line.substr(a + 1, b - a - 1), ',');
+        std::string path = line.substr(b + 1);
+
+        if (controllers.empty()) {
+            for (const auto& m : mounts) {
+                if (m.v2) {
+                    loc.unified = cgroup_dir(m, path);
+                    break;
+                }
+            }
+            continue;
+        }
+        for (const auto& m : mounts) {
+            if (m.v2 || std::find(m.controllers.begin(), m.controllers.end(), controllers[0]) == m.controllers.end()) {
+                continue;
+            }
+            std::string dir = cgroup_dir(m, path);
+            for (const auto& c : controllers) {
+                std::string* slot = c == "memory" ? &loc.memory : c == "cpu" ? &loc.cpu : c == "cpuacct" ? &loc.cpuacct
+                                  : c == "pids" ? &loc.pids : c == "blkio" ? &loc.io : nullptr;
+                if (slot) {
+                    *slot = dir;
+                    any_v1 = true;
+                }
+            }
+            break;
+        }
+    }
+
+    // Controllers not claimed by v1 live in the v2 directory when bound there
+    if (!loc.unified.empty()) {
+        std::ifstream cf(loc.unified + "/cgroup.controllers");
+        std::string available;
+        std::getline(cf, available);
+        for (const auto& c : split(available, ' ')) {
+            std::string* slot = c == "memory" ? &loc.memory : c == "cpu" ? &loc.cpu
+                              : c == "pids" ? &loc.pids : c == "io" ? &loc.io : nullptr;
+            if (slot && slot->empty()) *slot = loc.unified;
+        }
+    }
+
+    loc.version = any_v1 ? 1 : loc.unified.empty() ? 0 : 2;
+    return loc;
+}
+
+int open_dir(const std::string& path) {
+    if (path.empty()) return -1;
+    return open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
 }
 
-int64_t read_int64(const std::string& path, int64_t fallback = -1) {
-    std::string line = read_first_line(path);
-    if (line.empty() || line == "max") return fallback;
-    try {
-        return std::stoll(line);
-    } catch (...) {
-        return fallback;
+// First number in the file; -1 if missing, empty or "max".
+int64_t first_int(ProcFile& f) {
+    if (!f.read() || f.size() == 0) return -1;
+    FieldCursor cur = f.cursor();
+    if (cur.consume("max")) return -1;
+    return cur.next_int();
+}
+
+// Value of a "key value" line in the last read of f; -1 if absent.
+int64_t stat_field(const ProcFile& f, const char* key) {
+    FieldCursor cur = f.cursor();
+    while (!cur.at_end()) {
+        if (cur.consume(key) && cur.consume(" ")) return static_cast<int64_t>(cur.next_uint());
+        cur.next_line();
     }
+    return -1;
 }
 
-bool file_exists(const std::string& path) {
-    struct stat st;
-    return stat(path.c_str(), &st) == 0;
+// v1 blkio "MAJ:MIN Op Value" lines: sum of `op` over devices, -1 if unreadable.
+int64_t blkio_sum(ProcFile& f, const char* op) {
+    if (!f.read()) return -1;
+    int64_t total = 0;
+    size_t op_len = std::strlen(op);
+    for (FieldCursor cur = f.cursor(); !cur.at_end(); cur.next_line()) {
+        if (cur.consume("Total")) continue;
+        cur.skip_field();
+        cur.skip_spaces();
+        if (static_cast<size_t>(cur.end - cur.p) <= op_len || std::strncmp(cur.p, op, op_len) != 0 ||
+            cur.p[op_len] != ' ') {
+            continue;
+        }
+        cur.p += op_len;
+        total += static_cast<int64_t>(cur.next_uint());
+    }
+    return total;
 }
 
-int detect_cgroup_version() {
-    // cgroup v2 has a unified hierarchy
-    if (file_exists("/sys/fs/cgroup/cgroup.controllers")) return 2;
-    // cgroup v1 has separate controllers
-    if (file_exists("/sys/fs/cgroup/memory/memory.limit_in_bytes")) return 1;
-    return 0;
+/// Controller files of this process's cgroup, held open for the process
+/// lifetime. Directory fds come first so the files can be opened against them.
+struct CgroupFiles {
+    const bool memory_v1, cpu_v1, io_v1;
+    const int unified_dir, memory_dir, cpu_dir, cpuacct_dir, pids_dir, io_dir;
+
+    ProcFile memory_max, memory_current, memory_stat;
+    ProcFile cpu_max, cfs_quota, cfs_period, cpu_stat, cpuacct_usage;
+    ProcFile pids_max, pids_current;
+    ProcFile io_stat, io_service_bytes, io_serviced;
+
+    std::mutex mtx;   // ProcFile buffers are not shareable
+
+    explicit CgroupFiles(const CgroupLocation& loc)
+        : memory_v1(!loc.memory.empty() && loc.memory != loc.unified),
+          cpu_v1(!loc.cpu.empty() && loc.cpu != loc.unified),
+          io_v1(!loc.io.empty() && loc.io != loc.unified),
+          unified_dir(open_dir(loc.unified)),
+          memory_dir(open_dir(loc.memory)),
+          cpu_dir(open_dir(loc.cpu)),
+          cpuacct_dir(open_dir(loc.cpuacct)),
+          pids_dir(open_dir(loc.pids)),
+          io_dir(open_dir(loc.io)),
+          memory_max(memory_dir, memory_v1 ? "memory.limit_in_bytes" : "memory.max", 64),
+          memory_current(memory_dir, memory_v1 ? "memory.usage_in_bytes" : "memory.current", 64),
+          memory_stat(memory_dir, "memory.stat"),
+          cpu_max(cpu_v1 ? -1 : cpu_dir, "cpu.max", 64),
+          cfs_quota(cpu_v1 ? cpu_dir : -1, "cpu.cfs_quota_us", 64),
+          cfs_period(cpu_v1 ? cpu_dir : -1, "cpu.cfs_period_us", 64),
+          // v2 keeps cpu.stat (usage) even without the cpu controller
+          cpu_stat(cpu_v1 ? cpu_dir : unified_dir, "cpu.stat", 512),
+          cpuacct_usage(cpuacct_dir, "cpuacct.usage", 64),
+          pids_max(pids_dir, "pids.max", 64),
+          pids_current(pids_dir, "pids.current", 64),
+          io_stat(io_v1 ? -1 : io_dir, "io.stat"),
+          io_service_bytes(io_v1 ? io_dir : -1, "blkio.throttle.io_service_bytes"),
+          io_serviced(io_v1 ? io_dir : -1, "blkio.throttle.io_serviced") {}
+};
+
+// Parent for transient cgroups and the controllers its children get,
+// resolved once. `dir` is empty if unusable.
+struct TransientParent {
+    std::string dir;
+    bool memory = false;
+    bool cpu = false;
+    bool pids = false;
+};
+
+const TransientParent& transient_parent() {
+    static const TransientParent parent = [] {
+        TransientParent p;
+        std::string dir;
+        if (const char* env = std::getenv("AGENT_KERNEL_CGROUP_ROOT")) {
+            dir = env;
+        } else if (CgroupManager::location().version == 2) {
+            // On hybrid systems the controllers are bound to v1
+            dir = CgroupManager::location().unified;
+        }
+        while (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+        if (dir.empty() || !file_exists(dir + "/cgroup.controllers") || access(dir.c_str(), W_OK) != 0) {
+            return p;
+        }
+        // Fails with EBUSY while the parent itself holds processes; the
+        // controllers may already be enabled by whoever delegated it, so
+        // what counts is what subtree_control says afterwards.
+        std::string control = dir + "/cgroup.subtree_control";
+        for (const char* c : {"+memory", "+cpu", "+pids"}) {
+            int fd = open(control.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0) break;
+            ssize_t n = write(fd, c, std::strlen(c));
+            (void)n;
+            close(fd);
+        }
+        std::ifstream f(control);
+        for (std::string c; f >> c;) {
+            if (c == "memory") p.memory = true;
+            else if (c == "cpu") p.cpu = true;
+            else if (c == "pids") p.pids = true;
+        }
+        p.dir = dir;
+        return p;
+    }();
+    return parent;
+}
+
+bool write_at(int dir_fd, const char* file, const std::string& value) {
+    int fd = openat(dir_fd, file, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return ok;
+}
+
+std::string read_at(int dir_fd, const char* file) {
+    int fd = openat(dir_fd, file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return {};
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) out.append(buf, static_cast<size_t>(n));
+    close(fd);
+    return out;
 }
 
 } // anonymous namespace
 
 bool CgroupManager::is_in_container() {
-    // Check for Docker
-    if (file_exists("/.dockerenv")) return true;
+    static const bool in_container = [] {
+        // Check for Docker
+        if (file_exists("/.dockerenv")) return true;
 
-    // Check for container indicators in cgroup
-    std::ifstream f("/proc/1/cgroup");
-    if (!f.is_open()) return false;
-    std::string line;
-    while (std::getline(f, line)) {
-        if (line.find("docker") != std::string::npos ||
-            line.find("kubepods") != std::string::npos ||
-            line.find("containerd") != std::string::npos ||
-            line.find("lxc") != std::string::npos) {
-            return true;
+        // Check for container indicators in cgroup
+        std::ifstream f("/proc/1/cgroup");
+        std::string line;
+        while (std::getline(f, line)) {
+            if (line.find("docker") != std::string::npos ||
+                line.find("kubepods") != std::string::npos ||
+                line.find("containerd") != std::string::npos ||
+                line.find("lxc") != std::string::npos) {
+                return true;
+            }
         }
-    }
 
-    // Check for container env
-    return std::getenv("container") != nullptr;
+        // Check for container env
+        return std::getenv("container") != nullptr;
+    }();
+    return in_container;
+}
+
+const CgroupLocation& CgroupManager::location() {
+    static const CgroupLocation loc = resolve_location();
+    return loc;
 }
 
 CgroupInfo CgroupManager::info() {
+    static CgroupFiles files(location());
+
     CgroupInfo cg{};
-    cg.cgroup_version = detect_cgroup_version();
+    cg.cgroup_version = location().version;
     cg.is_containerized = is_in_container();
-    cg.memory_limit_bytes = -1;
-    cg.memory_usage_bytes = -1;
     cg.cpu_quota = -1.0;
-    cg.pids_limit = -1;
-    cg.pids_current = -1;
-
-    if (cg.cgroup_version == 2) {
-        // cgroup v2 paths
-        cg.memory_limit_bytes = read_int64("/sys/fs/cgroup/memory.max", -1);
-        cg.memory_usage_bytes = read_int64("/sys/fs/cgroup/memory.current", -1);
-
-        // cpu.max format: "$MAX $PERIOD" or "max $PERIOD"
-        std::string cpu_max = read_first_line("/sys/fs/cgroup/cpu.max");
-        if (!cpu_max.empty() && cpu_max.substr(0, 3) != "max") {
-            std::istringstream iss(cpu_max);
-            int64_t quota, period;
-            iss >> quota >> period;
-            if (period > 0) {
-                cg.cpu_quota = static_cast<double>(quota) / static_cast<double>(period);
+
+    std::lock_guard<std::mutex> lock(files.mtx);
+
+    // Memory; v1 reports "unlimited" as a huge value (typically 9223372036854771712)
+    cg.memory_limit_bytes = first_int(files.memory_max);
+    if (cg.memory_limit_bytes >= (1LL << 60)) cg.memory_limit_bytes = -1;
+    cg.memory_usage_bytes = first_int(files.memory_current);
+    cg.memory_anon_bytes = cg.memory_file_bytes = -1;
+    if (files.memory_stat.read()) {
+        cg.memory_anon_bytes = stat_field(files.memory_stat, files.memory_v1 ? "rss" : "anon");
+        cg.memory_file_bytes = stat_field(files.memory_stat, files.memory_v1 ? "cache" : "file");
+    }
+
+    // CPU quota: cpu.max is "$MAX $PERIOD" or "max $PERIOD"
+    if (files.cpu_v1) {
+        int64_t quota = first_int(files.cfs_quota), period = first_int(files.cfs_period);
+        if (quota > 0 && period > 0) cg.cpu_quota = static_cast<double>(quota) / static_cast<double>(period);
+    } else if (files.cpu_max.read() && files.cpu_max.size()) {
+        FieldCursor cur = files.cpu_max.cursor();
+        if (!cur.consume("max")) {
+            int64_t quota = cur.next_int(), period = cur.next_int();
+            if (period > 0) cg.cpu_quota = static_cast<double>(quota) / static_cast<double>(period);
+        }
+    }
+
+    cg.cpu_usage_usec = cg.cpu_nr_periods = cg.cpu_nr_throttled = cg.cpu_throttled_usec = -1;
+    if (files.cpu_stat.read()) {
+        cg.cpu_nr_periods = stat_field(files.cpu_stat, "nr_periods");
+        cg.cpu_nr_throttled = stat_field(files.cpu_stat, "nr_throttled");
+        if (files.cpu_v1) {
+            int64_t ns = stat_field(files.cpu_stat, "throttled_time");
+            cg.cpu_throttled_usec = ns < 0 ? -1 : ns / 1000;
+        } else {
+            cg.cpu_usage_usec = stat_field(files.cpu_stat, "usage_usec");
+            cg.cpu_throttled_usec = stat_field(files.cpu_stat, "throttled_usec");
+        }
+    }
+    if (cg.cpu_usage_usec < 0) {
+        int64_t ns = first_int(files.cpuacct_usage);
+        cg.cpu_usage_usec = ns < 0 ? -1 : ns / 1000;
+    }
+
+    cg.pids_limit = first_int(files.pids_max);
+    cg.pids_current = first_int(files.pids_current);
+
+    // I/O: v2 "MAJ:MIN rbytes=N wbytes=N rios=N wios=N ..." per device
+    cg.io_read_bytes = cg.io_write_bytes = cg.io_read_ops = cg.io_write_ops = -1;
+    if (files.io_v1) {
+        cg.io_read_bytes = blkio_sum(files.io_service_bytes, "Read");
+        cg.io_write_bytes = blkio_sum(files.io_service_bytes, "Write");
+        cg.io_read_ops = blkio_sum(files.io_serviced, "Read");
+        cg.io_write_ops = blkio_sum(files.io_serviced, "Write");
+    } else if (files.io_stat.read()) {
+        cg.io_read_bytes = cg.io_write_bytes = cg.io_read_ops = cg.io_write_ops = 0;
+        for (FieldCursor cur = files.io_stat.cursor(); !cur.at_end(); cur.next_line()) {
+            cur.skip_field();   // MAJ:MIN
+            for (;;) {
+                cur.skip_spaces();
+                if (cur.at_end() || *cur.p == '\n') break;
+                int64_t* slot = cur.consume("rbytes=") ? &cg.io_read_bytes
+                              : cur.consume("wbytes=") ? &cg.io_write_bytes
+                              : cur.consume("rios=")   ? &cg.io_read_ops
+                              : cur.consume("wios=")   ? &cg.io_write_ops : nullptr;
+                if (slot) {
+                    *slot += static_cast<int64_t>(cur.next_uint());
+                } else {
+                    cur.skip_field();
+                }
             }
         }
+    }
+
+    return cg;
+}
+
+// ── TransientCgroup ─────────────────────────────────────────────────────
+
+TransientCgroup::TransientCgroup(std::string path, int dir_fd, int procs_fd)
+    : path_(std::move(path)), dir_fd_(dir_fd), procs_fd_(procs_fd) {}
 
-        cg.pids_limit = read_int64("/sys/fs/cgroup/pids.max", -1);
-        cg.pids_current = read_int64("/sys/fs/cgroup/pids.current", -1);
+std::unique_ptr<TransientCgroup> TransientCgroup::create(const Limits& limits) {
+    const TransientParent& parent = transient_parent();
+    // Set once a cgroup could not be made at all: every later attempt would
+    // fail the same way, so stop paying for it.
+    static std::atomic<bool> unusable{false};
+    if (parent.dir.empty() || unusable.load(std::memory_order_relaxed)) return nullptr;
 
-    } else if (cg.cgroup_version == 1) {
-        // cgroup v1 paths
-        int64_t mem_limit = read_int64("/sys/fs/cgroup/memory/memory.limit_in_bytes", -1);
-        // Huge value means unlimited (typically 9223372036854771712)
-        if (mem_limit > 0 && mem_limit < (1LL << 60)) {
-            cg.memory_limit_bytes = mem_limit;
+    // A limit we cannot apply makes the cgroup pointless; let the caller
+    // fall back to rlimits instead.
+    if ((limits.memory_max >= 0 && !parent.memory) || (limits.cpu_max > 0 && !parent.cpu) ||
+        (limits.pids_max >= 0 && !parent.pids)) {
+        return nullptr;
+    }
+
+    static std::atomic<uint64_t> counter{0};
+    std::string path = parent.dir + "/agent-kernel-" + std::to_string(getpid()) + "-" +
+                       std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+    if (mkdir(path.c_str(), 0755) != 0) {
+        if (errno != EEXIST) unusable.store(true, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    int dir_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int procs_fd = dir_fd >= 0 ? openat(dir_fd, "cgroup.procs", O_WRONLY | O_CLOEXEC) : -1;
+    std::unique_ptr<TransientCgroup> cg(new TransientCgroup(path, dir_fd, procs_fd));
+    if (procs_fd < 0) {
+        unusable.store(true, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (limits.memory_max >= 0 && !write_at(dir_fd, "memory.max", std::to_string(limits.memory_max))) {
+        return nullptr;
+    }
+    if (limits.cpu_max > 0) {
+        const int64_t period = 100000;
+        auto quota = static_cast<int64_t>(limits.cpu_max * static_cast<double>(period));
+        if (quota < 1000) quota = 1000;  // kernel minimum
+        if (!write_at(dir_fd, "cpu.max", std::to_string(quota) + " " + std::to_string(period))) {
+            return nullptr;
         }
-        cg.memory_usage_bytes = read_int64("/sys/fs/cgroup/memory/memory.usage_in_bytes", -1);
+    }
+    if (limits.pids_max >= 0 && !write_at(dir_fd, "pids.max", std::to_string(limits.pids_max))) {
+        return nullptr;
+    }
+    // No swap, so memory.max is a hard ceiling rather than a swap trigger.
+    if (limits.memory_max >= 0) write_at(dir_fd, "memory.swap.max", "0");
+    return cg;
+}
 
-        int64_t cfs_quota = read_int64("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", -1);
-        int64_t cfs_period = read_int64("/sys/fs/cgroup/cpu/cpu.cfs_period_us", 100000);
-        if (cfs_quota > 0 && cfs_period > 0) {
-            cg.cpu_quota = static_cast<double>(cfs_quota) / static_cast<double>(cfs_period);
+TransientCgroup::~TransientCgroup() {
+    if (procs_fd_ >= 0) close(procs_fd_);
+    if (dir_fd_ >= 0) {
+        kill_all();
+        // Members exit asynchronously after SIGKILL; rmdir fails with EBUSY
+        // until cgroup.events reports "populated 0", which it signals with
+        // POLLPRI instead of making us spin on rmdir.
+        int events_fd = openat(dir_fd_, "cgroup.events", O_RDONLY | O_CLOEXEC);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        while (events_fd >= 0) {
+            char buf[256];
+            ssize_t n = pread(events_fd, buf, sizeof(buf) - 1, 0);
+            if (n < 0) break;
+            buf[n] = '\0';
+            if (std::strstr(buf, "populated 0")) break;
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) break;
+            // Catches anything forked past the previous SIGKILL round.
+            kill_all();
+            struct pollfd pfd{events_fd, POLLPRI, 0};
+            poll(&pfd, 1, static_cast<int>(std::min<long long>(left, 10)));
         }
+        if (events_fd >= 0) close(events_fd);
+        close(dir_fd_);
+    }
+    rmdir(path_.c_str());
+}
 
-        cg.pids_limit = read_int64("/sys/fs/cgroup/pids/pids.max", -1);
-        cg.pids_current = read_int64("/sys/fs/cgroup/pids/pids.current", -1);
+int TransientCgroup::procs_fd() const noexcept {
+    return procs_fd_;
+}
+
+const std::string& TransientCgroup::path() const noexcept {
+    return path_;
+}
+
+void TransientCgroup::kill_all() {
+    if (write_at(dir_fd_, "cgroup.kill", "1")) return;
+    // Pre-5.14 kernels: one SIGKILL round over the current members
+    std::string procs = read_at(dir_fd_, "cgroup.procs");
+    const char* p = procs.c_str();
+    char* end = nullptr;
+    for (long pid = std::strtol(p, &end, 10); end != p; pid = std::strtol(p, &end, 10)) {
+        if (pid > 0) ::kill(static_cast<pid_t>(pid), SIGKILL);
+        p = end;
     }
+}
 
-    return cg;
+int64_t TransientCgroup::read_stat(const char* file, const char* key) const {
+    std::string content = read_at(dir_fd_, file);
+    size_t key_len = std::strlen(key);
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t eol = content.find('\n', pos);
+        if (eol == std::string::npos) eol = content.size();
+        if (eol - pos > key_len && content.compare(pos, key_len, key) == 0 && content[pos + key_len] == ' ') {
+            return std::strtoll(content.c_str() + pos + key_len + 1, nullptr, 10);
+        }
+        pos = eol + 1;
+    }
+    return -1;
+}
+
+int64_t TransientCgroup::memory_peak_bytes() const {
+    std::string peak = read_at(dir_fd_, "memory.peak");
+    if (peak.empty()) return -1;
+    return std::strtoll(peak.c_str(), nullptr, 10);
+}
+
+int64_t TransientCgroup::cpu_usage_usec() const {
+    return read_stat("cpu.stat", "usage_usec");
+}
+
+int64_t TransientCgroup::cpu_throttled_usec() const {
+    return read_stat("cpu.stat", "throttled_usec");
 }
 
 } // namespace agent_kernel
@@ -0,0 +1,314 @@
+#include "agent_kernel/cgroup_watcher.h"
+#include "agent_kernel/cgroup.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace agent_kernel {
+
+namespace {
+
+bool file_exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+// Whole file through pread at offset 0, so held fds can be re-read.
+std::string read_fd(int fd) {
+    std::string out;
+    char buf[4096];
+    for (off_t off = 0;;) {
+        ssize_t n = pread(fd, buf, sizeof(buf), off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out.append(buf, static_cast<size_t>(n));
+        off += n;
+    }
+    return out;
+}
+
+// Value of a "key value" line, or -1.
+int64_t stat_value(const std::string& content, const char* key) {
+    size_t key_len = std::strlen(key);
+    for (size_t pos = 0; pos < content.size();) {
+        size_t eol = content.find('\n', pos);
+        if (eol == std::string::npos) eol = content.size();
+        if (eol - pos > key_len && content.compare(pos, key_len, key) == 0 && content[pos + key_len] == ' ') {
+            return std::strtoll(content.c_str() + pos + key_len + 1, nullptr, 10);
+        }
+        pos = eol + 1;
+    }
+    return -1;
+}
+
+PressureStats parse_pressure(const std::string& content) {
+    PressureStats p;
+    const char* some = std::strstr(content.c_str(), "some ");
+    const char* full = std::strstr(content.c_str(), "full ");
+    long long total = -1;
+    if (some && std::sscanf(some, "some avg10=%lf avg60=%lf avg300=%*f total=%lld",
+                            &p.some_avg10, &p.some_avg60, &total) == 3) {
+        p.some_total_us = total;
+    }
+    if (full && std::sscanf(full, "full avg10=%lf avg60=%lf avg300=%*f total=%lld",
+                            &p.full_avg10, &p.full_avg60, &total) == 3) {
+        p.full_total_us = total;
+    }
+    return p;
+}
+
+const char* pressure_resource(CgroupEventType type) {
+    switch (type) {
+    case CgroupEventType::MemoryPressure: return "memory";
+    case CgroupEventType::CpuPressure:    return "cpu";
+    case CgroupEventType::IoPressure:     return "io";
+    default:                              return nullptr;
+    }
+}
+
+int64_t now_ms() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+CgroupWatcher::CgroupWatcher(const std::string& cgroup_dir) {
+    if (cgroup_dir.empty()) {
+        const CgroupLocation& loc = CgroupManager::location();
+        path_ = loc.unified;
+        if (loc.memory != loc.unified) memory_v1_ = loc.memory;
+        if (loc.cpu != loc.unified) cpu_v1_ = loc.cpu;
+    } else {
+        if (file_exists(cgroup_dir + "/cgroup.controllers")) path_ = cgroup_dir;
+        if (file_exists(cgroup_dir + "/memory.oom_control")) memory_v1_ = cgroup_dir;
+        if (file_exists(cgroup_dir + "/cpu.cfs_quota_us")) cpu_v1_ = cgroup_dir;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+}
+
+CgroupWatcher::~CgroupWatcher() {
+    for (const auto& s : sources_) {
+        close(s.fd);
+        if (s.stats_fd >= 0) close(s.stats_fd);
+    }
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+void CgroupWatcher::add_source(Source s, uint32_t events) {
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.u32 = static_cast<uint32_t>(sources_.size());
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, s.fd, &ev) != 0) {
+        int err = errno;
+        close(s.fd);
+        if (s.stats_fd >= 0) close(s.stats_fd);
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(err));
+    }
+    sources_.push_back(s);
+}
+
+bool CgroupWatcher::add_pressure_trigger(CgroupEventType resource, int64_t stall_us, int64_t window_us, bool full) {
+    const char* name = pressure_resource(resource);
+    if (!name) return false;
+
+    std::vector<std::string> candidates;
+    if (!path_.empty()) candidates.push_back(path_ + "/" + name + ".pressure");
+    candidates.push_back(std::string("/proc/pressure/") + name);
+
+    // Without CAP_SYS_RESOURCE the kernel only accepts windows that are a
+    // multiple of 2 s; the fallback keeps the same stall ratio.
+    constexpr int64_t kUnprivilegedWindowUs = 2000000;
+    int64_t rounded_window = (window_us + kUnprivilegedWindowUs - 1) / kUnprivilegedWindowUs * kUnprivilegedWindowUs;
+    int64_t rounded_stall = window_us > 0 ? stall_us * rounded_window / window_us : stall_us;
+    char trigger[64], fallback[64];
+    int len = std::snprintf(trigger, sizeof(trigger), "%s %lld %lld", full ? "full" : "some",
+                            static_cast<long long>(stall_us), static_cast<long long>(window_us));
+    int fallback_len = std::snprintf(fallback, sizeof(fallback), "%s %lld %lld", full ? "full" : "some",
+                                     static_cast<long long>(rounded_stall), static_cast<long long>(rounded_window));
+    for (const auto& file : candidates) {
+        int fd = open(file.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        // The trailing NUL is part of the trigger syntax
+        bool armed = write(fd, trigger, static_cast<size_t>(len) + 1) >= 0;
+        if (!armed && errno == EINVAL && rounded_window != window_us) {
+            armed = write(fd, fallback, static_cast<size_t>(fallback_len) + 1) >= 0;
+        }
+        if (!armed) {
+            close(fd);
+            continue;
+        }
+        int stats_fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        add_source(Source{Kind::Trigger, resource, fd, stats_fd}, EPOLLPRI);
+        return true;
+    }
+    return false;
+}
+
+bool CgroupWatcher::watch_memory_events() {
+    if (!path_.empty()) {
+        int fd = open((path_ + "/memory.events").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            std::string content = read_fd(fd);   // also arms the notification
+            prev_high_ = std::max<int64_t>(stat_value(content, "high"), 0);
+            prev_max_ = std::max<int64_t>(stat_value(content, "max"), 0);
+            prev_oom_ = std::max<int64_t>(stat_value(content, "oom"), 0);
+            prev_oom_kill_ = std::max<int64_t>(stat_value(content, "oom_kill"), 0);
+            add_source(Source{Kind::MemoryEvents, CgroupEventType::MemoryEvents, fd, -1}, EPOLLPRI);
+            return true;
+        }
+    }
+
+    if (memory_v1_.empty()) return false;
+    // v1: an eventfd signalled on every OOM, registered via cgroup.event_control
+    int oom_fd = open((memory_v1_ + "/memory.oom_control").c_str(), O_RDONLY | O_CLOEXEC);
+    if (oom_fd < 0) return false;
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int ctl = open((memory_v1_ + "/cgroup.event_control").c_str(), O_WRONLY | O_CLOEXEC);
+    std::string reg = std::to_string(efd) + " " + std::to_string(oom_fd);
+    bool ok = efd >= 0 && ctl >= 0 && write(ctl, reg.data(), reg.size()) == static_cast<ssize_t>(reg.size());
+    if (ctl >= 0) close(ctl);
+    if (!ok) {
+        if (efd >= 0) close(efd);
+        close(oom_fd);
+        return false;
+    }
+    prev_oom_kill_ = std::max<int64_t>(stat_value(read_fd(oom_fd), "oom_kill"), 0);
+    add_source(Source{Kind::OomEventfd, CgroupEventType::MemoryEvents, efd, oom_fd}, EPOLLIN);
+    return true;
+}
+
+bool CgroupWatcher::watch_cpu_throttling(int interval_ms) {
+    int stat_fd = -1;
+    for (const auto& dir : {path_, cpu_v1_}) {
+        if (dir.empty()) continue;
+        int fd = open((dir + "/cpu.stat").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        // v2 lists throttling only with the cpu controller enabled
+        if (stat_value(read_fd(fd), "nr_throttled") >= 0) {
+            stat_fd = fd;
+            break;
+        }
+        close(fd);
+    }
+    if (stat_fd < 0) return false;
+
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        close(stat_fd);
+        return false;
+    }
+    struct itimerspec its{};
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = static_cast<long>(interval_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(tfd, 0, &its, nullptr);
+
+    add_source(Source{Kind::CpuTimer, CgroupEventType::CpuThrottled, tfd, stat_fd}, EPOLLIN);
+    CgroupEvent baseline{};
+    read_cpu_stat(baseline);
+    return true;
+}
+
+bool CgroupWatcher::read_memory_events(CgroupEvent& ev) {
+    for (const auto& s : sources_) {
+        if (s.kind != Kind::MemoryEvents) continue;
+        std::string content = read_fd(s.fd);
+        int64_t high = stat_value(content, "high"), max = stat_value(content, "max");
+        int64_t oom = stat_value(content, "oom"), oom_kill = stat_value(content, "oom_kill");
+        ev.memory_high = high > prev_high_ ? high - prev_high_ : 0;
+        ev.memory_max = max > prev_max_ ? max - prev_max_ : 0;
+        ev.oom = oom > prev_oom_ ? oom - prev_oom_ : 0;
+        ev.oom_kill = oom_kill > prev_oom_kill_ ? oom_kill - prev_oom_kill_ : 0;
+        prev_high_ = std::max(high, prev_high_);
+        prev_max_ = std::max(max, prev_max_);
+        prev_oom_ = std::max(oom, prev_oom_);
+        prev_oom_kill_ = std::max(oom_kill, prev_oom_kill_);
+        return ev.memory_high || ev.memory_max || ev.oom || ev.oom_kill;
+    }
+    return false;
+}
+
+bool CgroupWatcher::read_cpu_stat(CgroupEvent& ev) {
+    for (const auto& s : sources_) {
+        if (s.kind != Kind::CpuTimer) continue;
+        std::string content = read_fd(s.stats_fd);
+        int64_t nr = stat_value(content, "nr_throttled");
+        int64_t usec = stat_value(content, "throttled_usec");
+        if (usec < 0) {
+            int64_t ns = stat_value(content, "throttled_time");   // v1
+            usec = ns < 0 ? 0 : ns / 1000;
+        }
+        bool first = prev_nr_throttled_ < 0;
+        ev.nr_throttled = first ? 0 : std::max<int64_t>(nr - prev_nr_throttled_, 0);
+        ev.throttled_usec = first ? 0 : std::max<int64_t>(usec - prev_throttled_usec_, 0);
+        prev_nr_throttled_ = nr;
+        prev_throttled_usec_ = usec;
+        return ev.nr_throttled > 0;
+    }
+    return false;
+}
+
+std::vector<CgroupEvent> CgroupWatcher::poll(int timeout_ms) {
+    std::vector<CgroupEvent> events;
+    struct epoll_event ready[16];
+    int n = epoll_wait(epoll_fd_, ready, 16, timeout_ms);
+    for (int i = 0; i < n; ++i) {
+        const Source& s = sources_[ready[i].data.u32];
+        CgroupEvent ev{};
+        ev.type = s.type;
+        ev.timestamp_ms = now_ms();
+        uint64_t count = 0;
+
+        switch (s.kind) {
+        case Kind::Trigger:
+            ev.pressure = parse_pressure(read_fd(s.stats_fd));
+            events.push_back(ev);
+            break;
+        case Kind::MemoryEvents:
+            if (read_memory_events(ev)) events.push_back(ev);
+            break;
+        case Kind::OomEventfd: {
+            if (read(s.fd, &count, sizeof(count)) != sizeof(count)) break;
+            ev.oom = static_cast<int64_t>(count);
+            int64_t kills = stat_value(read_fd(s.stats_fd), "oom_kill");
+            if (kills > prev_oom_kill_) {
+                ev.oom_kill = kills - prev_oom_kill_;
+                prev_oom_kill_ = kills;
+            }
+            events.push_back(ev);
+            break;
+        }
+        case Kind::CpuTimer:
+            if (read(s.fd, &count, sizeof(count)) != sizeof(count)) break;
+            if (read_cpu_stat(ev)) events.push_back(ev);
+            break;
+        }
+    }
+    return events;
+}
+
+int CgroupWatcher::fd() const noexcept {
+    return epoll_fd_;
+}
+
+const std::string& CgroupWatcher::path() const noexcept {
+    return path_;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,83 @@
+#include "agent_kernel/completion_queue.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace agent_kernel {
+
+CompletionQueue::CompletionQueue(unsigned threads) {
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+    }
+    pool_ = std::make_unique<ThreadPool>(threads ? threads : usable_cpus() + 4);
+}
+
+CompletionQueue::~CompletionQueue() {
+    pool_.reset();   // joins the workers, which still signal event_fd_
+    close(event_fd_);
+}
+
+void CompletionQueue::submit(std::function<void()> work, std::function<void()> complete) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        id = next_id_++;
+        waiting_.emplace(id, std::move(complete));
+    }
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    pool_->submit([this, id, work = std::move(work)] {
+        work();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ready_.push_back(id);
+        }
+        uint64_t one = 1;
+        ssize_t n = write(event_fd_, &one, sizeof(one));
+        (void)n;   // only fails once the counter would overflow, i.e. it is already readable
+    });
+}
+
+size_t CompletionQueue::run_completions() {
+    uint64_t count;
+    ssize_t n = read(event_fd_, &count, sizeof(count));
+    (void)n;
+
+    std::vector<std::function<void()>> batch;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        batch.reserve(ready_.size());
+        for (uint64_t id : ready_) {
+            auto it = waiting_.find(id);
+            batch.push_back(std::move(it->second));
+            waiting_.erase(it);
+        }
+        ready_.clear();
+    }
+    for (auto& complete : batch) {
+        complete();
+        complete = nullptr;   // release captures here, not on a worker
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return batch.size();
+}
+
+int CompletionQueue::fd() const noexcept {
+    return event_fd_;
+}
+
+size_t CompletionQueue::pending() const noexcept {
+    return pending_.load(std::memory_order_relaxed);
+}
+
+unsigned CompletionQueue::threads() const noexcept {
+    return pool_->size();
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,239 @@
+#include "agent_kernel/dir_walker.h"
+#include "agent_kernel/stats.h"
+#include "agent_kernel/thread_pool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agent_kernel {
+
+namespace {
+
+// Layout returned by the getdents64 syscall (not exported by all libcs).
+struct linux_dirent64 {
+    ino64_t        d_ino;
+    off64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+constexpr size_t kDentsBufSize = 32768;
+
+// Directories wait in queues with their fd already open while under this
+// many are held; past it they are queued by path and opened when popped.
+constexpr int kMaxQueuedFds = 256;
+
+struct DirTask {
+    std::string path;
+    int fd;     // -1: open by path when popped
+    int depth;
+};
+
+struct WorkQueue {
+    std::mutex mtx;
+    std::deque<DirTask> tasks;
+};
+
+struct WalkState {
+    const WalkOptions& options;
+    const DirWalker::Visitor& visit;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<size_t> pending{0};    // queued or being read
+    std::atomic<int> queued_fds{0};
+    std::atomic<bool> stop{false};
+
+    WalkState(const WalkOptions& o, const DirWalker::Visitor& v, size_t workers) : options(o), visit(v) {
+        for (size_t i = 0; i < workers; ++i) queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    void push(size_t worker, DirTask task) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        auto& q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.tasks.push_back(std::move(task));
+    }
+
+    // Own queue from the back (depth-first, warm caches), others from the front.
+    bool pop(size_t worker, DirTask& out) {
+        {
+            auto& q = *queues[worker];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if (!q.tasks.empty()) {
+                out = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i) {
+            auto& q = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if (!q.tasks.empty()) {
+                out = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void drain() {
+        for (auto& q : queues) {
+            for (auto& t : q->tasks) {
+                if (t.fd >= 0) close(t.fd);
+            }
+            q->tasks.clear();
+        }
+    }
+};
+
+bool skipped(const WalkOptions& options, const char* name) {
+    for (const auto& skip : options.skip_dirs) {
+        if (skip == name) return true;
+    }
+    return false;
+}
+
+void read_dir(WalkState& st, size_t worker, DirTask& task) {
+    int fd = task.fd;
+    if (fd < 0) {
+        // The root may be a symlink to a directory; nothing below it is
+        // followed.
+        int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+        if (task.depth > 0) flags |= O_NOFOLLOW;
+        fd = ::open(task.path.c_str(), flags);
+        Stats::count(Syscall::Open);
+        if (fd < 0) return;
+    } else {
+        st.queued_fds.fetch_sub(1, std::memory_order_relaxed);
+    }
+    // Closed on every exit, including a visitor that throws
+    struct Closer {
+        int fd;
+        ~Closer() { close(fd); }
+    } closer{fd};
+
+    const bool descend = task.depth < st.options.max_depth;
+    alignas(linux_dirent64) char buf[kDentsBufSize];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buf, sizeof(buf));
+        Stats::count(Syscall::Getdents);
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            auto* d = reinterpret_cast<linux_dirent64*>(buf + off);
+            off += d->d_reclen;
+            const char* name = d->d_name;
+            if (name[0] == '.') {
+                if (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')) continue;
+                if (st.options.skip_hidden) continue;
+            }
+
+            unsigned char type = d->d_type;
+            if (type == DT_UNKNOWN) {
+                // Some filesystems (older XFS, some FUSE) leave d_type unset
+                struct stat sb;
+                Stats::count(Syscall::Stat);
+                if (fstatat(fd, name, &sb, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                type = static_cast<unsigned char>(IFTODT(sb.st_mode));
+            }
+
+            WalkEntry entry{task.path, name, type, fd, task.depth};
+            if (!st.visit(entry)) {
+                st.stop.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            if (type == DT_DIR && descend && !skipped(st.options, name)) {
+                std::string child;
+                child.reserve(task.path.size() + 1 + std::strlen(name));
+                child.append(task.path);
+                if (child.empty() || child.back() != '/') child.push_back('/');
+                child.append(name);
+
+                int child_fd = -1;
+                if (st.queued_fds.load(std::memory_order_relaxed) < kMaxQueuedFds) {
+                    child_fd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                    Stats::count(Syscall::Open);
+                    if (child_fd >= 0) st.queued_fds.fetch_add(1, std::memory_order_relaxed);
+                }
+                st.push(worker, DirTask{std::move(child), child_fd, task.depth + 1});
+            }
+        }
+        if (st.stop.load(std::memory_order_relaxed)) break;
+    }
+}
+
+void run_worker(WalkState& st, size_t worker) {
+    DirTask task;
+    int idle_rounds = 0;
+    while (!st.stop.load(std::memory_order_relaxed)) {
+        if (st.pop(worker, task)) {
+            idle_rounds = 0;
+            try {
+                read_dir(st, worker, task);
+            } catch (...) {
+                st.stop.store(true);  // a throwing visitor ends the walk everywhere
+                throw;
+            }
+            st.pending.fetch_sub(1, std::memory_order_acq_rel);
+            continue;
+        }
+        // Nothing to steal: finished once no directory is queued or being read
+        if (st.pending.load(std::memory_order_acquire) == 0) return;
+        if (++idle_rounds < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::string WalkEntry::path() const {
+    std::string p;
+    p.reserve(dir.size() + 1 + std::strlen(name));
+    p.append(dir);
+    if (p.empty() || p.back() != '/') p.push_back('/');
+    p.append(name);
+    return p;
+}
+
+void DirWalker::walk(const std::string& root, const WalkOptions& options, const Visitor& visit) {
+    walk(root, options, visit, ThreadPool::shared());
+}
+
+void DirWalker::walk(const std::string& root, const WalkOptions& options, const Visitor& visit,
+                     ThreadPool& pool) {
+    if (options.max_depth < 0) return;
+    const size_t workers = pool.size() + 1u;
+    WalkState st(options, visit, workers);
+    st.push(0, DirTask{root, -1, 0});
+
+    try {
+        if (workers == 1) {
+            run_worker(st, 0);
+        } else {
+            pool.parallel_for(workers, [&](size_t w) { run_worker(st, w); });
+        }
+    } catch (...) {
+        st.stop.store(true);
+        st.drain();
+        throw;
+    }
+    st.drain();  // left over after an early stop
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,337 @@
+#include "agent_kernel/disk_usage.h"
+#include "agent_kernel/stats.h"
+#include "agent_kernel/thread_pool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace agent_kernel {
+
+namespace {
+
+// Queued directories keep their fd open while under this many are held;
+// past it they are reopened by path when popped.
+constexpr int kMaxQueuedFds = 256;
+
+// Past this many records the cache is dropped rather than grown.
+constexpr size_t kMaxCachedDirs = 500000;
+
+struct DevIno {
+    dev_t dev;
+    ino_t ino;
+    bool operator==(const DevIno& o) const noexcept { return dev == o.dev && ino == o.ino; }
+};
+
+struct DevInoHash {
+    size_t operator()(const DevIno& k) const noexcept {
+        return std::hash<uint64_t>{}(static_cast<uint64_t>(k.ino) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(k.dev));
+    }
+};
+
+int64_t mtime_ns(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+uint64_t allocated(const struct stat& st) {
+    return static_cast<uint64_t>(st.st_blocks) * 512;
+}
+
+bool is_dot(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+std::string join(const std::string& dir, const char* name) {
+    std::string p;
+    p.reserve(dir.size() + 1 + std::strlen(name));
+    p.append(dir);
+    if (p.empty() || p.back() != '/') p.push_back('/');
+    p.append(name);
+    return p;
+}
+
+} // anonymous namespace
+
+/// One scan() call: directories are processed from a shared queue by every
+/// pool worker, each filling in its own node; totals are rolled up at the
+/// end, children always having larger node ids than their parents.
+struct DiskUsageScan {
+    struct Node {
+        uint32_t parent;
+        int depth;
+        std::string path;
+        uint64_t apparent = 0;
+        uint64_t allocated = 0;
+        uint64_t files = 0;
+        uint64_t dirs = 0;
+    };
+    struct Task {
+        std::string path;
+        int fd;     // -1: open by path when popped
+        uint32_t node;
+    };
+
+    DiskUsage& du;
+    const bool one_filesystem;
+    const dev_t root_dev;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::mutex mtx;   // nodes, tasks and seen
+    std::vector<Node> nodes;
+    std::deque<Task> tasks;
+    std::unordered_set<DevIno, DevInoHash> seen;
+    std::atomic<size_t> pending{0};
+    std::atomic<int> queued_fds{0};
+    std::atomic<uint64_t> scanned{0};
+    std::atomic<uint64_t> cached{0};
+
+    DiskUsageScan(DiskUsage& d, bool one_fs, dev_t dev) : du(d), one_filesystem(one_fs), root_dev(dev) {}
+
+    // Queue a subdirectory of `parent`, opened relative to parent_fd.
+    void push(int parent_fd, const char* name, const std::string& parent_path, uint32_t parent) {
+        int fd = -1;
+        if (queued_fds.load(std::memory_order_relaxed) < kMaxQueuedFds) {
+            fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            Stats::count(Syscall::Open);
+            if (fd < 0) return;
+            queued_fds.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::string path = join(parent_path, name);
+        pending.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mtx);
+        auto id = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{parent, nodes[parent].depth + 1, path});
+        tasks.push_back(Task{std::move(path), fd, id});
+    }
+
+    // Count a multiply-linked inode only the first time this scan sees it.
+    bool first_link(dev_t dev, ino_t ino) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return seen.insert(DevIno{dev, ino}).second;
+    }
+
+    bool should_enter(const struct stat& st) const {
+        return S_ISDIR(st.st_mode) && (!one_filesystem || st.st_dev == root_dev);
+    }
+
+    void process(Task& task) {
+        int fd = task.fd;
+        if (fd < 0) {
+            fd = open(task.path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) return;
+        } else {
+            queued_fds.fetch_sub(1, std::memory_order_relaxed);
+        }
+        struct stat dst;
+        if (fstat(fd, &dst) != 0) {
+            close(fd);
+            return;
+        }
+
+        uint64_t own_apparent = 0, own_allocated = allocated(dst), own_files = 0;
+        auto add_links = [&](const std::vector<DiskUsage::Link>& links) {
+            for (const auto& l : links) {
+                ++own_files;
+                if (!first_link(l.dev, l.ino)) continue;
+                own_apparent += l.apparent;
+                own_allocated += l.allocated;
+            }
+        };
+
+        DiskUsage::Record rec;
+        bool hit = false;
+        {
+            std::lock_guard<std::mutex> lock(du.mtx_);
+            auto it = du.cache_.find(task.path);
+            if (it != du.cache_.end() && it->second.dev == dst.st_dev && it->second.ino == dst.st_ino &&
+                it->second.mtime_ns == mtime_ns(dst) &&
+                now - it->second.scanned < std::chrono::milliseconds(du.max_age_ms_)) {
+                rec = it->second;
+                hit = true;
+            }
+        }
+
+        if (hit) {
+            cached.fetch_add(1, std::memory_order_relaxed);
+            own_apparent += rec.apparent;
+            own_allocated += rec.allocated;
+            own_files += rec.files;
+            add_links(rec.links);
+            for (const auto& name : rec.subdirs) {
+                struct stat st;
+                Stats::count(Syscall::Stat);
+                if (fstatat(fd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0 && should_enter(st)) {
+                    push(fd, name.c_str(), task.path, task.node);
+                }
+            }
+            close(fd);
+        } else {
+            scanned.fetch_add(1, std::memory_order_relaxed);
+            rec.dev = dst.st_dev;
+            rec.ino = dst.st_ino;
+            rec.mtime_ns = mtime_ns(dst);
+            rec.scanned = now;
+
+            DIR* d = fdopendir(fd);
+            if (!d) {
+                close(fd);
+                return;
+            }
+            while (struct dirent* de = readdir(d)) {
+                if (is_dot(de->d_name)) continue;
+                struct stat st;
+                Stats::count(Syscall::Stat);
+                if (fstatat(fd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                if (S_ISDIR(st.st_mode)) {
+                    rec.subdirs.emplace_back(de->d_name);
+                    if (should_enter(st)) push(fd, de->d_name, task.path, task.node);
+                    continue;
+                }
+                uint64_t apparent = S_ISREG(st.st_mode) ? static_cast<uint64_t>(st.st_size) : 0;
+                if (st.st_nlink > 1) {
+                    rec.links.push_back(DiskUsage::Link{st.st_dev, st.st_ino, apparent, allocated(st)});
+                } else {
+                    rec.apparent += apparent;
+                    rec.allocated += allocated(st);
+                    ++rec.files;
+                }
+            }
+            closedir(d);
+
+            own_apparent += rec.apparent;
+            own_allocated += rec.allocated;
+            own_files += rec.files;
+            add_links(rec.links);
+
+            std::lock_guard<std::mutex> lock(du.mtx_);
+            du.cache_[task.path] = std::move(rec);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& node = nodes[task.node];
+        node.apparent = own_apparent;
+        node.allocated = own_allocated;
+        node.files = own_files;
+    }
+
+    void run_worker() {
+        int idle_rounds = 0;
+        for (;;) {
+            Task task;
+            bool got = false;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!tasks.empty()) {
+                    task = std::move(tasks.back());   // depth-first keeps fds and caches warm
+                    tasks.pop_back();
+                    got = true;
+                }
+            }
+            if (got) {
+                idle_rounds = 0;
+                process(task);
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+            if (pending.load(std::memory_order_acquire) == 0) return;
+            if (++idle_rounds < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+};
+
+DiskUsage::DiskUsage(int64_t max_age_ms) : max_age_ms_(max_age_ms) {}
+
+DiskUsage& DiskUsage::shared() {
+    static DiskUsage instance;
+    return instance;
+}
+
+void DiskUsage::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    cache_.clear();
+}
+
+size_t DiskUsage::cached() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return cache_.size();
+}
+
+DiskUsageReport DiskUsage::scan(const std::string& root, size_t top_n, int top_depth, bool one_filesystem) {
+    std::string path = root;
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open directory " + path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("fstat failed for " + path + ": " + strerror(err));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (cache_.size() > kMaxCachedDirs) cache_.clear();
+    }
+
+    DiskUsageScan run(*this, one_filesystem, st.st_dev);
+    run.nodes.push_back(DiskUsageScan::Node{0, 0, path});
+    run.tasks.push_back(DiskUsageScan::Task{path, fd, 0});
+    run.queued_fds = 1;
+    run.pending = 1;
+
+    ThreadPool& pool = ThreadPool::shared();
+    pool.parallel_for(pool.size() + 1u, [&](size_t) { run.run_worker(); });
+
+    auto& nodes = run.nodes;
+    for (size_t i = nodes.size(); i-- > 1;) {
+        auto& parent = nodes[nodes[i].parent];
+        parent.apparent += nodes[i].apparent;
+        parent.allocated += nodes[i].allocated;
+        parent.files += nodes[i].files;
+        parent.dirs += nodes[i].dirs + 1;
+    }
+
+    auto to_usage = [](DiskUsageScan::Node& n) {
+        DirUsage u;
+        u.path = std::move(n.path);
+        u.apparent_bytes = n.apparent;
+        u.allocated_bytes = n.allocated;
+        u.files = n.files;
+        u.dirs = n.dirs;
+        u.depth = n.depth;
+        return u;
+    };
+
+    DiskUsageReport report;
+    report.scanned_dirs = run.scanned.load();
+    report.cached_dirs = run.cached.load();
+
+    std::vector<uint32_t> order;
+    for (uint32_t i = 1; i < nodes.size(); ++i) {
+        if (nodes[i].depth <= top_depth) order.push_back(i);
+    }
+    size_t n = std::min(top_n, order.size());
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(n), order.end(),
+                      [&](uint32_t a, uint32_t b) { return nodes[a].allocated > nodes[b].allocated; });
+    for (size_t i = 0; i < n; ++i) report.top.push_back(to_usage(nodes[order[i]]));
+    report.total = to_usage(nodes[0]);
+    return report;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,443 @@
+#include "agent_kernel/file_utils.h"
+#include "agent_kernel/dir_walker.h"
+#include "agent_kernel/glob_matcher.h"
+#include "agent_kernel/stats.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <regex>
+
+namespace agent_kernel {
+
+namespace {
+
+constexpr size_t kBinaryProbe = 8192;
+constexpr size_t kBlockSize = 1 << 20;         // read unit; larger files take several
+constexpr size_t kMaxRegexLine = 64 * 1024;    // std::regex recurses per character
+
+inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline char upper(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+// Longest run of characters that every match of the ECMAScript regex `re`
+// must contain, or "" when none can be proven (top-level alternation).
+// Groups, classes and quantified characters end a run.
+std::string required_literal(const std::string& re) {
+    std::string best, run;
+    auto flush = [&] {
+        if (run.size() > best.size()) best = run;
+        run.clear();
+    };
+    auto quantified = [&](size_t next) {
+        return next < re.size() && (re[next] == '?' || re[next] == '*' || re[next] == '{');
+    };
+
+    int depth = 0;
+    for (size_t i = 0; i < re.size(); ++i) {
+        char c = re[i];
+        switch (c) {
+        case '\\': {
+            if (i + 1 >= re.size()) return best;
+            char n = re[++i];
+            if (std::isalnum(static_cast<unsigned char>(n))) {
+                // Class, anchor, backreference or numeric escape
+                flush();
+                if (n == 'x') i += 2;
+                else if (n == 'u') i += 4;
+                else if (n == 'c') i += 1;
+                else if (std::isdigit(static_cast<unsigned char>(n))) {
+                    while (i + 1 < re.size() && std::isdigit(static_cast<unsigned char>(re[i + 1]))) ++i;
+                }
+                continue;
+            }
+            if (depth > 0) continue;
+            if (quantified(i + 1)) flush();
+            else run.push_back(n);
+            continue;
+        }
+        case '[': {
+            flush();
+            size_t j = i + 1;
+            if (j < re.size() && re[j] == '^') ++j;
+            if (j < re.size() && re[j] == ']') ++j;
+            for (; j < re.size() && re[j] != ']'; ++j) {
+                if (re[j] == '\\') ++j;
+            }
+            i = j;
+            continue;
+        }
+        case '{':
+            flush();
+            while (i < re.size() && re[i] != '}') ++i;
+            continue;
+        case '|':
+            if (depth == 0) return "";
+            continue;
+        case '(':
+            ++depth;
+            flush();
+            continue;
+        case ')':
+            --depth;
+            flush();
+            continue;
+        case '.': case '^': case '$': case '*': case '+': case '?': case '}':
+            flush();
+            continue;
+        default:
+            if (depth > 0) continue;
+            if (quantified(i + 1)) flush();
+            else run.push_back(c);
+        }
+    }
+    flush();
+    return best;
+}
+
+/// memmem(), or a case-folding equivalent that jumps between candidate
+/// bytes with memchr. Case-free bytes (digits, punctuation) are rarer and
+/// need a single memchr, so the first of them anchors the search.
+class LiteralFinder {
+public:
+    LiteralFinder(std::string needle, bool fold) : needle_(std::move(needle)), fold_(fold) {
+        if (fold_) std::transform(needle_.begin(), needle_.end(), needle_.begin(), lower);
+        for (size_t i = 0; i < needle_.size(); ++i) {
+            if (upper(needle_[i]) == needle_[i]) {
+                anchor_ = i;
+                break;
+            }
+        }
+    }
+
+    const char* find(const char* begin, const char* end) const {
+        const size_t n = needle_.size();
+        if (n == 0) return begin;
+        if (static_cast<size_t>(end - begin) < n) return nullptr;
+        if (!fold_) return static_cast<const char*>(memmem(begin, static_cast<size_t>(end - begin), needle_.data(), n));
+
+        const char lo = needle_[anchor_], up = upper(lo);
+        const char* last = end - (n - anchor_);   // last position the anchor byte can occupy
+        for (const char* p = begin + anchor_; p <= last;) {
+            const size_t span = static_cast<size_t>(last - p) + 1;
+            auto* a = static_cast<const char*>(memchr(p, lo, span));
+            auto* b = lo == up ? nullptr : static_cast<const char*>(memchr(p, up, a ? static_cast<size_t>(a - p) : span));
+            const char* hit = b ? b : a;
+            if (!hit) return nullptr;
+            const char* start = hit - anchor_;
+            size_t k = 0;
+            while (k < n && lower(start[k]) == needle_[k]) ++k;
+            if (k == n) return start;
+            p = hit + 1;
+        }
+        return nullptr;
+    }
+
+private:
+    std::string needle_;
+    bool fold_;
+    size_t anchor_ = 0;
+};
+
+/// Compiled pattern: a literal prefilter locates candidate lines and the
+/// regex, if any, confirms them.
+class LineMatcher {
+public:
+    LineMatcher(const std::string& pattern, const GrepOptions& options)
+        : finder_(options.regex ? required_literal(pattern) : pattern, options.ignore_case),
+          regex_(options.regex) {
+        if (regex_) {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (options.ignore_case) flags |= std::regex::icase;
+            re_ = std::regex(pattern, flags);
+        }
+    }
+
+    /// Start of the next line at or after `pos` that may match, or nullptr.
+    const char* candidate(const char* pos, const char* end) const {
+        return finder_.find(pos, end);
+    }
+
+    bool confirm(const char* begin, const char* end) const {
+        if (!regex_) return true;   // the literal hit is the match
+        if (static_cast<size_t>(end - begin) > kMaxRegexLine) return false;
+        return std::regex_search(begin, end, re_);
+    }
+
+private:
+    LiteralFinder finder_;
+    bool regex_;
+    std::regex re_;
+};
+
+std::string clip(const char* begin, const char* end, size_t max_len) {
+    return std::string(begin, std::min(static_cast<size_t>(end - begin), max_len));
+}
+
+const char* line_end(const char* p, const char* end) {
+    auto* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+    return nl ? nl : end;
+}
+
+// Eight bytes at a time into per-byte counters, since every block of a
+// file is counted and memchr per line is slow on short lines. A byte of
+// x = w ^ '\n' is zero exactly where w has a newline; that byte is the
+// only one whose high bit stays clear in ((x & 0x7f..) + 0x7f..) | x.
+uint64_t count_newlines(const char* begin, const char* end) {
+    constexpr uint64_t kOnes = 0x0101010101010101ull;
+    constexpr uint64_t kLow7 = kOnes * 0x7f;
+    constexpr uint64_t kPairs = 0x00ff00ff00ff00ffull;
+    uint64_t n = 0;
+    while (end - begin >= 8) {
+        uint64_t acc = 0;   // flushed before a byte lane can pass 255
+        for (int i = 0; i < 255 && end - begin >= 8; ++i, begin += 8) {
+            uint64_t w;
+            std::memcpy(&w, begin, sizeof(w));
+            uint64_t x = w ^ (kOnes * '\n');
+            acc += (~(((x & kLow7) + kLow7) | x) >> 7) & kOnes;
+        }
+        uint64_t lanes = (acc & kPairs) + ((acc >> 8) & kPairs);
+        n += (lanes * 0x0001000100010001ull) >> 48;
+    }
+    for (; begin < end; ++begin) n += *begin == '\n';
+    return n;
+}
+
+// Where a file's scan stands between blocks.
+struct ScanState {
+    uint64_t line_no = 1;           // line number at the next block's `from`
+    std::vector<size_t> pending;    // matches still owed after-context lines
+};
+
+// Matches among the complete lines in [from, limit), at most `limit_matches`
+// in all. Lines before `from` (back to `data`) are only read as
+// before-context; after-context past `limit` is finished from the next
+// block unless this one is `final`.
+void scan_block(const char* data, const char* from, const char* limit, bool final, ScanState& state,
+                const std::string& path, const LineMatcher& matcher, const GrepOptions& options,
+                size_t limit_matches, std::vector<GrepMatch>& out) {
+    const size_t context = static_cast<size_t>(std::max(options.context, 0));
+
+    // After-context of matches near the end of the previous block
+    if (!state.pending.empty()) {
+        const char* line = from;
+        for (size_t taken = 0; taken < context && line < limit; ++taken) {
+            const char* stop = line_end(line, limit);
+            for (size_t idx : state.pending) {
+                if (out[idx].after.size() < context) out[idx].after.push_back(clip(line, stop, options.max_line_length));
+            }
+            line = stop + 1;
+        }
+        state.pending.erase(std::remove_if(state.pending.begin(), state.pending.end(),
+                                           [&](size_t idx) { return final || out[idx].after.size() >= context; }),
+                            state.pending.end());
+    }
+
+    const char* pos = from;
+    const char* counted = from;
+    uint64_t line_no = state.line_no;
+
+    while (pos < limit && out.size() < limit_matches) {
+        const char* hit = matcher.candidate(pos, limit);
+        if (!hit) break;
+        auto* prev_nl = static_cast<const char*>(memrchr(pos, '\n', static_cast<size_t>(hit - pos)));
+        const char* start = prev_nl ? prev_nl + 1 : pos;
+        const char* stop = line_end(hit, limit);
+
+        if (matcher.confirm(start, stop)) {
+            line_no += count_newlines(counted, start);
+            counted = start;
+
+            GrepMatch m;
+            m.path = path;
+            m.line = line_no;
+            m.text = clip(start, stop, options.max_line_length);
+
+            const char* b = start;
+            for (size_t i = 0; i < context && b > data; ++i) {
+                const char* prev_end = b - 1;   // the '\n' ending the previous line
+                auto* nl = static_cast<const char*>(memrchr(data, '\n', static_cast<size_t>(prev_end - data)));
+                b = nl ? nl + 1 : data;
+                m.before.push_back(clip(b, prev_end, options.max_line_length));
+            }
+            std::reverse(m.before.begin(), m.before.end());
+
+            const char* a = stop;
+            for (size_t i = 0; i < context && a + 1 < limit; ++i) {
+                const char* next = a + 1;
+                a = line_end(next, limit);
+                m.after.push_back(clip(next, a, options.max_line_length));
+            }
+            if (!final && m.after.size() < context) state.pending.push_back(out.size());
+            out.push_back(std::move(m));
+        }
+        pos = stop + 1;
+    }
+    state.line_no = line_no + count_newlines(counted, limit);
+}
+
+size_t reported_bytes(const GrepMatch& m) {
+    size_t n = m.text.size();
+    for (const auto& l : m.before) n += l.size();
+    for (const auto& l : m.after) n += l.size();
+    return n;
+}
+
+/// Shared state of one grep() call across walker threads.
+struct GrepRun {
+    const LineMatcher& matcher;
+    const GrepOptions& options;
+    const std::function<bool(const GrepMatch&)>& on_match;
+    GrepResult& result;
+    std::mutex mtx;
+    size_t matches = 0;
+    size_t bytes = 0;
+    bool stopped = false;
+
+    GrepRun(const LineMatcher& m, const GrepOptions& o, const std::function<bool(const GrepMatch&)>& cb,
+            GrepResult& r)
+        : matcher(m), options(o), on_match(cb), result(r) {}
+
+    // Scan one open file; returns false once the search should stop.
+    //
+    // Files are read in blocks rather than mapped: a file truncated under
+    // a mapping (copytruncate log rotation) raises SIGBUS, while pread just
+    // comes up short. The tail of each block after its last newline, plus
+    // the lines needed as before-context, is carried into the next.
+    bool scan(int fd, const std::string& path) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return true;
+        auto size = static_cast<uint64_t>(st.st_size);
+        if (size > options.max_file_size) return true;
+
+        const size_t max_found = static_cast<size_t>(std::max(options.max_matches, 0));
+        const int context = std::max(options.context, 0);
+        thread_local std::vector<char> buf;
+        std::vector<GrepMatch> found;
+        ScanState state;
+        uint64_t offset = 0;
+        size_t held = 0, from = 0;      // bytes in buf; start of the unsearched ones
+
+        for (;;) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(kBlockSize, size - offset));
+            if (buf.size() < held + want) buf.resize(held + want);
+            size_t got = pread_full(fd, buf.data() + held, want, static_cast<off_t>(offset));
+            if (offset == 0 && memchr(buf.data(), '\0', std::min(got, kBinaryProbe))) {
+                offset = size;          // counted as scanned, like any other file
+                break;
+            }
+            offset += got;
+            held += got;
+            bool final = got < want || offset >= size;
+
+            const char* data = buf.data();
+            const char* limit = data + held;
+            if (!final) {
+                auto* nl = static_cast<const char*>(memrchr(data + from, '\n', held - from));
+                if (!nl) continue;      // a line longer than the block: read on
+                limit = nl + 1;
+            }
+            scan_block(data, data + from, limit, final, state, path, matcher, options, max_found, found);
+            if (final || (found.size() >= max_found && state.pending.empty())) break;
+
+            // Keep the last `context` complete lines and the partial one
+            const char* keep = limit;
+            for (int i = 0; i < context && keep > data; ++i) {
+                auto* nl = static_cast<const char*>(memrchr(data, '\n', static_cast<size_t>(keep - 1 - data)));
+                keep = nl ? nl + 1 : data;
+            }
+            size_t kept = held - static_cast<size_t>(keep - data);
+            std::memmove(buf.data(), keep, kept);
+            from = static_cast<size_t>(limit - keep);
+            held = kept;
+        }
+        size = offset;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (stopped) return false;
+        ++result.files_scanned;
+        result.bytes_scanned += size;
+        for (auto& m : found) {
+            size_t n = reported_bytes(m);
+            if (matches >= static_cast<size_t>(options.max_matches) || bytes + n > options.max_bytes) {
+                result.truncated = true;
+                stopped = true;
+                return false;
+            }
+            ++matches;
+            bytes += n;
+            if (!on_match(m)) {
+                stopped = true;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // anonymous namespace
+
+GrepResult FileUtils::grep(const std::string& root, const std::string& pattern, const GrepOptions& options,
+                           const std::function<bool(const GrepMatch&)>& on_match) {
+    ProbeTimer timer(Probe::FileGrep);
+    GrepResult result;
+    if (options.max_matches <= 0 || pattern.empty()) return result;
+
+    const LineMatcher matcher(pattern, options);
+    GrepRun run(matcher, options, on_match, result);
+
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0) return result;
+    if (!S_ISDIR(st.st_mode)) {
+        int fd = open(root.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return result;
+        run.scan(fd, root);
+        close(fd);
+        return result;
+    }
+
+    std::unique_ptr<GlobMatcher> include;
+    if (!options.include.empty()) include = std::make_unique<GlobMatcher>(options.include);
+
+    WalkOptions walk;
+    walk.max_depth = options.max_depth;
+    walk.skip_dirs = options.skip_dirs;
+    DirWalker::walk(root, walk, [&](const WalkEntry& e) {
+        if (e.type != DT_REG && e.type != DT_UNKNOWN) return true;
+        if (include && !include->match(e.name)) return true;
+        int fd = openat(e.dir_fd, e.name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_NONBLOCK);
+        Stats::count(Syscall::Open);
+        if (fd < 0) return true;
+        bool more = run.scan(fd, e.path());
+        close(fd);
+        return more;
+    });
+    return result;
+}
+
+GrepResult FileUtils::grep(const std::string& root, const std::string& pattern, const GrepOptions& options) {
+    std::vector<GrepMatch> matches;
+    GrepResult result = grep(root, pattern, options, [&](const GrepMatch& m) {
+        matches.push_back(m);
+        return true;
+    });
+    // Files finish in any order; keep the output stable
+    std::sort(matches.begin(), matches.end(), [](const GrepMatch& a, const GrepMatch& b) {
+        return a.path != b.path ? a.path < b.path : a.line < b.line;
+    });
+    result.matches = std::move(matches);
+    return result;
+}
+
+} // namespace agent_kernel
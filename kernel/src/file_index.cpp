@@ -0,0 +1,651 @@
+#include "agent_kernel/file_index.h"
+#include "agent_kernel/dir_walker.h"
+#include "agent_kernel/fs_watcher.h"
+#include "agent_kernel/glob_matcher.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace agent_kernel {
+
+namespace {
+
+constexpr char kMagic[8] = {'A', 'K', 'F', 'I', 'D', 'X', '0', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr int kMaxWalkDepth = 4096;
+
+// Flat cache file: header, root path (padded to 8), entries, names.
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t entry_count;
+    uint64_t names_size;
+    uint64_t root_size;
+};
+
+size_t pad8(size_t n) {
+    return (n + 7) & ~size_t{7};
+}
+
+std::string lowered(std::string_view s) {
+    std::string out(s);
+    for (auto& c : out) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return out;
+}
+
+// Text after the last '.'; false when the name has no dot.
+bool extension_of(std::string_view name, std::string_view& ext) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string_view::npos) return false;
+    ext = name.substr(dot + 1);
+    return true;
+}
+
+// Names in the arena are not NUL-terminated, which the fnmatch() path needs
+bool matches(const GlobMatcher& matcher, std::string_view name, std::string& scratch) {
+    if (matcher.kind() != GlobMatcher::Kind::Fnmatch) return matcher.match(name);
+    scratch.assign(name);
+    return matcher.match(scratch);
+}
+
+std::string join(const std::string& dir, std::string_view name) {
+    std::string p;
+    p.reserve(dir.size() + 1 + name.size());
+    p.append(dir);
+    if (p.empty() || p.back() != '/') p.push_back('/');
+    p.append(name);
+    return p;
+}
+
+std::string normalize(std::string path) {
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+    return path;
+}
+
+int64_t mtime_ns(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+void write_all(int fd, const void* data, size_t size, const std::string& path) {
+    auto* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("write " + path + " failed: " + strerror(errno));
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// Drop dead entries. Parents always precede their children, so one forward
+// pass can remap parent ids. remap[old] is the new id of each live entry.
+void compact_into(const std::vector<FileIndex::Entry>& entries, const std::vector<char>& names,
+                  std::vector<FileIndex::Entry>& out_entries, std::vector<char>& out_names,
+                  std::vector<uint32_t>& remap) {
+    remap.assign(entries.size(), 0);
+    out_entries.clear();
+    out_names.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& e = entries[i];
+        if (!e.live) continue;
+        FileIndex::Entry c = e;
+        c.parent = i == 0 ? 0 : remap[e.parent];
+        c.name_off = static_cast<uint32_t>(out_names.size());
+        out_names.insert(out_names.end(), names.begin() + e.name_off, names.begin() + e.name_off + e.name_len);
+        remap[i] = static_cast<uint32_t>(out_entries.size());
+        out_entries.push_back(c);
+    }
+}
+
+} // anonymous namespace
+
+FileIndex::FileIndex(const std::string& root, const std::string& cache_path, std::vector<std::string> skip_dirs)
+    : root_(normalize(root)), cache_path_(cache_path), skip_dirs_(std::move(skip_dirs)),
+      watcher_(std::make_unique<FSWatcher>()) {
+    // The root itself may be a symlink to a directory.
+    int root_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) {
+        throw std::runtime_error("Cannot index " + root_ + ": " + strerror(errno));
+    }
+    close(root_fd);
+
+    // Each directory is watched before it is read, so whatever changes
+    // during the scan or revalidation is queued as events, applied below.
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        loaded_ = !cache_path_.empty() && load(cache_path_);
+        if (loaded_) {
+            for (const auto& [path, id] : dirs_) watch_dir(id, path);
+            revalidate_locked();
+        } else {
+            build();
+        }
+    }
+    update(0);
+}
+
+FileIndex::~FileIndex() = default;
+
+std::string_view FileIndex::name_of(uint32_t id) const {
+    const auto& e = entries_[id];
+    return std::string_view(names_.data() + e.name_off, e.name_len);
+}
+
+std::string FileIndex::path_of(uint32_t id) const {
+    if (id == 0) return root_;
+    std::vector<uint32_t> chain;
+    for (uint32_t cur = id; cur != 0; cur = entries_[cur].parent) chain.push_back(cur);
+
+    std::string path = root_;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (path.back() != '/') path.push_back('/');
+        path.append(name_of(*it));
+    }
+    return path;
+}
+
+uint32_t FileIndex::add_entry(uint32_t parent, std::string_view name, uint8_t type, uint64_t size, int64_t mtime) {
+    Entry e{};
+    e.parent = parent;
+    e.name_off = static_cast<uint32_t>(names_.size());
+    e.name_len = static_cast<uint32_t>(name.size());
+    e.depth = static_cast<uint16_t>(entries_.empty() ? 0 : entries_[parent].depth + 1);
+    e.type = type;
+    e.live = 1;
+    e.size = size;
+    e.mtime_ns = mtime;
+    names_.insert(names_.end(), name.begin(), name.end());
+
+    auto id = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(e);
+    ++live_;
+    if (id != 0) {
+        children_[parent].push_back(id);
+        index_names(id);
+    }
+    return id;
+}
+
+void FileIndex::index_names(uint32_t id) {
+    std::string_view name = name_of(id);
+    by_name_[lowered(name)].push_back(id);
+    std::string_view ext;
+    if (extension_of(name, ext)) by_ext_[lowered(ext)].push_back(id);
+}
+
+void FileIndex::remove_subtree(uint32_t id) {
+    // Detach from the parent; the name indexes are pruned lazily by compact()
+    if (id != 0) {
+        auto it = children_.find(entries_[id].parent);
+        if (it != children_.end()) {
+            auto& kids = it->second;
+            kids.erase(std::remove(kids.begin(), kids.end(), id), kids.end());
+        }
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> stack;
+    stack.emplace_back(id, path_of(id));
+    while (!stack.empty()) {
+        auto [cur, path] = std::move(stack.back());
+        stack.pop_back();
+        auto& e = entries_[cur];
+        if (!e.live) continue;
+        e.live = 0;
+        --live_;
+        if (e.type != DT_DIR) continue;
+
+        dirs_.erase(path);
+        auto w = watches_.find(cur);
+        if (w != watches_.end()) {
+            watcher_->unwatch(w->second);
+            watches_.erase(w);
+        }
+        auto kids = children_.find(cur);
+        if (kids == children_.end()) continue;
+        for (uint32_t child : kids->second) stack.emplace_back(child, join(path, name_of(child)));
+        children_.erase(kids);
+    }
+}
+
+void FileIndex::sync_dir(uint32_t id, const std::string& path) {
+    // Only the root is followed if it is a symlink, as in DirWalker.
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (id != 0) flags |= O_NOFOLLOW;
+    int fd = open(path.c_str(), flags);
+    if (fd < 0) return;
+    DIR* d = fdopendir(fd);
+    if (!d) {
+        close(fd);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0) entries_[id].mtime_ns = mtime_ns(st);
+
+    std::unordered_map<std::string, uint32_t> existing;
+    if (auto it = children_.find(id); it != children_.end()) {
+        for (uint32_t child : it->second) existing.emplace(std::string(name_of(child)), child);
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> new_dirs;
+    while (struct dirent* de = readdir(d)) {
+        const char* name = de->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+        if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+        auto type = static_cast<uint8_t>(IFTODT(st.st_mode));
+        auto found = existing.find(name);
+        if (found != existing.end()) {
+            uint32_t child = found->second;
+            existing.erase(found);
+            if (entries_[child].type == type) {
+                entries_[child].size = static_cast<uint64_t>(st.st_size);
+                if (type != DT_DIR) entries_[child].mtime_ns = mtime_ns(st);
+                continue;
+            }
+            remove_subtree(child);
+        }
+
+        uint32_t child = add_entry(id, name, type, static_cast<uint64_t>(st.st_size), mtime_ns(st));
+        if (type == DT_DIR) new_dirs.emplace_back(child, join(path, name));
+    }
+    closedir(d);
+
+    for (const auto& [name, child] : existing) remove_subtree(child);
+
+    for (const auto& [child, child_path] : new_dirs) {
+        if (!entries_[child].live) continue;
+        dirs_[child_path] = child;
+        if (std::find(skip_dirs_.begin(), skip_dirs_.end(), name_of(child)) != skip_dirs_.end()) continue;
+        watch_dir(child, child_path);
+        sync_dir(child, child_path);
+    }
+}
+
+void FileIndex::watch_dir(uint32_t id, const std::string& path) {
+    if (watches_.count(id)) return;
+    if (std::find(skip_dirs_.begin(), skip_dirs_.end(), name_of(id)) != skip_dirs_.end() && id != 0) return;
+    try {
+        watches_[id] = watcher_->watch(path);
+    } catch (const std::runtime_error&) {
+        ++unwatched_;  // ENOSPC once fs.inotify.max_user_watches is reached
+    }
+}
+
+void FileIndex::apply_event(const std::string& dir, const std::string& name) {
+    auto it = dirs_.find(dir);
+    if (it == dirs_.end()) return;
+    uint32_t id = it->second;
+
+    uint32_t child = 0;
+    if (auto kids = children_.find(id); kids != children_.end()) {
+        for (uint32_t k : kids->second) {
+            if (name_of(k) == name) {
+                child = k;
+                break;
+            }
+        }
+    }
+
+    std::string path = join(dir, name);
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        if (child) remove_subtree(child);
+        return;
+    }
+
+    auto type = static_cast<uint8_t>(IFTODT(st.st_mode));
+    if (child && entries_[child].type == type) {
+        entries_[child].size = static_cast<uint64_t>(st.st_size);
+        if (type != DT_DIR) entries_[child].mtime_ns = mtime_ns(st);
+        return;
+    }
+    if (child) remove_subtree(child);
+
+    child = add_entry(id, name, type, static_cast<uint64_t>(st.st_size), mtime_ns(st));
+    if (type == DT_DIR) {
+        dirs_[path] = child;
+        if (std::find(skip_dirs_.begin(), skip_dirs_.end(), name) != skip_dirs_.end()) return;
+        // Watch before listing so entries created meanwhile still raise events
+        watch_dir(child, path);
+        sync_dir(child, path);
+    }
+}
+
+size_t FileIndex::update(int timeout_ms) {
+    std::lock_guard<std::mutex> poll_lock(poll_mtx_);
+    if (watcher_->poll_into(events_, timeout_ms) == 0) return 0;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    // apply_event re-stats the path, so repeated events for a name are redundant
+    std::unordered_set<std::string> seen;
+    size_t applied = 0;
+    for (const auto& ev : events_) {
+        if (ev.type == FSEventType::Overflow) {
+            revalidate_locked();
+            ++applied;
+            continue;
+        }
+        if (ev.path.empty() || ev.name.empty()) continue;
+        if (!seen.insert(join(ev.path, ev.name)).second) continue;
+        apply_event(ev.path, ev.name);
+        ++applied;
+    }
+    if (entries_.size() > 1024 && live_ < entries_.size() / 2) compact();
+    return applied;
+}
+
+void FileIndex::build() {
+    add_entry(0, "", DT_DIR, 0, 0);
+    dirs_[root_] = 0;
+    watch_dir(0, root_);
+    struct stat st;
+    if (stat(root_.c_str(), &st) == 0) entries_[0].mtime_ns = mtime_ns(st);
+
+    WalkOptions options;
+    options.max_depth = kMaxWalkDepth;
+    options.skip_dirs = skip_dirs_;
+
+    // The caller holds mtx_; the walker's threads serialize on their own lock
+    std::mutex walk_mtx;
+    std::string dir_key;
+    DirWalker::walk(root_, options, [&](const WalkEntry& e) {
+        struct stat est;
+        bool have_stat = fstatat(e.dir_fd, e.name, &est, AT_SYMLINK_NOFOLLOW) == 0;
+        uint8_t type = have_stat ? static_cast<uint8_t>(IFTODT(est.st_mode)) : e.type;
+
+        std::lock_guard<std::mutex> lock(walk_mtx);
+        dir_key.assign(e.dir);
+        auto parent = dirs_.find(dir_key);
+        if (parent == dirs_.end()) return true;
+        uint32_t id = add_entry(parent->second, e.name, type,
+                                have_stat ? static_cast<uint64_t>(est.st_size) : 0,
+                                have_stat ? mtime_ns(est) : 0);
+        if (type == DT_DIR) {
+            // The walker reads a directory only after visiting its entry
+            std::string path = e.path();
+            watch_dir(id, path);
+            dirs_[std::move(path)] = id;
+        }
+        return true;
+    });
+}
+
+bool FileIndex::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const auto* base = static_cast<const char*>(map);
+    FileHeader h;
+    std::memcpy(&h, base, sizeof(h));
+    size_t root_at = sizeof(FileHeader);
+    size_t entries_at = root_at + pad8(h.root_size);
+    bool ok = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+              h.entry_size == sizeof(Entry) && h.entry_count > 0 && h.entry_count < UINT32_MAX &&
+              h.root_size == root_.size() && std::memcmp(base + root_at, root_.data(), root_.size()) == 0 &&
+              entries_at + h.entry_count * sizeof(Entry) + h.names_size == size;
+    if (ok) {
+        entries_.resize(h.entry_count);
+        std::memcpy(entries_.data(), base + entries_at, h.entry_count * sizeof(Entry));
+        names_.assign(base + entries_at + h.entry_count * sizeof(Entry), base + size);
+
+        // Reject anything a truncated or foreign file could smuggle in
+        for (size_t i = 1; i < entries_.size() && ok; ++i) {
+            const auto& e = entries_[i];
+            ok = e.parent < i && entries_[e.parent].type == DT_DIR && e.live &&
+                 e.depth == entries_[e.parent].depth + 1 &&
+                 static_cast<uint64_t>(e.name_off) + e.name_len <= names_.size();
+        }
+        ok = ok && entries_[0].type == DT_DIR && entries_[0].depth == 0;
+    }
+    munmap(map, size);
+
+    if (!ok) {
+        entries_.clear();
+        names_.clear();
+        return false;
+    }
+    rebuild_maps();
+    return true;
+}
+
+void FileIndex::save(const std::string& path) const {
+    const std::string& target = path.empty() ? cache_path_ : path;
+    if (target.empty()) throw std::runtime_error("FileIndex::save: no cache path");
+
+    std::vector<Entry> entries;
+    std::vector<char> names;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::vector<uint32_t> remap;
+        compact_into(entries_, names_, entries, names, remap);
+    }
+
+    FileHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.entry_size = sizeof(Entry);
+    h.entry_count = entries.size();
+    h.names_size = names.size();
+    h.root_size = root_.size();
+
+    // A fresh 0600 file (O_EXCL), so nothing planted in the directory can
+    // redirect or read the write
+    std::string tmp = target + ".tmp.XXXXXX";
+    int fd = mkostemp(&tmp[0], O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot create " + tmp + ": " + strerror(errno));
+    try {
+        static const char zeros[8] = {};
+        write_all(fd, &h, sizeof(h), tmp);
+        write_all(fd, root_.data(), root_.size(), tmp);
+        write_all(fd, zeros, pad8(root_.size()) - root_.size(), tmp);
+        write_all(fd, entries.data(), entries.size() * sizeof(Entry), tmp);
+        write_all(fd, names.data(), names.size(), tmp);
+    } catch (...) {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+    close(fd);
+    if (rename(tmp.c_str(), target.c_str()) != 0) {
+        int err = errno;
+        unlink(tmp.c_str());
+        throw std::runtime_error("Cannot rename " + tmp + ": " + strerror(err));
+    }
+}
+
+void FileIndex::revalidate() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    revalidate_locked();
+}
+
+void FileIndex::revalidate_locked() {
+    std::vector<uint32_t> dir_ids;
+    dir_ids.reserve(dirs_.size());
+    for (const auto& [path, id] : dirs_) dir_ids.push_back(id);
+    std::sort(dir_ids.begin(), dir_ids.end());
+
+    struct stat st;
+    for (uint32_t id : dir_ids) {
+        if (!entries_[id].live) continue;
+        std::string path = path_of(id);
+        int rc = id == 0 ? stat(path.c_str(), &st) : lstat(path.c_str(), &st);
+        if (rc != 0 || !S_ISDIR(st.st_mode)) {
+            if (id == 0) continue;
+            remove_subtree(id);
+        } else if (mtime_ns(st) != entries_[id].mtime_ns) {
+            sync_dir(id, path);
+        }
+    }
+}
+
+void FileIndex::rebuild_maps() {
+    children_.clear();
+    dirs_.clear();
+    by_name_.clear();
+    by_ext_.clear();
+    live_ = 0;
+
+    // Parents precede children, so directory paths can be built in one pass
+    std::unordered_map<uint32_t, std::string> dir_paths;
+    dir_paths[0] = root_;
+    for (uint32_t id = 0; id < entries_.size(); ++id) {
+        const auto& e = entries_[id];
+        if (!e.live) continue;
+        ++live_;
+        if (id != 0) {
+            children_[e.parent].push_back(id);
+            index_names(id);
+        }
+        if (e.type != DT_DIR) continue;
+        if (id != 0) dir_paths[id] = join(dir_paths[e.parent], name_of(id));
+        dirs_[dir_paths[id]] = id;
+    }
+}
+
+void FileIndex::compact() {
+    std::vector<Entry> entries;
+    std::vector<char> names;
+    std::vector<uint32_t> remap;
+    compact_into(entries_, names_, entries, names, remap);
+
+    std::unordered_map<uint32_t, int> watches;
+    for (const auto& [id, wd] : watches_) watches[remap[id]] = wd;
+
+    entries_ = std::move(entries);
+    names_ = std::move(names);
+    watches_ = std::move(watches);
+    rebuild_maps();
+}
+
+uint32_t FileIndex::find_dir(const std::string& path) const {
+    auto it = dirs_.find(path);
+    return it == dirs_.end() ? UINT32_MAX : it->second;
+}
+
+void FileIndex::match_into(uint32_t id, uint32_t base, int max_depth, const GlobMatcher& matcher,
+                           std::vector<uint32_t>& out, size_t limit) const {
+    // Depth-first over the children of `id`, for sub-root queries
+    std::vector<uint32_t> stack{id};
+    int base_depth = entries_[base].depth;
+    std::string scratch;
+    while (!stack.empty() && out.size() < limit) {
+        uint32_t cur = stack.back();
+        stack.pop_back();
+        auto it = children_.find(cur);
+        if (it == children_.end()) continue;
+        for (uint32_t child : it->second) {
+            const auto& e = entries_[child];
+            if (matches(matcher, name_of(child), scratch)) {
+                out.push_back(child);
+                if (out.size() >= limit) return;
+            }
+            if (e.type == DT_DIR && e.depth - base_depth <= max_depth) stack.push_back(child);
+        }
+    }
+}
+
+std::vector<FileSearchResult> FileIndex::search(const std::string& root, const std::string& pattern,
+                                                int max_depth, int max_results) const {
+    std::vector<FileSearchResult> results;
+    if (max_results <= 0 || max_depth < 0) return results;
+    const GlobMatcher matcher(pattern);
+    const auto limit = static_cast<size_t>(max_results);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint32_t base = find_dir(normalize(root));
+    if (base == UINT32_MAX) return results;
+    const int base_depth = entries_[base].depth;
+
+    // Same depth rule as DirWalker: entries of a directory at depth d are
+    // listed while d <= max_depth, counting the search root as 0.
+    auto in_scope = [&](uint32_t id) {
+        const auto& e = entries_[id];
+        if (!e.live || e.depth - base_depth - 1 > max_depth) return false;
+        if (base == 0) return true;
+        uint32_t cur = id;
+        while (entries_[cur].depth > base_depth) cur = entries_[cur].parent;
+        return cur == base;
+    };
+
+    std::vector<uint32_t> hits;
+    std::string scratch;
+    const std::vector<uint32_t>* candidates = nullptr;
+    std::string_view ext;
+    if (matcher.kind() == GlobMatcher::Kind::Exact) {
+        auto it = by_name_.find(matcher.literal());
+        if (it == by_name_.end()) return results;
+        candidates = &it->second;
+    } else if (matcher.kind() == GlobMatcher::Kind::Suffix && extension_of(matcher.literal(), ext)) {
+        auto it = by_ext_.find(std::string(ext));
+        if (it == by_ext_.end()) return results;
+        candidates = &it->second;
+    }
+
+    if (candidates) {
+        for (uint32_t id : *candidates) {
+            if (in_scope(id) && matches(matcher, name_of(id), scratch)) {
+                hits.push_back(id);
+                if (hits.size() >= limit) break;
+            }
+        }
+    } else if (base == 0) {
+        for (uint32_t id = 1; id < entries_.size(); ++id) {
+            if (in_scope(id) && matches(matcher, name_of(id), scratch)) {
+                hits.push_back(id);
+                if (hits.size() >= limit) break;
+            }
+        }
+    } else {
+        match_into(base, base, max_depth, matcher, hits, limit);
+    }
+
+    results.reserve(hits.size());
+    for (uint32_t id : hits) {
+        const auto& e = entries_[id];
+        FileSearchResult r;
+        r.path = path_of(id);
+        r.is_dir = e.type == DT_DIR;
+        r.size = r.is_dir ? 0 : e.size;
+        results.push_back(std::move(r));
+    }
+    std::sort(results.begin(), results.end(),
+              [](const FileSearchResult& a, const FileSearchResult& b) { return a.path < b.path; });
+    return results;
+}
+
+size_t FileIndex::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return live_ > 0 ? live_ - 1 : 0;
+}
+
+bool FileIndex::fully_watched() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return unwatched_ == 0;
+}
+
+} // namespace agent_kernel
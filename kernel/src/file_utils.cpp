@@ -1,166 +1,118 @@
 #include "agent_kernel/file_utils.h"
+#include "agent_kernel/dir_walker.h"
+#include "agent_kernel/disk_usage.h"
+#include "agent_kernel/glob_matcher.h"
+#include "agent_kernel/stats.h"
 
 #include <dirent.h>
-#include <fnmatch.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
-#include <fstream>
+#include <cerrno>
+#include <cstring>
 #include <functional>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
 namespace agent_kernel {
 
-namespace {
-
-void search_recursive(
-    const std::string& dir,
-    const std::string& pattern,
-    int depth,
-    int max_depth,
-    int max_results,
-    std::vector<FileSearchResult>& results
-) {
-    if (depth > max_depth || static_cast<int>(results.size()) >= max_results) return;
-
-    DIR* d = opendir(dir.c_str());
-    if (!d) return;
-
-    struct dirent* entry;
-    while ((entry = readdir(d)) != nullptr) {
-        if (static_cast<int>(results.size()) >= max_results) break;
-
-        const char* name = entry->d_name;
-        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
-            continue;
-
-        std::string full_path = dir + "/" + name;
-
-        struct stat st;
-        if (lstat(full_path.c_str(), &st) != 0) continue;
-
-        bool is_dir = S_ISDIR(st.st_mode);
-
-        // Match against pattern
-        if (fnmatch(pattern.c_str(), name, FNM_CASEFOLD) == 0) {
-            FileSearchResult r;
-            r.path = full_path;
-            r.size = is_dir ? 0 : static_cast<uint64_t>(st.st_size);
-            r.is_dir = is_dir;
-            results.push_back(std::move(r));
-        }
-
-        // Recurse into directories (skip symlinks to avoid loops)
-        if (is_dir && !S_ISLNK(st.st_mode)) {
-            search_recursive(full_path, pattern, depth + 1, max_depth, max_results, results);
-        }
+size_t pread_full(int fd, char* buf, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pread(fd, buf + done, count - done, offset + static_cast<off_t>(done));
+        Stats::count(Syscall::Read);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
     }
-    closedir(d);
+    return done;
 }
 
-} // anonymous namespace
-
 std::vector<FileSearchResult> FileUtils::search(
     const std::string& root,
     const std::string& pattern,
     int max_depth,
-    int max_results
+    int max_results,
+    bool with_size
 ) {
+    ProbeTimer timer(Probe::FileSearch);
     std::vector<FileSearchResult> results;
+    if (max_results <= 0) return results;
     results.reserve(std::min(max_results, 256));
-    search_recursive(root, pattern, 0, max_depth, max_results, results);
+
+    const GlobMatcher matcher(pattern);
+    std::mutex mtx;
+    WalkOptions options;
+    options.max_depth = max_depth;
+
+    DirWalker::walk(root, options, [&](const WalkEntry& e) {
+        if (!matcher.match(e.name)) return true;
+
+        FileSearchResult r;
+        r.is_dir = e.type == DT_DIR;
+        r.size = 0;
+        if (with_size && !r.is_dir) {
+            struct stat st;
+            Stats::count(Syscall::Stat);
+            if (fstatat(e.dir_fd, e.name, &st, AT_SYMLINK_NOFOLLOW) == 0) r.size = static_cast<uint64_t>(st.st_size);
+        }
+        r.path = e.path();
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (static_cast<int>(results.size()) >= max_results) return false;
+        results.push_back(std::move(r));
+        return static_cast<int>(results.size()) < max_results;
+    });
+
+    // Threads finish in any order; keep the output stable
+    std::sort(results.begin(), results.end(),
+              [](const FileSearchResult& a, const FileSearchResult& b) { return a.path < b.path; });
     return results;
 }
 
 std::string FileUtils::tail(const std::string& path, int lines) {
-    std::ifstream f(path, std::ios::ate | std::ios::binary);
-    if (!f.is_open()) {
+    ProbeTimer timer(Probe::FileTail);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
         throw std::runtime_error("Cannot open file: " + path);
     }
-
-    auto size = f.tellg();
-    if (size == std::streampos(0)) return "";
-
-    // Read backwards to find enough newlines, collecting chunks in a vector
-    // to avoid O(n²) string prepend.
-    int newline_count = 0;
-    std::streampos pos = size;
-    const std::streamsize chunk_size = 4096;
-    std::vector<std::string> chunks;
-
-    while (pos > std::streampos(0) && newline_count <= lines) {
-        auto read_size = std::min(static_cast<std::streamsize>(pos), chunk_size);
-        pos -= read_size;
-        f.seekg(pos);
-
-        std::string chunk(static_cast<size_t>(read_size), '\0');
-        f.read(&chunk[0], read_size);
-
-        for (char c : chunk) {
-            if (c == '\n') ++newline_count;
-        }
-        chunks.push_back(std::move(chunk));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || lines <= 0) {
+        close(fd);
+        return "";
     }
 
-    // Concatenate in correct order (chunks were collected in reverse)
-    std::string result;
-    for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
-        result += *it;
+    // Output is capped at kTailMaxBytes, so nothing before that window can
+    // matter: one pread of the window, then find the cut point in place.
+    auto size = static_cast<uint64_t>(st.st_size);
+    size_t window = static_cast<size_t>(std::min<uint64_t>(size, kTailMaxBytes));
+    std::string result(window, '\0');
+    size_t got = pread_full(fd, &result[0], window, static_cast<off_t>(size - window));
+    close(fd);
+    result.resize(got);
+
+    // A final newline terminates the last line rather than starting one
+    size_t pos = result.size();
+    if (pos > 0 && result[pos - 1] == '\n') --pos;
+    for (int i = 0; i < lines; ++i) {
+        auto* nl = static_cast<const char*>(memrchr(result.data(), '\n', pos));
+        if (!nl) return result;
+        pos = static_cast<size_t>(nl - result.data());
     }
-
-    // Trim to last N lines
-    if (newline_count > lines) {
-        int skip = newline_count - lines;
-        size_t idx = 0;
-        for (int i = 0; i < skip && idx < result.size(); ++i) {
-            idx = result.find('\n', idx);
-            if (idx == std::string::npos) break;
-            ++idx;
-        }
-        if (idx < result.size()) {
-            result = result.substr(idx);
-        }
-    }
-
-    // Cap output at 64KB
-    if (result.size() > 65536) {
-        result = result.substr(result.size() - 65536);
-    }
-
+    result.erase(0, pos + 1);
     return result;
 }
 
-namespace {
-uint64_t dir_size_impl(const std::string& path, int depth, int max_depth) {
-    if (depth > max_depth) return 0;
-    uint64_t total = 0;
-    DIR* d = opendir(path.c_str());
-    if (!d) return 0;
-
-    struct dirent* entry;
-    while ((entry = readdir(d)) != nullptr) {
-        const char* name = entry->d_name;
-        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
-            continue;
-
-        std::string full = path + "/" + name;
-        struct stat st;
-        if (lstat(full.c_str(), &st) != 0) continue;
-
-        if (S_ISDIR(st.st_mode) && !S_ISLNK(st.st_mode)) {
-            total += dir_size_impl(full, depth + 1, max_depth);
-        } else if (S_ISREG(st.st_mode)) {
-            total += static_cast<uint64_t>(st.st_size);
-        }
-    }
-    closedir(d);
-    return total;
-}
-} // anonymous namespace
-
 uint64_t FileUtils::dir_size(const std::string& path) {
-    return dir_size_impl(path, 0, 20);  // safety cap at 20 levels
+    ProbeTimer timer(Probe::FileDirSize);
+    try {
+        return DiskUsage::shared().scan(path, 0).total.apparent_bytes;
+    } catch (const std::runtime_error&) {
+        return 0;
+    }
 }
 
 } // namespace agent_kernel
@@ -1,10 +1,18 @@
 #include "agent_kernel/fs_watcher.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/fanotify.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
 #include <unistd.h>
 #include <poll.h>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
+#include <string_view>
 #include <cstring>
 #include <cerrno>
 
@@ -12,6 +20,8 @@ namespace agent_kernel {
 
 namespace {
 
+constexpr size_t kBufferSize = 64 * 1024;
+
 uint32_t event_type_to_inotify(uint32_t mask) {
     uint32_t flags = 0;
     if (mask & static_cast<uint32_t>(FSEventType::Created))  flags |= IN_CREATE;
@@ -29,9 +39,84 @@ FSEventType inotify_to_event_type(uint32_t mask) {
     return FSEventType::Modified; // fallback
 }
 
+std::string join(const std::string& dir, std::string_view name) {
+    std::string p;
+    p.reserve(dir.size() + 1 + name.size());
+    p.append(dir);
+    if (p.empty() || p.back() != '/') p.push_back('/');
+    p.append(name);
+    return p;
+}
+
+bool is_dot(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
 } // anonymous namespace
 
-FSWatcher::FSWatcher() {
+/// Events of one poll() call, written into the caller's vector in place.
+/// Repeats of the most recent event for a path are dropped, as is Modified
+/// right after Created.
+struct FSWatcher::Batch {
+    std::vector<FSEvent>& out;
+    size_t count = 0;
+    bool overflow = false;
+    std::unordered_map<size_t, size_t> last;   // hash(path, name) -> index in out
+
+    explicit Batch(std::vector<FSEvent>& o) : out(o) {}
+
+    void push(FSEventType type, const std::string& path, std::string_view name, bool is_dir) {
+        size_t key = std::hash<std::string_view>{}(path) * 31 + std::hash<std::string_view>{}(name);
+        auto it = last.find(key);
+        if (it != last.end()) {
+            const FSEvent& prev = out[it->second];
+            if (prev.path == path && prev.name == name &&
+                (prev.type == type || (prev.type == FSEventType::Created && type == FSEventType::Modified))) {
+                return;
+            }
+        }
+        FSEvent& ev = slot();
+        ev.type = type;
+        ev.path.assign(path);
+        ev.name.assign(name.data(), name.size());
+        ev.is_dir = is_dir;
+        last[key] = count - 1;
+    }
+
+    void push_overflow() {
+        if (overflow) return;
+        overflow = true;
+        FSEvent& ev = slot();
+        ev.type = FSEventType::Overflow;
+        ev.path.clear();
+        ev.name.clear();
+        ev.is_dir = false;
+    }
+
+    FSEvent& slot() {
+        if (count == out.size()) out.emplace_back();
+        return out[count++];
+    }
+};
+
+/// fanotify state: one directory fd per marked filesystem (needed by
+/// open_by_handle_at) and a cache of directory handle -> path.
+struct FSWatcher::Mount {
+    struct Fs {
+        fsid_t fsid;
+        int fd;
+    };
+    std::vector<Fs> filesystems;
+    uint32_t mask = 0;
+    std::unordered_map<std::string, std::string> dir_paths;
+
+    ~Mount() {
+        for (auto& fs : filesystems) close(fs.fd);
+    }
+};
+
+FSWatcher::FSWatcher(int debounce_ms)
+    : debounce_ms_(std::max(debounce_ms, 0)), buf_(new char[kBufferSize]) {
     inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
     if (inotify_fd_ < 0) {
         throw std::runtime_error(std::string("inotify_init1 failed: ") + strerror(errno));
@@ -43,55 +128,292 @@ FSWatcher::~FSWatcher() {
         inotify_rm_watch(inotify_fd_, wd);
     }
     close(inotify_fd_);
+    if (fanotify_fd_ >= 0) close(fanotify_fd_);
 }
 
-int FSWatcher::watch(const std::string& path, uint32_t mask) {
+int FSWatcher::add_watch(const std::string& path, uint32_t mask, int root) {
     uint32_t flags = event_type_to_inotify(mask);
+    // A recursive watch has to see new and renamed subdirectories
+    if (root != -1) flags |= IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO;
     int wd = inotify_add_watch(inotify_fd_, path.c_str(), flags);
     if (wd < 0) {
         throw std::runtime_error("inotify_add_watch failed for " + path + ": " + strerror(errno));
     }
-    watch_paths_[wd] = path;
+    watch_paths_[wd] = Watch{path, mask, root == 0 ? wd : root};
     return wd;
 }
 
+// Watch `path` and every directory below it. Each directory is watched
+// before it is listed, so entries created meanwhile raise events; with
+// `created`, the listed entries are also reported as Created.
+void FSWatcher::add_tree(const std::string& path, uint32_t mask, int root, Batch* created) {
+    std::vector<std::string> stack{path};
+    while (!stack.empty()) {
+        std::string dir = std::move(stack.back());
+        stack.pop_back();
+
+        try {
+            add_watch(dir, mask, root);
+        } catch (const std::runtime_error&) {
+            if (!created) throw;
+            created->push_overflow();   // out of watches, or it vanished
+            continue;
+        }
+
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) continue;
+        DIR* d = fdopendir(fd);
+        if (!d) {
+            close(fd);
+            continue;
+        }
+        while (struct dirent* de = readdir(d)) {
+            if (is_dot(de->d_name)) continue;
+            bool is_dir = de->d_type == DT_DIR;
+            if (de->d_type == DT_UNKNOWN) {
+                struct stat st;
+                is_dir = fstatat(fd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (created && (mask & static_cast<uint32_t>(FSEventType::Created))) {
+                created->push(FSEventType::Created, dir, de->d_name, is_dir);
+            }
+            if (is_dir) stack.push_back(join(dir, de->d_name));
+        }
+        closedir(d);
+    }
+}
+
+// Drop the watches of a directory that moved out from under a recursive watch.
+void FSWatcher::remove_tree(const std::string& path, int root) {
+    for (auto it = watch_paths_.begin(); it != watch_paths_.end();) {
+        const std::string& p = it->second.path;
+        bool inside = p.compare(0, path.size(), path) == 0 && (p.size() == path.size() || p[path.size()] == '/');
+        if (it->second.root == root && it->first != root && inside) {
+            inotify_rm_watch(inotify_fd_, it->first);
+            it = watch_paths_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int FSWatcher::watch(const std::string& path, uint32_t mask, bool recursive) {
+    if (!recursive) return add_watch(path, mask, -1);
+
+    int wd = add_watch(path, mask, 0);
+    try {
+        add_tree(path, mask, wd, nullptr);
+    } catch (...) {
+        unwatch(wd);
+        throw;
+    }
+    return wd;
+}
+
+void FSWatcher::watch_mount(const std::string& path, uint32_t mask) {
+#ifdef FAN_REPORT_DFID_NAME
+    int dir_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + strerror(errno));
+    }
+    struct statfs sfs;
+    if (fstatfs(dir_fd, &sfs) != 0) {
+        int err = errno;
+        close(dir_fd);
+        throw std::runtime_error("fstatfs failed for " + path + ": " + strerror(err));
+    }
+
+    if (fanotify_fd_ < 0) {
+        fanotify_fd_ = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME,
+                                     O_RDONLY | O_CLOEXEC);
+        if (fanotify_fd_ < 0) {
+            int err = errno;
+            close(dir_fd);
+            throw std::runtime_error(std::string("fanotify_init failed: ") + strerror(err));
+        }
+        mount_ = std::make_unique<Mount>();
+    }
+
+    uint64_t events = FAN_ONDIR;
+    if (mask & static_cast<uint32_t>(FSEventType::Created))  events |= FAN_CREATE;
+    if (mask & static_cast<uint32_t>(FSEventType::Modified)) events |= FAN_MODIFY;
+    if (mask & static_cast<uint32_t>(FSEventType::Deleted))  events |= FAN_DELETE;
+    if (mask & static_cast<uint32_t>(FSEventType::Moved))    events |= FAN_MOVED_FROM | FAN_MOVED_TO;
+    if (fanotify_mark(fanotify_fd_, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, events, AT_FDCWD, path.c_str()) != 0) {
+        int err = errno;
+        close(dir_fd);
+        throw std::runtime_error("fanotify_mark failed for " + path + ": " + strerror(err));
+    }
+    mount_->mask |= mask;
+    mount_->filesystems.push_back(Mount::Fs{sfs.f_fsid, dir_fd});
+#else
+    (void)path;
+    (void)mask;
+    throw std::runtime_error("fanotify FAN_REPORT_DFID_NAME not supported by this build");
+#endif
+}
+
 void FSWatcher::unwatch(int wd) {
+    auto it = watch_paths_.find(wd);
+    if (it != watch_paths_.end() && it->second.root == wd) {
+        for (auto sub = watch_paths_.begin(); sub != watch_paths_.end();) {
+            if (sub->second.root == wd && sub->first != wd) {
+                inotify_rm_watch(inotify_fd_, sub->first);
+                sub = watch_paths_.erase(sub);
+            } else {
+                ++sub;
+            }
+        }
+    }
     inotify_rm_watch(inotify_fd_, wd);
     watch_paths_.erase(wd);
 }
 
-std::vector<FSEvent> FSWatcher::poll(int timeout_ms) {
-    std::vector<FSEvent> events;
+bool FSWatcher::drain_inotify(Batch& batch) {
+    bool any = false;
+    for (;;) {
+        ssize_t len = read(inotify_fd_, buf_.get(), kBufferSize);
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) break;
+        any = true;
 
-    struct pollfd pfd{};
-    pfd.fd = inotify_fd_;
-    pfd.events = POLLIN;
+        for (char* ptr = buf_.get(); ptr < buf_.get() + len; ) {
+            auto* ev = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + ev->len;
 
-    int ret = ::poll(&pfd, 1, timeout_ms);
-    if (ret <= 0) return events;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                batch.push_overflow();
+                continue;
+            }
+            auto it = watch_paths_.find(ev->wd);
+            if (it == watch_paths_.end()) continue;
+            if (ev->mask & IN_IGNORED) {
+                watch_paths_.erase(it);   // directory deleted or unmounted
+                continue;
+            }
 
-    // Read all available events
-    alignas(struct inotify_event) char buf[4096];
-    ssize_t len = read(inotify_fd_, buf, sizeof(buf));
-    if (len <= 0) return events;
+            std::string_view name(ev->name, ev->len > 0 ? strnlen(ev->name, ev->len) : 0);
+            bool is_dir = ev->mask & IN_ISDIR;
+            FSEventType type = inotify_to_event_type(ev->mask);
+            const uint32_t mask = it->second.mask;
+            const int root = it->second.root;
+            if (mask & static_cast<uint32_t>(type)) batch.push(type, it->second.path, name, is_dir);
 
-    for (char* ptr = buf; ptr < buf + len; ) {
-        auto* ev = reinterpret_cast<struct inotify_event*>(ptr);
+            if (root != -1 && is_dir && !name.empty()) {
+                // add_tree/remove_tree may rehash watch_paths_; copy first
+                std::string child = join(it->second.path, name);
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    add_tree(child, mask, root, &batch);
+                } else if (ev->mask & IN_MOVED_FROM) {
+                    remove_tree(child, root);
+                }
+            }
+        }
+    }
+    return any;
+}
 
-        FSEvent fse;
-        fse.type = inotify_to_event_type(ev->mask);
-        fse.name = (ev->len > 0) ? std::string(ev->name) : "";
+bool FSWatcher::drain_fanotify(Batch& batch) {
+    if (fanotify_fd_ < 0) return false;
+#ifdef FAN_REPORT_DFID_NAME
+    bool any = false;
+    for (;;) {
+        ssize_t len = read(fanotify_fd_, buf_.get(), kBufferSize);
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) break;
+        any = true;
 
-        auto it = watch_paths_.find(ev->wd);
-        fse.path = (it != watch_paths_.end()) ? it->second : "";
+        auto* meta = reinterpret_cast<struct fanotify_event_metadata*>(buf_.get());
+        for (; FAN_EVENT_OK(meta, len); meta = FAN_EVENT_NEXT(meta, len)) {
+            if (meta->fd >= 0) close(meta->fd);
+            if (meta->mask & FAN_Q_OVERFLOW) {
+                batch.push_overflow();
+                continue;
+            }
+            if (meta->event_len < sizeof(*meta) + sizeof(struct fanotify_event_info_fid)) continue;
+            auto* info = reinterpret_cast<struct fanotify_event_info_fid*>(meta + 1);
+            if (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) continue;
 
-        events.push_back(std::move(fse));
-        ptr += sizeof(struct inotify_event) + ev->len;
+            auto* handle = reinterpret_cast<struct file_handle*>(info->handle);
+            const char* name = reinterpret_cast<const char*>(handle->f_handle) + handle->handle_bytes;
+            if (name[0] == '.' && name[1] == '\0') continue;   // event on the directory itself
+
+            FSEventType type = FSEventType::Modified;
+            if (meta->mask & FAN_CREATE) type = FSEventType::Created;
+            else if (meta->mask & FAN_DELETE) type = FSEventType::Deleted;
+            else if (meta->mask & (FAN_MOVED_FROM | FAN_MOVED_TO)) type = FSEventType::Moved;
+            if (!(mount_->mask & static_cast<uint32_t>(type))) continue;
+            bool is_dir = meta->mask & FAN_ONDIR;
+
+            std::string key(reinterpret_cast<const char*>(handle), sizeof(*handle) + handle->handle_bytes);
+            auto cached = mount_->dir_paths.find(key);
+            if (cached == mount_->dir_paths.end()) {
+                int mount_fd = -1;
+                for (const auto& fs : mount_->filesystems) {
+                    if (std::memcmp(&fs.fsid, &info->fsid, sizeof(fs.fsid)) == 0) mount_fd = fs.fd;
+                }
+                int fd = mount_fd < 0 ? -1 : open_by_handle_at(mount_fd, handle, O_PATH | O_CLOEXEC);
+                if (fd < 0) continue;   // directory already gone
+                char link[64], target[4096];
+                snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+                ssize_t n = readlink(link, target, sizeof(target));
+                close(fd);
+                if (n <= 0) continue;
+                cached = mount_->dir_paths.emplace(std::move(key), std::string(target, static_cast<size_t>(n))).first;
+            }
+            batch.push(type, cached->second, name, is_dir);
+
+            // Renamed or removed directories invalidate cached paths below them
+            if (is_dir && (type == FSEventType::Deleted || type == FSEventType::Moved)) mount_->dir_paths.clear();
+        }
     }
+    return any;
+#else
+    (void)batch;
+    return false;
+#endif
+}
 
+std::vector<FSEvent> FSWatcher::poll(int timeout_ms) {
+    std::vector<FSEvent> events;
+    poll_into(events, timeout_ms);
     return events;
 }
 
+size_t FSWatcher::poll_into(std::vector<FSEvent>& out, int timeout_ms) {
+    Batch batch(out);
+
+    struct pollfd pfds[2]{};
+    pfds[0].fd = inotify_fd_;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = fanotify_fd_;
+    pfds[1].events = POLLIN;
+    const nfds_t nfds = fanotify_fd_ >= 0 ? 2 : 1;
+
+    int ret = ::poll(pfds, nfds, timeout_ms);
+    if (ret > 0) {
+        drain_inotify(batch);
+        drain_fanotify(batch);
+
+        // Bursts (checkouts, installs) arrive over several milliseconds;
+        // wait for a quiet period, but never more than ten of them.
+        if (debounce_ms_ > 0) {
+            using clock = std::chrono::steady_clock;
+            auto deadline = clock::now() + std::chrono::milliseconds(debounce_ms_ * 10);
+            for (;;) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+                if (left <= 0) break;
+                if (::poll(pfds, nfds, static_cast<int>(std::min<int64_t>(left, debounce_ms_))) <= 0) break;
+                drain_inotify(batch);
+                drain_fanotify(batch);
+            }
+        }
+    }
+
+    out.resize(batch.count);
+    return batch.count;
+}
+
 size_t FSWatcher::watch_count() const noexcept {
     return watch_paths_.size();
 }
@@ -0,0 +1,111 @@
+#include "agent_kernel/glob_matcher.h"
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace agent_kernel {
+
+namespace {
+
+inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // anonymous namespace
+
+GlobMatcher::GlobMatcher(std::string pattern, bool case_insensitive)
+    : pattern_(std::move(pattern)), fold_(case_insensitive) {
+    const std::string& p = pattern_;
+    if (p.find_first_of("[\\") != std::string::npos) {
+        kind_ = Kind::Fnmatch;
+        return;
+    }
+
+    literal_ = p;
+    if (fold_) std::transform(literal_.begin(), literal_.end(), literal_.begin(), lower);
+
+    bool has_question = p.find('?') != std::string::npos;
+    size_t stars = static_cast<size_t>(std::count(p.begin(), p.end(), '*'));
+    size_t n = p.size();
+    if (has_question) {
+        kind_ = Kind::Wildcard;
+    } else if (stars == 0) {
+        kind_ = Kind::Exact;
+    } else if (stars == n) {
+        kind_ = Kind::Any;
+    } else if (stars == 1 && p[n - 1] == '*') {
+        kind_ = Kind::Prefix;
+        literal_.pop_back();
+    } else if (stars == 1 && p[0] == '*') {
+        kind_ = Kind::Suffix;
+        literal_.erase(0, 1);
+    } else if (stars == 2 && n > 2 && p[0] == '*' && p[n - 1] == '*') {
+        kind_ = Kind::Contains;
+        literal_ = literal_.substr(1, n - 2);
+    } else {
+        kind_ = Kind::Wildcard;
+    }
+}
+
+bool GlobMatcher::equal(std::string_view a, std::string_view lit) const {
+    if (a.size() != lit.size()) return false;
+    if (!fold_) return a == lit;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (lower(a[i]) != lit[i]) return false;
+    }
+    return true;
+}
+
+// Classic two-pointer glob: on mismatch, retry from just after the last '*'
+// with one more character consumed by it. O(n*m) worst case, no allocation.
+bool GlobMatcher::wildcard(std::string_view name) const {
+    const std::string& p = literal_;
+    size_t pi = 0, ni = 0;
+    size_t star = std::string::npos, resume = 0;
+    while (ni < name.size()) {
+        char c = fold_ ? lower(name[ni]) : name[ni];
+        if (pi < p.size() && (p[pi] == '?' || p[pi] == c)) {
+            ++pi;
+            ++ni;
+        } else if (pi < p.size() && p[pi] == '*') {
+            star = pi++;
+            resume = ni;
+        } else if (star != std::string::npos) {
+            pi = star + 1;
+            ni = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (pi < p.size() && p[pi] == '*') ++pi;
+    return pi == p.size();
+}
+
+bool GlobMatcher::match(std::string_view name) const {
+    const size_t n = literal_.size();
+    switch (kind_) {
+        case Kind::Any:
+            return true;
+        case Kind::Exact:
+            return equal(name, literal_);
+        case Kind::Prefix:
+            return name.size() >= n && equal(name.substr(0, n), literal_);
+        case Kind::Suffix:
+            return name.size() >= n && equal(name.substr(name.size() - n), literal_);
+        case Kind::Contains:
+            if (name.size() < n) return false;
+            for (size_t i = 0; i + n <= name.size(); ++i) {
+                if (equal(name.substr(i, n), literal_)) return true;
+            }
+            return false;
+        case Kind::Wildcard:
+            return wildcard(name);
+        case Kind::Fnmatch:
+            return fnmatch(pattern_.c_str(), name.data(), fold_ ? FNM_CASEFOLD : 0) == 0;
+    }
+    return false;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,81 @@
+#include "agent_kernel/interface_sampler.h"
+#include "agent_kernel/rtnl_link.h"
+
+#include <net/if.h>
+
+#include <cstdint>
+
+namespace agent_kernel {
+
+namespace {
+
+uint64_t counter_delta(uint64_t prev, uint64_t cur) {
+    if (cur >= prev) return cur - prev;
+    // Drivers exporting 32-bit counters wrap at 2^32, so a wrap starts from
+    // the top half of that range; anything else went backwards because the
+    // device was reset.
+    constexpr uint64_t kWrap = uint64_t{1} << 32;
+    if (prev < kWrap && prev >= kWrap / 2 && cur < kWrap / 2) return kWrap - prev + cur;
+    return cur;
+}
+
+} // anonymous namespace
+
+std::vector<InterfaceRates> InterfaceSampler::sample() {
+    thread_local std::vector<LinkRecord> links;
+    if (!RtnlLinkReader::shared().read(links)) {
+        links.clear();
+        for (auto& st : NetworkMonitor::interfaces()) {
+            LinkRecord rec{};
+            // /proc/net/dev has no flags; assume up, loopback by name
+            rec.flags = IFF_UP | (st.name == "lo" ? static_cast<unsigned>(IFF_LOOPBACK) : 0u);
+            rec.ifindex = static_cast<int>(if_nametoindex(st.name.c_str()));
+            rec.stats = std::move(st);
+            links.push_back(std::move(rec));
+        }
+    }
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<InterfaceRates> result;
+    result.reserve(links.size());
+    std::unordered_map<std::string, Prev> next;
+    next.reserve(links.size());
+
+    for (auto& link : links) {
+        const InterfaceStats& cur = link.stats;
+        InterfaceRates r{};
+        r.name = cur.name;
+        r.up = (link.flags & IFF_UP) != 0;
+        r.loopback = (link.flags & IFF_LOOPBACK) != 0;
+        r.totals = cur;
+
+        // A name that now belongs to another ifindex is a recreated device
+        // (veth, tun): its counters restarted, so it gets no rate this tick.
+        auto it = prev_.find(cur.name);
+        if (it != prev_.end() && it->second.ifindex == link.ifindex) {
+            double dt = std::chrono::duration<double>(now - it->second.time).count();
+            if (dt > 0) {
+                const InterfaceStats& old = it->second.stats;
+                auto rate = [dt](uint64_t a, uint64_t b) { return static_cast<double>(counter_delta(a, b)) / dt; };
+                r.interval_sec = dt;
+                r.rx_bytes_per_sec = rate(old.rx_bytes, cur.rx_bytes);
+                r.tx_bytes_per_sec = rate(old.tx_bytes, cur.tx_bytes);
+                r.rx_packets_per_sec = rate(old.rx_packets, cur.rx_packets);
+                r.tx_packets_per_sec = rate(old.tx_packets, cur.tx_packets);
+                r.rx_errors_per_sec = rate(old.rx_errors, cur.rx_errors);
+                r.tx_errors_per_sec = rate(old.tx_errors, cur.tx_errors);
+                r.rx_dropped_per_sec = rate(old.rx_dropped, cur.rx_dropped);
+                r.tx_dropped_per_sec = rate(old.tx_dropped, cur.tx_dropped);
+            }
+        }
+        next[cur.name] = Prev{cur, link.ifindex, now};
+        result.push_back(std::move(r));
+    }
+
+    // Interfaces that disappeared are forgotten, so a recreated one starts fresh.
+    prev_.swap(next);
+    return result;
+}
+
+} // namespace agent_kernel
@@ -1,7 +1,7 @@
 #include "agent_kernel/metrics.h"
+#include "agent_kernel/proc_file.h"
+#include "agent_kernel/stats.h"
 
-#include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <sys/statvfs.h>
 #include <mntent.h>
@@ -14,15 +14,6 @@ namespace agent_kernel {
 
 namespace {
 
-uint64_t parse_kb(const std::string& line) {
-    // Format: "MemTotal:       16384000 kB"
-    std::istringstream iss(line);
-    std::string label;
-    uint64_t value;
-    iss >> label >> value;
-    return value;
-}
-
 struct CpuTicks {
     uint64_t user, nice, system, idle, iowait, irq, softirq, steal;
 
@@ -34,69 +25,113 @@ struct CpuTicks {
     }
 };
 
-CpuTicks read_cpu_ticks() {
-    std::ifstream f("/proc/stat");
-    if (!f.is_open()) throw std::runtime_error("Cannot read /proc/stat");
+// procfs files held open across calls. Mutex guards the files and the
+// previous CPU sample because the GIL is released on these methods.
+struct MetricsFiles {
+    std::mutex mtx;
+    ProcFile stat{"/proc/stat"};
+    ProcFile meminfo{"/proc/meminfo"};
+    ProcFile loadavg{"/proc/loadavg"};
+    CpuTicks prev_ticks{};
+    bool has_prev = false;
+};
 
-    std::string label;
-    CpuTicks t{};
-    f >> label >> t.user >> t.nice >> t.system >> t.idle
-      >> t.iowait >> t.irq >> t.softirq >> t.steal;
-    return t;
+MetricsFiles& files() {
+    static MetricsFiles f;
+    return f;
 }
 
-} // anonymous namespace
+struct StatSample {
+    CpuTicks ticks{};
+    uint32_t procs_running = 0;
+    uint32_t procs_blocked = 0;
+};
 
-CpuInfo SystemMetrics::cpu() {
+StatSample read_stat(ProcFile& f) {
+    if (!f.read()) throw std::runtime_error("Cannot read /proc/stat");
+
+    StatSample s;
+    FieldCursor cur = f.cursor();
+    // First line is the aggregate "cpu  user nice system idle ..."
+    if (cur.consume("cpu ")) {
+        CpuTicks& t = s.ticks;
+        t.user = cur.next_uint();
+        t.nice = cur.next_uint();
+        t.system = cur.next_uint();
+        t.idle = cur.next_uint();
+        t.iowait = cur.next_uint();
+        t.irq = cur.next_uint();
+        t.softirq = cur.next_uint();
+        t.steal = cur.next_uint();
+    }
+    while (!cur.at_end()) {
+        cur.next_line();
+        if (cur.consume("procs_running ")) s.procs_running = static_cast<uint32_t>(cur.next_uint());
+        else if (cur.consume("procs_blocked ")) s.procs_blocked = static_cast<uint32_t>(cur.next_uint());
+    }
+    return s;
+}
+
+double usage_between(const CpuTicks& a, const CpuTicks& b) {
+    uint64_t total_diff = b.total() - a.total();
+    uint64_t active_diff = b.active() - a.active();
+    return total_diff > 0
+        ? (static_cast<double>(active_diff) / static_cast<double>(total_diff)) * 100.0
+        : 0.0;
+}
+
+// Caller holds files().mtx. Fills the /proc/stat and /proc/loadavg parts
+// of a snapshot; `snap` may be null.
+CpuInfo sample_cpu(MetricsFiles& mf, SystemSnapshot* snap) {
     CpuInfo info{};
 
     // Cache previous tick sample to avoid a blocking sleep on every call.
     // First call still sleeps 100ms; subsequent calls compute delta vs last.
-    // Mutex guards static state because the GIL is released on this method.
-    static std::mutex mtx;
-    static CpuTicks prev_ticks{};
-    static bool has_prev = false;
-
-    std::lock_guard<std::mutex> lock(mtx);
-
-    if (!has_prev) {
-        prev_ticks = read_cpu_ticks();
+    if (!mf.has_prev) {
+        mf.prev_ticks = read_stat(mf.stat).ticks;
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    auto t2 = read_cpu_ticks();
-    uint64_t total_diff = t2.total() - prev_ticks.total();
-    uint64_t active_diff = t2.active() - prev_ticks.active();
-    info.usage_percent = total_diff > 0
-        ? (static_cast<double>(active_diff) / static_cast<double>(total_diff)) * 100.0
-        : 0.0;
-    prev_ticks = t2;
-    has_prev = true;
+    StatSample s = read_stat(mf.stat);
+    info.usage_percent = usage_between(mf.prev_ticks, s.ticks);
+    mf.prev_ticks = s.ticks;
+    mf.has_prev = true;
 
     // Core count
     info.core_count = static_cast<int>(std::thread::hardware_concurrency());
 
-    // Load averages from /proc/loadavg
-    std::ifstream lf("/proc/loadavg");
-    if (lf.is_open()) {
-        lf >> info.load_1m >> info.load_5m >> info.load_15m;
+    // "0.52 0.58 0.59 2/613 12345"
+    uint32_t threads = 0;
+    if (mf.loadavg.read()) {
+        FieldCursor cur = mf.loadavg.cursor();
+        info.load_1m = cur.next_double();
+        info.load_5m = cur.next_double();
+        info.load_15m = cur.next_double();
+        if (cur.skip_past('/')) threads = static_cast<uint32_t>(cur.next_uint());
     }
 
+    if (snap) {
+        snap->procs_running = s.procs_running;
+        snap->procs_blocked = s.procs_blocked;
+        snap->threads_total = threads;
+    }
     return info;
 }
 
-MemInfo SystemMetrics::memory() {
-    MemInfo info{};
-    std::ifstream f("/proc/meminfo");
-    if (!f.is_open()) throw std::runtime_error("Cannot read /proc/meminfo");
+// Caller holds files().mtx.
+MemInfo sample_memory(MetricsFiles& mf) {
+    if (!mf.meminfo.read()) throw std::runtime_error("Cannot read /proc/meminfo");
 
-    std::string line;
+    // Lines look like "MemTotal:       16384000 kB"
+    MemInfo info{};
+    FieldCursor cur = mf.meminfo.cursor();
     int found = 0;
-    while (std::getline(f, line) && found < 4) {
-        if (line.rfind("MemTotal:", 0) == 0)          { info.total_kb = parse_kb(line); ++found; }
-        else if (line.rfind("MemAvailable:", 0) == 0)  { info.available_kb = parse_kb(line); ++found; }
-        else if (line.rfind("SwapTotal:", 0) == 0)     { info.swap_total_kb = parse_kb(line); ++found; }
-        else if (line.rfind("SwapFree:", 0) == 0)      { info.swap_used_kb = info.swap_total_kb - parse_kb(line); ++found; }
+    while (!cur.at_end() && found < 4) {
+        if (cur.consume("MemTotal:"))          { info.total_kb = cur.next_uint(); ++found; }
+        else if (cur.consume("MemAvailable:")) { info.available_kb = cur.next_uint(); ++found; }
+        else if (cur.consume("SwapTotal:"))    { info.swap_total_kb = cur.next_uint(); ++found; }
+        else if (cur.consume("SwapFree:"))     { info.swap_used_kb = info.swap_total_kb - cur.next_uint(); ++found; }
+        cur.next_line();
     }
 
     info.used_kb = info.total_kb - info.available_kb;
@@ -107,7 +142,38 @@ MemInfo SystemMetrics::memory() {
     return info;
 }
 
+} // anonymous namespace
+
+CpuInfo SystemMetrics::cpu() {
+    ProbeTimer timer(Probe::MetricsCpu);
+    auto& mf = files();
+    std::lock_guard<std::mutex> lock(mf.mtx);
+    return sample_cpu(mf, nullptr);
+}
+
+MemInfo SystemMetrics::memory() {
+    ProbeTimer timer(Probe::MetricsMemory);
+    auto& mf = files();
+    std::lock_guard<std::mutex> lock(mf.mtx);
+    return sample_memory(mf);
+}
+
+SystemSnapshot SystemMetrics::snapshot(const std::string& disk_path) {
+    ProbeTimer timer(Probe::MetricsSnapshot);
+    SystemSnapshot snap{};
+    {
+        auto& mf = files();
+        std::lock_guard<std::mutex> lock(mf.mtx);
+        snap.cpu = sample_cpu(mf, &snap);
+        snap.memory = sample_memory(mf);
+    }
+    snap.disk = disk(disk_path);
+    snap.listening = NetworkMonitor::listening_ports();
+    return snap;
+}
+
 DiskInfo SystemMetrics::disk(const std::string& path) {
+    ProbeTimer timer(Probe::MetricsDisk);
     struct statvfs stat{};
     if (statvfs(path.c_str(), &stat) != 0) {
         throw std::runtime_error("statvfs failed for: " + path);
@@ -126,6 +192,7 @@ DiskInfo SystemMetrics::disk(const std::string& path) {
 }
 
 std::vector<DiskInfo> SystemMetrics::all_disks() {
+    ProbeTimer timer(Probe::MetricsAllDisks);
     std::vector<DiskInfo> disks;
     FILE* fp = setmntent("/etc/mtab", "r");
     if (!fp) return disks;
@@ -0,0 +1,299 @@
+#include "agent_kernel/metrics_collector.h"
+#include "agent_kernel/cgroup.h"
+#include "agent_kernel/interface_sampler.h"
+#include "agent_kernel/proc_file.h"
+
+#include <sys/statvfs.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace agent_kernel {
+
+namespace {
+
+struct Ticks {
+    uint64_t total = 0;
+    uint64_t active = 0;
+};
+
+// "cpuN user nice system idle iowait irq softirq steal ..."
+Ticks parse_ticks(FieldCursor& cur) {
+    uint64_t v[8];
+    for (auto& x : v) x = cur.next_uint();
+    Ticks t;
+    for (auto x : v) t.total += x;
+    t.active = t.total - v[3] - v[4];
+    return t;
+}
+
+float percent(const Ticks& a, const Ticks& b) {
+    uint64_t total = b.total - a.total;
+    if (b.total < a.total || total == 0) return 0.0f;
+    return static_cast<float>(static_cast<double>(b.active - a.active) / static_cast<double>(total) * 100.0);
+}
+
+// `name` under a cgroup directory; empty (never opened) if dir is.
+std::string cgroup_file(const std::string& dir, const char* name) {
+    return dir.empty() ? std::string() : dir + "/" + name;
+}
+
+int64_t now_ms() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+// Files are opened once and only ever touched by the sampling thread.
+struct MetricsCollector::Sources {
+    ProcFile stat{"/proc/stat", 16 * 1024};
+    ProcFile meminfo{"/proc/meminfo"};
+    ProcFile loadavg{"/proc/loadavg"};
+    // This process's cgroup: v2 files, with the v1 equivalents as fallback
+    const CgroupLocation& cg = CgroupManager::location();
+    ProcFile cg_mem_v2{cgroup_file(cg.memory == cg.unified ? cg.memory : "", "memory.current"), 64};
+    ProcFile cg_mem_v1{cgroup_file(cg.memory != cg.unified ? cg.memory : "", "memory.usage_in_bytes"), 64};
+    ProcFile cg_cpu_v2{cgroup_file(cg.cpuacct.empty() ? cg.unified : "", "cpu.stat"), 512};
+    ProcFile cg_cpu_v1{cgroup_file(cg.cpuacct, "cpuacct.usage"), 64};
+    InterfaceSampler interfaces;
+
+    bool has_prev = false;
+    Ticks prev_total;
+    std::vector<Ticks> prev_cores;
+    int64_t prev_cg_usec = -1;
+    std::chrono::steady_clock::time_point prev_time;
+
+    void sample(MetricsSample& s, const std::string& disk_path);
+};
+
+void MetricsCollector::Sources::sample(MetricsSample& s, const std::string& disk_path) {
+    std::memset(&s, 0, sizeof(s));
+    s.timestamp_ms = now_ms();
+    auto now = std::chrono::steady_clock::now();
+    double dt = has_prev ? std::chrono::duration<double>(now - prev_time).count() : 0.0;
+
+    // CPU: aggregate line, then one line per core
+    if (stat.read()) {
+        FieldCursor cur = stat.cursor();
+        std::vector<Ticks> cores;
+        cores.reserve(prev_cores.size());
+        Ticks total;
+        while (!cur.at_end()) {
+            if (cur.consume("cpu ")) {
+                total = parse_ticks(cur);
+            } else if (cur.consume("cpu")) {
+                cur.next_uint();  // core index
+                cores.push_back(parse_ticks(cur));
+            } else {
+                break;  // cpu lines come first
+            }
+            cur.next_line();
+        }
+        if (has_prev) {
+            s.cpu_percent = percent(prev_total, total);
+            size_t n = std::min({cores.size(), prev_cores.size(), MetricsSample::kMaxCores});
+            for (size_t i = 0; i < n; ++i) s.core_percent[i] = percent(prev_cores[i], cores[i]);
+            s.core_count = static_cast<uint16_t>(n);
+        }
+        prev_total = total;
+        prev_cores = std::move(cores);
+    }
+
+    if (loadavg.read()) {
+        FieldCursor cur = loadavg.cursor();
+        s.load_1m = static_cast<float>(cur.next_double());
+        s.load_5m = static_cast<float>(cur.next_double());
+        s.load_15m = static_cast<float>(cur.next_double());
+    }
+
+    if (meminfo.read()) {
+        FieldCursor cur = meminfo.cursor();
+        uint64_t swap_total = 0, swap_free = 0;
+        while (!cur.at_end()) {
+            if (cur.consume("MemTotal:")) s.mem_total_kb = cur.next_uint();
+            else if (cur.consume("MemAvailable:")) s.mem_available_kb = cur.next_uint();
+            else if (cur.consume("SwapTotal:")) swap_total = cur.next_uint();
+            else if (cur.consume("SwapFree:")) swap_free = cur.next_uint();
+            cur.next_line();
+        }
+        s.swap_used_kb = swap_total - swap_free;
+    }
+
+    struct statvfs vfs{};
+    if (statvfs(disk_path.c_str(), &vfs) == 0) {
+        s.disk_total_bytes = static_cast<uint64_t>(vfs.f_blocks) * vfs.f_frsize;
+        s.disk_used_bytes = s.disk_total_bytes - static_cast<uint64_t>(vfs.f_bfree) * vfs.f_frsize;
+    }
+
+    for (const auto& r : interfaces.sample()) {
+        if (r.loopback) continue;
+        s.net_rx_bytes_per_sec += r.rx_bytes_per_sec;
+        s.net_tx_bytes_per_sec += r.tx_bytes_per_sec;
+    }
+
+    s.cgroup_memory_bytes = -1;
+    ProcFile* mem = cg_mem_v2.read() ? &cg_mem_v2 : cg_mem_v1.read() ? &cg_mem_v1 : nullptr;
+    if (mem && mem->size()) {
+        FieldCursor cur = mem->cursor();
+        s.cgroup_memory_bytes = static_cast<int64_t>(cur.next_uint());
+    }
+
+    int64_t cg_usec = -1;
+    if (cg_cpu_v2.read()) {
+        FieldCursor cur = cg_cpu_v2.cursor();
+        if (cur.consume("usage_usec ")) cg_usec = static_cast<int64_t>(cur.next_uint());
+    } else if (cg_cpu_v1.read()) {
+        FieldCursor cur = cg_cpu_v1.cursor();
+        cg_usec = static_cast<int64_t>(cur.next_uint() / 1000);  // ns
+    }
+    s.cgroup_cpu_percent = -1.0f;
+    if (cg_usec >= 0 && prev_cg_usec >= 0 && dt > 0 && cg_usec >= prev_cg_usec) {
+        s.cgroup_cpu_percent = static_cast<float>(static_cast<double>(cg_usec - prev_cg_usec) / (dt * 1e4));
+    }
+    prev_cg_usec = cg_usec;
+
+    prev_time = now;
+    has_prev = true;
+}
+
+MetricsCollector::MetricsCollector(int interval_ms, size_t capacity, const std::string& disk_path)
+    : interval_ms_(interval_ms > 0 ? interval_ms : 1000),
+      disk_path_(disk_path),
+      slots_(new Slot[capacity ? capacity : 1]),
+      capacity_(capacity ? capacity : 1),
+      sources_(new Sources) {}
+
+MetricsCollector::~MetricsCollector() {
+    stop();
+}
+
+void MetricsCollector::start() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (thread_.joinable()) return;
+    stop_requested_ = false;
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread([this] { run(); });
+}
+
+void MetricsCollector::stop() {
+    std::thread t;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_requested_ = true;
+        t = std::move(thread_);
+    }
+    cv_.notify_all();
+    if (t.joinable()) t.join();
+    running_.store(false, std::memory_order_release);
+}
+
+bool MetricsCollector::running() const noexcept {
+    return running_.load(std::memory_order_acquire);
+}
+
+size_t MetricsCollector::capacity() const noexcept {
+    return capacity_;
+}
+
+int MetricsCollector::interval_ms() const noexcept {
+    return interval_ms_;
+}
+
+void MetricsCollector::run() {
+    auto next = std::chrono::steady_clock::now();
+    MetricsSample s;
+    // The first pass only primes the deltas (CPU, network, cgroup CPU).
+    sources_->sample(s, disk_path_);
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_requested_) {
+        next += std::chrono::milliseconds(interval_ms_);
+        if (cv_.wait_until(lock, next, [this] { return stop_requested_; })) break;
+        lock.unlock();
+        sources_->sample(s, disk_path_);
+        publish(s);
+        lock.lock();
+    }
+}
+
+void MetricsCollector::publish(const MetricsSample& s) {
+    uint64_t index = written_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index % capacity_];
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.sample, &s, sizeof(s));
+    slot.seq.store(seq + 2, std::memory_order_release);
+    written_.store(index + 1, std::memory_order_release);
+}
+
+// Copy sample number `index`; false if it was overwritten meanwhile.
+bool MetricsCollector::read_slot(uint64_t index, MetricsSample& out) const {
+    const Slot& slot = slots_[index % capacity_];
+    for (;;) {
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) continue;  // writer inside; it never blocks, so spin
+        std::memcpy(&out, &slot.sample, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) continue;
+        // Each publish into this slot bumps seq by 2, so the generation
+        // tells which lap of the ring the copy belongs to.
+        return before / 2 == index / capacity_ + 1;
+    }
+}
+
+std::optional<MetricsSample> MetricsCollector::latest() const {
+    uint64_t written = written_.load(std::memory_order_acquire);
+    for (; written > 0; written = written_.load(std::memory_order_acquire)) {
+        MetricsSample s;
+        if (read_slot(written - 1, s)) return s;
+    }
+    return std::nullopt;
+}
+
+std::vector<MetricsSample> MetricsCollector::history(size_t n) const {
+    uint64_t written = written_.load(std::memory_order_acquire);
+    uint64_t count = std::min<uint64_t>({n, written, capacity_});
+    std::vector<MetricsSample> out;
+    out.reserve(static_cast<size_t>(count));
+    for (uint64_t i = written - count; i < written; ++i) {
+        MetricsSample s;
+        if (read_slot(i, s)) out.push_back(s);  // lapped by the writer: drop
+    }
+    return out;
+}
+
+std::vector<MetricsSample> MetricsCollector::since(int64_t timestamp_ms) const {
+    auto all = history(capacity_);
+    auto it = all.begin();
+    while (it != all.end() && it->timestamp_ms <= timestamp_ms) ++it;
+    return std::vector<MetricsSample>(it, all.end());
+}
+
+MetricsColumns MetricsCollector::columns(size_t n) const {
+    auto samples = history(n);
+    MetricsColumns cols;
+    for (const auto& s : samples) cols.cores = std::max<size_t>(cols.cores, s.core_count);
+    cols.core_percent.assign(samples.size() * cols.cores, 0.0f);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const auto& s = samples[i];
+        cols.timestamp_ms.push_back(s.timestamp_ms);
+        cols.cpu_percent.push_back(s.cpu_percent);
+        std::copy(s.core_percent, s.core_percent + s.core_count, cols.core_percent.begin() + i * cols.cores);
+        cols.load_1m.push_back(s.load_1m);
+        cols.load_5m.push_back(s.load_5m);
+        cols.load_15m.push_back(s.load_15m);
+        cols.mem_total_kb.push_back(s.mem_total_kb);
+        cols.mem_available_kb.push_back(s.mem_available_kb);
+        cols.swap_used_kb.push_back(s.swap_used_kb);
+        cols.disk_used_bytes.push_back(s.disk_used_bytes);
+        cols.net_rx_bytes_per_sec.push_back(s.net_rx_bytes_per_sec);
+        cols.net_tx_bytes_per_sec.push_back(s.net_tx_bytes_per_sec);
+        cols.cgroup_memory_bytes.push_back(s.cgroup_memory_bytes);
+        cols.cgroup_cpu_percent.push_back(s.cgroup_cpu_percent);
+    }
+    return cols;
+}
+
+} // namespace agent_kernel
@@ -1,11 +1,15 @@
 #include "agent_kernel/network.h"
+#include "agent_kernel/proc_file.h"
+#include "agent_kernel/rtnl_link.h"
+#include "agent_kernel/sock_diag.h"
+#include "agent_kernel/stats.h"
 
-#include <fstream>
-#include <sstream>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
 #include <arpa/inet.h>
-#include <stdexcept>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 namespace agent_kernel {
 
@@ -28,139 +32,291 @@ const char* tcp_state_name(int state) {
     }
 }
 
-std::string hex_to_ipv4(const std::string& hex_ip) {
-    unsigned long addr = std::stoul(hex_ip, nullptr, 16);
-    char buf[INET_ADDRSTRLEN];
-    struct in_addr in;
-    in.s_addr = static_cast<in_addr_t>(addr);
-    inet_ntop(AF_INET, &in, buf, sizeof(buf));
+constexpr int kTcpEstablished = 0x01;
+constexpr int kTcpClose = 0x07;
+constexpr int kTcpListen = 0x0A;
+
+struct Protocol {
+    const char* name;
+    int family;
+    int ipproto;
+    bool udp;
+};
+
+const Protocol kProtocols[] = {
+    {"tcp", AF_INET, IPPROTO_TCP, false},
+    {"tcp6", AF_INET6, IPPROTO_TCP, false},
+    {"udp", AF_INET, IPPROTO_UDP, true},
+    {"udp6", AF_INET6, IPPROTO_UDP, true},
+};
+
+const Protocol* find_protocol(const std::string& name) {
+    for (const auto& p : kProtocols) {
+        if (name == p.name) return &p;
+    }
+    return nullptr;
+}
+
+// UDP reuses the TCP state numbers: unconnected sockets are CLOSE.
+int effective_state(int state, bool udp) {
+    if (!udp) return state;
+    return state == kTcpClose ? kTcpClose : kTcpEstablished;
+}
+
+uint32_t state_mask(const std::vector<std::string>& names) {
+    uint32_t mask = 0;
+    for (const auto& name : names) {
+        for (int st = 1; st <= 0x0B; ++st) {
+            if (name == tcp_state_name(st)) mask |= 1u << st;
+        }
+    }
+    return mask;
+}
+
+// A bound-but-unconnected UDP socket counts as listening.
+uint32_t listening_mask(bool udp) {
+    return 1u << (udp ? kTcpClose : kTcpListen);
+}
+
+std::string format_addr(int family, const void* addr) {
+    char buf[INET6_ADDRSTRLEN];
+    inet_ntop(family, addr, buf, sizeof(buf));
     return buf;
 }
 
-std::string hex_to_ipv6(const std::string& hex_ip) {
-    if (hex_ip.size() != 32) return hex_ip;
+std::string format_ipv4(FieldCursor& cur) {
+    // Printed as the raw __be32 in host order, so the value is s_addr as-is.
+    struct in_addr in;
+    in.s_addr = static_cast<in_addr_t>(cur.next_hex(8));
+    return format_addr(AF_INET, &in);
+}
+
+std::string format_ipv6(FieldCursor& cur) {
     struct in6_addr in;
     for (int i = 0; i < 4; ++i) {
-        std::string chunk = hex_ip.substr(i * 8, 8);
-        uint32_t val = static_cast<uint32_t>(std::stoul(chunk, nullptr, 16));
-        // /proc/net/tcp6 stores 32-bit words in host byte order;
-        // inet_ntop expects network byte order, so swap.
-        val = htonl(val);
+        // Each word is the raw address bytes loaded as a host-order u32,
+        // so storing it back natively restores network byte order.
+        auto val = static_cast<uint32_t>(cur.next_hex(8));
         std::memcpy(&in.s6_addr[i * 4], &val, 4);
     }
-    char buf[INET6_ADDRSTRLEN];
-    inet_ntop(AF_INET6, &in, buf, sizeof(buf));
-    return buf;
+    return format_addr(AF_INET6, &in);
 }
 
-std::vector<ConnectionInfo> parse_proc_net(const std::string& path, const std::string& protocol,
-                                           bool listening_only = false) {
-    std::vector<ConnectionInfo> conns;
-    std::ifstream f(path);
-    if (!f.is_open()) return conns;
-
-    bool is_v6 = (protocol == "tcp6" || protocol == "udp6");
-    bool is_udp = (protocol == "udp" || protocol == "udp6");
-
-    std::string line;
-    std::getline(f, line); // skip header
-
-    while (std::getline(f, line)) {
-        try {
-            std::istringstream iss(line);
-            std::string sl, local, remote, state_hex;
-            iss >> sl >> local >> remote >> state_hex;
-
-            if (sl.empty() || local.empty()) continue;
-
-            ConnectionInfo ci;
-            ci.protocol = protocol;
-
-            // Parse local address:port
-            auto colon = local.rfind(':');
-            if (colon == std::string::npos) continue;
-            std::string local_ip = local.substr(0, colon);
-            ci.local_port = static_cast<uint16_t>(std::stoul(local.substr(colon + 1), nullptr, 16));
-            ci.local_addr = is_v6 ? hex_to_ipv6(local_ip) : hex_to_ipv4(local_ip);
-
-            // Parse remote address:port
-            colon = remote.rfind(':');
-            if (colon == std::string::npos) continue;
-            std::string remote_ip = remote.substr(0, colon);
-            ci.remote_port = static_cast<uint16_t>(std::stoul(remote.substr(colon + 1), nullptr, 16));
-            ci.remote_addr = is_v6 ? hex_to_ipv6(remote_ip) : hex_to_ipv4(remote_ip);
-
-            int state_val = static_cast<int>(std::stoul(state_hex, nullptr, 16));
-            ci.state = is_udp ? (state_val == 0x07 ? "CLOSE" : "ESTABLISHED") : tcp_state_name(state_val);
-
-            // Early skip for listening_only mode
-            if (listening_only) {
-                bool is_listen = (state_val == 0x0A);  // TCP LISTEN
-                bool is_udp_bound = is_udp && (ci.remote_port == 0);
-                if (!is_listen && !is_udp_bound) continue;
-            }
-
-            // Remaining fields: tx_queue:rx_queue tr:tm->when retrnsmt uid
-            std::string skip;
-            iss >> skip >> skip >> skip; // tx_queue:rx_queue, tr:tm->when, retrnsmt
-            iss >> ci.uid;
-            // timeout inode
-            std::string timeout_s;
-            iss >> timeout_s >> ci.inode;
-
-            conns.push_back(std::move(ci));
-        } catch (...) {
-            // Skip malformed lines
+// /proc/net files held open across calls; tables can be large, so start
+// with roomy buffers. The mutex also serializes the parse that follows.
+struct NetFiles {
+    std::mutex mtx;
+    ProcFile tcp{"/proc/net/tcp", 64 * 1024};
+    ProcFile tcp6{"/proc/net/tcp6", 64 * 1024};
+    ProcFile udp{"/proc/net/udp", 16 * 1024};
+    ProcFile udp6{"/proc/net/udp6", 16 * 1024};
+    ProcFile dev{"/proc/net/dev"};
+
+    ProcFile* for_protocol(const std::string& protocol) {
+        if (protocol == "tcp") return &tcp;
+        if (protocol == "tcp6") return &tcp6;
+        if (protocol == "udp") return &udp;
+        if (protocol == "udp6") return &udp6;
+        return nullptr;
+    }
+};
+
+NetFiles& net_files() {
+    static NetFiles f;
+    return f;
+}
+
+// Callers passing a NetFiles member hold net_files().mtx.
+void parse_proc_net(ProcFile& file, const Protocol& proto, std::vector<ConnectionInfo>& conns,
+                    uint32_t states = SockDiag::kAllStates) {
+    if (!file.read()) return;
+
+    bool is_v6 = proto.family == AF_INET6;
+
+    FieldCursor all = file.cursor();
+    all.next_line(); // skip header
+
+    while (!all.at_end()) {
+        auto* nl = static_cast<const char*>(memchr(all.p, '\n', static_cast<size_t>(all.end - all.p)));
+        FieldCursor cur{all.p, nl ? nl : all.end};
+        all.p = nl ? nl + 1 : all.end;
+
+        // "  sl  local_address rem_address   st tx_queue:rx_queue tr:tm->when retrnsmt uid timeout inode"
+        cur.skip_field();
+        cur.skip_spaces();
+        FieldCursor local = cur;
+        if (!cur.skip_past(':')) continue;
+        auto local_port = static_cast<uint16_t>(cur.next_hex(4));
+        cur.skip_spaces();
+        FieldCursor remote = cur;
+        if (!cur.skip_past(':')) continue;
+        auto remote_port = static_cast<uint16_t>(cur.next_hex(4));
+        int state_val = effective_state(static_cast<int>(cur.next_hex(2)), proto.udp);
+
+        // Filter before any formatting. Malformed rows can carry any byte;
+        // those only pass an unfiltered read, as UNKNOWN.
+        if (state_val >= 32) {
+            if (states != SockDiag::kAllStates) continue;
+        } else if (!(states & (1u << state_val))) {
             continue;
         }
+
+        ConnectionInfo ci;
+        ci.protocol = proto.name;
+        ci.local_port = local_port;
+        ci.remote_port = remote_port;
+        ci.local_addr = is_v6 ? format_ipv6(local) : format_ipv4(local);
+        ci.remote_addr = is_v6 ? format_ipv6(remote) : format_ipv4(remote);
+        ci.state = tcp_state_name(state_val);
+
+        // Remaining fields: tx_queue:rx_queue tr:tm->when retrnsmt uid timeout inode
+        cur.skip_fields(3);
+        ci.uid = static_cast<int>(cur.next_uint());
+        cur.skip_field();
+        ci.inode = cur.next_uint();
+
+        conns.push_back(std::move(ci));
     }
-    return conns;
+}
+
+ConnectionInfo to_connection(const SocketRecord& rec, const Protocol& proto) {
+    ConnectionInfo ci;
+    ci.protocol = proto.name;
+    ci.local_addr = format_addr(rec.family, rec.local_addr);
+    ci.local_port = rec.local_port;
+    ci.remote_addr = format_addr(rec.family, rec.remote_addr);
+    ci.remote_port = rec.remote_port;
+    ci.state = tcp_state_name(effective_state(rec.state, proto.udp));
+    ci.uid = static_cast<int>(rec.uid);
+    ci.inode = rec.inode;
+    ci.rtt_us = rec.rtt_us;
+    ci.retransmits = rec.retransmits;
+    ci.bytes_acked = rec.bytes_acked;
+    ci.bytes_received = rec.bytes_received;
+    return ci;
+}
+
+// Netlink first; procfs if the kernel won't answer this family/protocol.
+void collect(const Protocol& proto, uint32_t states, bool tcp_info, std::vector<ConnectionInfo>& conns) {
+    thread_local std::vector<SocketRecord> records;
+    records.clear();
+    if (SockDiag::shared().query(proto.family, proto.ipproto, states, tcp_info, records)) {
+        conns.reserve(conns.size() + records.size());
+        for (const auto& rec : records) conns.push_back(to_connection(rec, proto));
+        return;
+    }
+    auto& nf = net_files();
+    std::lock_guard<std::mutex> lock(nf.mtx);
+    parse_proc_net(*nf.for_protocol(proto.name), proto, conns, states);
 }
 
 } // anonymous namespace
 
-std::vector<ConnectionInfo> NetworkMonitor::connections(const std::string& protocol) {
-    return parse_proc_net("/proc/net/" + protocol, protocol);
+std::vector<ConnectionInfo> NetworkMonitor::connections(const std::string& protocol, bool tcp_info) {
+    ProbeTimer timer(Probe::NetworkConnections);
+    std::vector<ConnectionInfo> conns;
+    if (const Protocol* proto = find_protocol(protocol)) collect(*proto, SockDiag::kAllStates, tcp_info, conns);
+    return conns;
+}
+
+std::vector<ConnectionInfo> NetworkMonitor::connections_in_state(const std::string& protocol,
+                                                                 const std::vector<std::string>& states,
+                                                                 bool tcp_info) {
+    ProbeTimer timer(Probe::NetworkConnections);
+    std::vector<ConnectionInfo> conns;
+    uint32_t mask = state_mask(states);
+    if (const Protocol* proto = find_protocol(protocol)) {
+        if (mask) collect(*proto, mask, tcp_info, conns);
+    }
+    return conns;
+}
+
+void ConnectionColumns::push_back(const ConnectionInfo& c) {
+    protocol.push_back(c.protocol);
+    local_addr.push_back(c.local_addr);
+    local_port.push_back(c.local_port);
+    remote_addr.push_back(c.remote_addr);
+    remote_port.push_back(c.remote_port);
+    state.push_back(c.state);
+    uid.push_back(c.uid);
+    inode.push_back(c.inode);
+}
+
+ConnectionColumns NetworkMonitor::connection_columns(const std::string& protocol) {
+    ProbeTimer timer(Probe::NetworkConnectionColumns);
+    std::vector<ConnectionInfo> conns;
+    for (const auto& proto : kProtocols) {
+        if (protocol == "all" || protocol == proto.name) collect(proto, SockDiag::kAllStates, false, conns);
+    }
+    ConnectionColumns cols;
+    for (const auto& c : conns) cols.push_back(c);
+    return cols;
 }
 
 std::vector<ConnectionInfo> NetworkMonitor::listening_ports() {
+    ProbeTimer timer(Probe::NetworkListeningPorts);
     std::vector<ConnectionInfo> result;
-    for (const auto& proto : {"tcp", "tcp6", "udp", "udp6"}) {
-        auto conns = parse_proc_net("/proc/net/" + std::string(proto), proto, true);
-        for (auto& c : conns) {
-            result.push_back(std::move(c));
-        }
-    }
+    for (const auto& proto : kProtocols) collect(proto, listening_mask(proto.udp), false, result);
     return result;
 }
 
+std::string NetworkMonitor::backend() {
+    std::vector<SocketRecord> probe;
+    return SockDiag::shared().query(AF_INET, IPPROTO_TCP, listening_mask(false), false, probe) ? "netlink" : "procfs";
+}
+
+std::vector<ConnectionInfo> NetworkMonitor::parse_table(const std::string& path, const std::string& protocol) {
+    ProbeTimer timer(Probe::NetworkParseTable);
+    std::vector<ConnectionInfo> conns;
+    if (const Protocol* proto = find_protocol(protocol)) {
+        ProcFile file(path, 64 * 1024);
+        parse_proc_net(file, *proto, conns);
+    }
+    return conns;
+}
+
 std::vector<InterfaceStats> NetworkMonitor::interfaces() {
+    ProbeTimer timer(Probe::NetworkInterfaces);
     std::vector<InterfaceStats> ifaces;
-    std::ifstream f("/proc/net/dev");
-    if (!f.is_open()) return ifaces;
+    thread_local std::vector<LinkRecord> links;
+    if (RtnlLinkReader::shared().read(links)) {
+        ifaces.reserve(links.size());
+        for (auto& link : links) ifaces.push_back(std::move(link.stats));
+        return ifaces;
+    }
 
-    std::string line;
-    std::getline(f, line); // header 1
-    std::getline(f, line); // header 2
+    // No NETLINK_ROUTE: parse /proc/net/dev
+    auto& nf = net_files();
+    std::lock_guard<std::mutex> lock(nf.mtx);
+    if (!nf.dev.read()) return ifaces;
 
-    while (std::getline(f, line)) {
+    FieldCursor cur = nf.dev.cursor();
+    cur.next_line(); // header 1
+    cur.next_line(); // header 2
+
+    while (!cur.at_end()) {
         // Format: "  iface: rx_bytes rx_packets rx_errs rx_drop ... tx_bytes tx_packets ..."
-        auto colon = line.find(':');
-        if (colon == std::string::npos) continue;
+        cur.skip_spaces();
+        const char* name = cur.p;
+        if (!cur.skip_past(':')) {
+            cur.next_line();
+            continue;
+        }
 
         InterfaceStats st;
-        // Trim whitespace from name
-        std::string name = line.substr(0, colon);
-        size_t start = name.find_first_not_of(' ');
-        st.name = (start != std::string::npos) ? name.substr(start) : name;
-
-        std::istringstream iss(line.substr(colon + 1));
-        uint64_t skip;
+        st.name.assign(name, static_cast<size_t>(cur.p - 1 - name));
         // RX: bytes packets errs drop fifo frame compressed multicast
-        iss >> st.rx_bytes >> st.rx_packets >> st.rx_errors >> st.rx_dropped
-            >> skip >> skip >> skip >> skip;
+        st.rx_bytes = cur.next_uint();
+        st.rx_packets = cur.next_uint();
+        st.rx_errors = cur.next_uint();
+        st.rx_dropped = cur.next_uint();
+        cur.skip_fields(4);
         // TX: bytes packets errs drop fifo colls carrier compressed
-        iss >> st.tx_bytes >> st.tx_packets >> st.tx_errors >> st.tx_dropped;
+        st.tx_bytes = cur.next_uint();
+        st.tx_packets = cur.next_uint();
+        st.tx_errors = cur.next_uint();
+        st.tx_dropped = cur.next_uint();
+        cur.next_line();
 
         ifaces.push_back(std::move(st));
     }
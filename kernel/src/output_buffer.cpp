@@ -0,0 +1,72 @@
+#include "agent_kernel/output_buffer.h"
+
+#include <algorithm>
+
+namespace agent_kernel {
+
+OutputBuffer::OutputBuffer(size_t head_bytes, size_t tail_bytes)
+    : head_limit_(head_bytes), tail_limit_(tail_bytes),
+      bounded_(head_bytes != 0 || tail_bytes != 0) {}
+
+void OutputBuffer::append(const char* data, size_t size) {
+    total_ += size;
+    if (!bounded_) {
+        head_.append(data, size);
+        return;
+    }
+
+    if (head_.size() < head_limit_) {
+        size_t n = std::min(size, head_limit_ - head_.size());
+        head_.append(data, n);
+        data += n;
+        size -= n;
+    }
+    if (size == 0 || tail_limit_ == 0) return;
+
+    if (size >= tail_limit_) {
+        // Only the last tail_limit_ bytes of this chunk can survive.
+        tail_.assign(data + size - tail_limit_, tail_limit_);
+        tail_start_ = 0;
+        return;
+    }
+    if (tail_.size() < tail_limit_) {
+        size_t n = std::min(size, tail_limit_ - tail_.size());
+        tail_.append(data, n);
+        data += n;
+        size -= n;
+    }
+    // Ring is full: overwrite the oldest bytes.
+    while (size > 0) {
+        size_t n = std::min(size, tail_limit_ - tail_start_);
+        tail_.replace(tail_start_, n, data, n);
+        tail_start_ = (tail_start_ + n) % tail_limit_;
+        data += n;
+        size -= n;
+    }
+}
+
+uint64_t OutputBuffer::total() const noexcept {
+    return total_;
+}
+
+bool OutputBuffer::truncated() const noexcept {
+    return total_ > head_.size() + tail_.size();
+}
+
+std::string OutputBuffer::take() {
+    uint64_t omitted = total_ - head_.size() - tail_.size();
+    std::string out = std::move(head_);
+    if (omitted > 0) {
+        out += "\n[... " + std::to_string(omitted) + " bytes omitted ...]\n";
+    }
+    out.append(tail_, tail_start_, std::string::npos);
+    out.append(tail_, 0, tail_start_);
+
+    head_.clear();
+    tail_.clear();
+    tail_start_ = 0;
+    total_ = 0;
+    return out;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,51 @@
+#include "agent_kernel/proc_file.h"
+#include "agent_kernel/stats.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace agent_kernel {
+
+ProcFile::ProcFile(std::string path, size_t initial_capacity)
+    : ProcFile(AT_FDCWD, std::move(path), initial_capacity) {}
+
+ProcFile::ProcFile(int dir_fd, std::string name, size_t initial_capacity)
+    : path_(std::move(name)), dir_fd_(dir_fd), buf_(initial_capacity ? initial_capacity : 4096) {}
+
+ProcFile::~ProcFile() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool ProcFile::read() {
+    size_ = 0;
+    if (fd_ < 0) {
+        if (path_.empty() || (dir_fd_ < 0 && dir_fd_ != AT_FDCWD)) return false;
+        fd_ = ::openat(dir_fd_, path_.c_str(), O_RDONLY | O_CLOEXEC);
+        Stats::count(Syscall::Open);
+        if (fd_ < 0) return false;
+    }
+
+    // seq_file may hand back less than asked for, so keep going until EOF,
+    // doubling the buffer whenever it fills.
+    for (;;) {
+        if (size_ == buf_.size()) buf_.resize(buf_.size() * 2);
+        ssize_t n = pread(fd_, buf_.data() + size_, buf_.size() - size_, static_cast<off_t>(size_));
+        Stats::count(Syscall::Read);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd_);
+            fd_ = -1;
+            size_ = 0;
+            return false;
+        }
+        if (n == 0) {
+            Stats::count_procfs_bytes(size_);
+            return true;
+        }
+        size_ += static_cast<size_t>(n);
+    }
+}
+
+} // namespace agent_kernel
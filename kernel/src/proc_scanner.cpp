@@ -0,0 +1,316 @@
+#include "agent_kernel/proc_scanner.h"
+#include "agent_kernel/proc_file.h"
+#include "agent_kernel/stats.h"
+#include "agent_kernel/thread_pool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <cstring>
+#include <stdexcept>
+
+namespace agent_kernel {
+
+namespace {
+
+// Layout returned by the getdents64 syscall (not exported by all libcs).
+struct linux_dirent64 {
+    ino64_t        d_ino;
+    off64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+// Per-thread scratch space. /proc/<pid>/stat is well under 1 KB; cmdline is
+// streamed through its buffer in chunks, so neither needs to grow.
+constexpr size_t kStatBufSize = 4096;
+constexpr size_t kCmdlineBufSize = 4096;
+constexpr size_t kDentsBufSize = 32768;
+
+// Parallel scans: below this many PIDs per shard the handoff costs more than
+// it saves; beyond kMaxShards the scan is bound by procfs, not by parsing.
+constexpr size_t kMinPidsPerShard = 256;
+constexpr size_t kMaxShards = 8;
+
+thread_local char t_stat_buf[kStatBufSize];
+thread_local char t_cmdline_buf[kCmdlineBufSize];
+
+const uint64_t kPageKb = static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+
+// Parse a decimal PID directory name; returns -1 for anything else.
+pid_t parse_pid_name(const char* name) {
+    if (*name == '\0') return -1;
+    pid_t pid = 0;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') return -1;
+        pid = pid * 10 + (*p - '0');
+    }
+    return pid;
+}
+
+// Write "<pid>/<leaf>" into buf without touching the heap.
+void format_pid_path(char* buf, pid_t pid, const char* leaf) {
+    char digits[16];
+    int n = 0;
+    auto v = static_cast<unsigned>(pid);
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+    char* out = buf;
+    while (n) *out++ = digits[--n];
+    if (leaf) {
+        *out++ = '/';
+        while (*leaf) *out++ = *leaf++;
+    }
+    *out = '\0';
+}
+
+// read() until EOF or the buffer is full. Returns bytes read, -1 on error.
+ssize_t read_fully(int fd, char* buf, size_t cap) {
+    size_t len = 0;
+    while (len < cap) {
+        ssize_t n = ::read(fd, buf + len, cap - len);
+        Stats::count(Syscall::Read);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        len += static_cast<size_t>(n);
+    }
+    Stats::count_procfs_bytes(len);
+    return static_cast<ssize_t>(len);
+}
+
+} // anonymous namespace
+
+ProcScanner::ProcScanner(const std::string& proc_root) {
+    root_fd_ = ::open(proc_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd_ < 0) {
+        throw std::runtime_error("Cannot open " + proc_root + ": " + strerror(errno));
+    }
+}
+
+ProcScanner::~ProcScanner() {
+    if (root_fd_ >= 0) close(root_fd_);
+}
+
+const ProcScanner& ProcScanner::system() {
+    static const ProcScanner scanner("/proc");
+    return scanner;
+}
+
+std::vector<pid_t> ProcScanner::pids() const {
+    std::vector<pid_t> result;
+
+    // A fresh directory fd per listing keeps the getdents offset private to
+    // this call, so concurrent scans never share a cursor.
+    int dfd = openat(root_fd_, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    Stats::count(Syscall::Open);
+    if (dfd < 0) return result;
+
+    alignas(linux_dirent64) char buf[kDentsBufSize];
+    for (;;) {
+        long n = syscall(SYS_getdents64, dfd, buf, sizeof(buf));
+        Stats::count(Syscall::Getdents);
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            auto* d = reinterpret_cast<linux_dirent64*>(buf + off);
+            off += d->d_reclen;
+            if (d->d_type != DT_DIR && d->d_type != DT_UNKNOWN) continue;
+            pid_t pid = parse_pid_name(d->d_name);
+            if (pid > 0) result.push_back(pid);
+        }
+    }
+    close(dfd);
+    return result;
+}
+
+bool ProcScanner::read(pid_t pid, ProcessInfo& out, ProcTimes* times) const {
+    char path[48];
+
+    // <pid>/stat — "pid (comm) state ppid ..."; comm may contain spaces or
+    // parens, so it is delimited by the first '(' and the last ')'.
+    format_pid_path(path, pid, "stat");
+    int fd = openat(root_fd_, path, O_RDONLY | O_CLOEXEC);
+    Stats::count(Syscall::Open);
+    if (fd < 0) return false;
+    ssize_t len = read_fully(fd, t_stat_buf, kStatBufSize);
+    close(fd);
+    if (len <= 0) return false;
+
+    const char* begin = t_stat_buf;
+    const char* end = t_stat_buf + len;
+    auto* open = static_cast<const char*>(memchr(begin, '(', static_cast<size_t>(len)));
+    auto* close_paren = static_cast<const char*>(memrchr(begin, ')', static_cast<size_t>(len)));
+    if (!open || !close_paren || close_paren < open) return false;
+
+    out.pid = pid;
+    out.name.assign(open + 1, static_cast<size_t>(close_paren - open - 1));
+
+    FieldCursor cur{close_paren + 1, end};
+    out.state = cur.next_char();                          // field 3
+    out.ppid = static_cast<pid_t>(cur.next_int());        // field 4
+    cur.skip_fields(13 - 4);                              // fields 5-13
+    uint64_t utime = cur.next_uint();                     // field 14
+    uint64_t stime = cur.next_uint();                     // field 15
+    cur.skip_fields(21 - 15);                             // fields 16-21
+    out.start_time = cur.next_uint();                     // field 22
+    out.vsize_kb = cur.next_uint() / 1024;                // field 23 (bytes)
+    out.rss_kb = cur.next_uint() * kPageKb;               // field 24 (pages)
+    out.cpu_percent = 0.0;
+    if (times) {
+        times->utime = utime;
+        times->stime = stime;
+    }
+
+    // <pid>/cmdline — NUL-separated argv, streamed straight into the result.
+    out.cmdline.clear();
+    format_pid_path(path, pid, "cmdline");
+    fd = openat(root_fd_, path, O_RDONLY | O_CLOEXEC);
+    Stats::count(Syscall::Open);
+    if (fd >= 0) {
+        ssize_t n;
+        while ((n = ::read(fd, t_cmdline_buf, kCmdlineBufSize)) > 0) {
+            Stats::count(Syscall::Read);
+            Stats::count_procfs_bytes(static_cast<uint64_t>(n));
+            for (ssize_t i = 0; i < n; ++i) {
+                if (t_cmdline_buf[i] == '\0') t_cmdline_buf[i] = ' ';
+            }
+            out.cmdline.append(t_cmdline_buf, static_cast<size_t>(n));
+        }
+        close(fd);
+    }
+    if (!out.cmdline.empty() && out.cmdline.back() == ' ') out.cmdline.pop_back();
+    if (out.cmdline.empty()) {
+        out.cmdline.reserve(out.name.size() + 2);
+        out.cmdline.push_back('[');
+        out.cmdline.append(out.name);
+        out.cmdline.push_back(']');
+    }
+
+    // Owner of the /proc/<pid> directory is the process's real UID.
+    format_pid_path(path, pid, nullptr);
+    struct stat st;
+    out.uid = (fstatat(root_fd_, path, &st, 0) == 0) ? st.st_uid : 0;
+    Stats::count(Syscall::Stat);
+
+    return true;
+}
+
+bool ProcScanner::children_of(pid_t pid, std::vector<pid_t>& out) const {
+    char path[48];
+    format_pid_path(path, pid, "task");
+    int task_fd = openat(root_fd_, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    Stats::count(Syscall::Open);
+    if (task_fd < 0) return true;
+
+    // Each thread keeps its own child list; a process's children are the union.
+    alignas(linux_dirent64) char dents[kDentsBufSize];
+    bool supported = true;
+    for (;;) {
+        long n = syscall(SYS_getdents64, task_fd, dents, sizeof(dents));
+        Stats::count(Syscall::Getdents);
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            auto* d = reinterpret_cast<linux_dirent64*>(dents + off);
+            off += d->d_reclen;
+            pid_t tid = parse_pid_name(d->d_name);
+            if (tid <= 0) continue;
+
+            format_pid_path(path, tid, "children");
+            int fd = openat(task_fd, path, O_RDONLY | O_CLOEXEC);
+            Stats::count(Syscall::Open);
+            if (fd < 0) {
+                // The leader always exists while task/ does, so a missing
+                // file there means the kernel doesn't provide it.
+                if (tid == pid && errno == ENOENT) supported = false;
+                continue;
+            }
+
+            // "pid pid pid " — numbers may straddle read() boundaries.
+            pid_t cur = 0;
+            bool in_num = false;
+            ssize_t len;
+            while ((len = ::read(fd, t_stat_buf, kStatBufSize)) > 0) {
+                Stats::count(Syscall::Read);
+                Stats::count_procfs_bytes(static_cast<uint64_t>(len));
+                for (ssize_t i = 0; i < len; ++i) {
+                    char c = t_stat_buf[i];
+                    if (c >= '0' && c <= '9') {
+                        cur = cur * 10 + (c - '0');
+                        in_num = true;
+                    } else if (in_num) {
+                        out.push_back(cur);
+                        cur = 0;
+                        in_num = false;
+                    }
+                }
+            }
+            if (in_num) out.push_back(cur);
+            close(fd);
+        }
+        if (!supported) break;
+    }
+    close(task_fd);
+    return supported;
+}
+
+std::vector<ProcessInfo> ProcScanner::scan() const {
+    auto pid_list = pids();
+    std::vector<ProcessInfo> procs;
+    procs.reserve(pid_list.size());
+
+    for (pid_t pid : pid_list) {
+        procs.emplace_back();
+        if (!read(pid, procs.back())) {
+            // Process exited between getdents and reading its files
+            procs.pop_back();
+        }
+    }
+    return procs;
+}
+
+std::vector<ProcessInfo> ProcScanner::scan(ThreadPool& pool) const {
+    auto pid_list = pids();
+    size_t shards = std::max<size_t>(1, std::min<size_t>({kMaxShards, pool.size() + 1u,
+                                                             pid_list.size() / kMinPidsPerShard}));
+    size_t per_shard = (pid_list.size() + shards - 1) / shards;
+
+    std::vector<std::vector<ProcessInfo>> parts(shards);
+    auto parse_shard = [&](size_t s) {
+        size_t lo = std::min(pid_list.size(), s * per_shard);
+        size_t hi = std::min(pid_list.size(), lo + per_shard);
+        auto& out = parts[s];
+        out.reserve(hi - lo);
+        for (size_t i = lo; i < hi; ++i) {
+            out.emplace_back();
+            if (!read(pid_list[i], out.back())) out.pop_back();
+        }
+    };
+
+    if (shards == 1) {
+        parse_shard(0);
+        return std::move(parts[0]);
+    }
+    pool.parallel_for(shards, parse_shard);
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    std::vector<ProcessInfo> procs;
+    procs.reserve(total);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(procs));
+    }
+    return procs;
+}
+
+} // namespace agent_kernel
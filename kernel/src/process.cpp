@@ -1,17 +1,15 @@
 #include "agent_kernel/process.h"
+#include "agent_kernel/proc_scanner.h"
+#include "agent_kernel/spawn.h"
+#include "agent_kernel/thread_pool.h"
+#include "agent_kernel/stats.h"
 
-#include <dirent.h>
 #include <signal.h>
 #include <unistd.h>
-#include <sys/resource.h>
-#include <sys/stat.h>
 #include <sys/wait.h>
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
 #include <stdexcept>
-#include <functional>
-#include <unordered_map>
 #include <cstring>
 #include <cerrno>
 
@@ -19,105 +17,125 @@ namespace agent_kernel {
 
 namespace {
 
-bool is_pid_dir(const char* name) {
-    for (const char* p = name; *p; ++p) {
-        if (*p < '0' || *p > '9') return false;
+// Flatten `procs` into depth-first order with depths. Children are found
+// through a CSR index (parents and children each sorted once, then merge
+// joined into per-node ranges) and walked with an explicit stack, so deep
+// fork chains cannot overflow the call stack. Roots are processes whose
+// parent is absent, or only `root_pid` when it is non-zero. Entries are
+// moved out of `procs`.
+std::vector<ProcessTreeNode> flatten_tree(std::vector<ProcessInfo>& procs, pid_t root_pid) {
+    const auto n = static_cast<uint32_t>(procs.size());
+
+    std::vector<uint32_t> by_pid(n), by_ppid(n);
+    for (uint32_t i = 0; i < n; ++i) by_pid[i] = by_ppid[i] = i;
+    std::sort(by_pid.begin(), by_pid.end(),
+              [&](uint32_t a, uint32_t b) { return procs[a].pid < procs[b].pid; });
+    // Stable, so siblings keep their order from the scan
+    std::stable_sort(by_ppid.begin(), by_ppid.end(),
+                     [&](uint32_t a, uint32_t b) { return procs[a].ppid < procs[b].ppid; });
+
+    // Node i's children are by_ppid[child_begin[i] .. child_end[i])
+    std::vector<uint32_t> child_begin(n, 0), child_end(n, 0);
+    for (uint32_t a = 0, c = 0; a < n && c < n; ) {
+        pid_t pid = procs[by_pid[a]].pid;
+        pid_t ppid = procs[by_ppid[c]].ppid;
+        if (ppid < pid) {
+            ++c;
+        } else if (pid < ppid) {
+            ++a;
+        } else {
+            uint32_t lo = c;
+            while (c < n && procs[by_ppid[c]].ppid == pid) ++c;
+            child_begin[by_pid[a]] = lo;
+            child_end[by_pid[a]] = c;
+            ++a;
+        }
     }
-    return *name != '\0';
-}
-
-std::string read_file(const std::string& path) {
-    std::ifstream f(path);
-    if (!f.is_open()) return {};
-    std::ostringstream ss;
-    ss << f.rdbuf();
-    return ss.str();
-}
-
-ProcessInfo parse_proc(pid_t pid) {
-    ProcessInfo info{};
-    info.pid = pid;
 
-    // /proc/pid/stat — space-delimited, field 2 is (name) in parens
-    std::string stat_content = read_file("/proc/" + std::to_string(pid) + "/stat");
-    if (stat_content.empty()) {
-        info.name = "?";
-        return info;
-    }
+    auto present = [&](pid_t pid) {
+        auto it = std::lower_bound(by_pid.begin(), by_pid.end(), pid,
+                                   [&](uint32_t i, pid_t v) { return procs[i].pid < v; });
+        return it != by_pid.end() && procs[*it].pid == pid;
+    };
 
-    // Find the command name between first '(' and last ')'
-    auto open = stat_content.find('(');
-    auto close = stat_content.rfind(')');
-    if (open != std::string::npos && close != std::string::npos && close > open) {
-        info.name = stat_content.substr(open + 1, close - open - 1);
+    std::vector<ProcessTreeNode> result;
+    result.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<std::pair<uint32_t, int>> stack;
+
+    for (uint32_t r = 0; r < n; ++r) {
+        const auto& p = procs[r];
+        bool is_root = root_pid != 0 ? p.pid == root_pid
+                                     : (p.ppid == 0 || !present(p.ppid));
+        if (!is_root || visited[r]) continue;
+
+        stack.push_back({r, 0});
+        while (!stack.empty()) {
+            auto [i, depth] = stack.back();
+            stack.pop_back();
+            if (visited[i]) continue;
+            visited[i] = 1;
+            for (uint32_t c = child_end[i]; c > child_begin[i]; --c) {
+                stack.push_back({by_ppid[c - 1], depth + 1});
+            }
+            result.push_back({std::move(procs[i]), depth});
+        }
     }
+    return result;
+}
 
-    // Fields after the closing paren
-    std::istringstream rest(stat_content.substr(close + 2));
-    std::string field;
-
-    // field 3: state
-    rest >> field; info.state = field.empty() ? '?' : field[0];
-    // field 4: ppid
-    rest >> info.ppid;
-
-    // Skip fields 5-22 to reach field 23 (vsize) and 24 (rss in pages)
-    for (int i = 5; i <= 22; ++i) rest >> field;
-    uint64_t vsize_bytes = 0, rss_pages = 0;
-    rest >> vsize_bytes >> rss_pages;
-    info.vsize_kb = vsize_bytes / 1024;
-    info.rss_kb = (rss_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE))) / 1024;
-    info.cpu_percent = 0.0; // Accurate per-process CPU requires two samples; leave as 0
-
-    // /proc/pid/cmdline — null-separated
-    std::string cmdline = read_file("/proc/" + std::to_string(pid) + "/cmdline");
-    for (auto& c : cmdline) {
-        if (c == '\0') c = ' ';
-    }
-    if (!cmdline.empty() && cmdline.back() == ' ') cmdline.pop_back();
-    info.cmdline = cmdline.empty() ? ("[" + info.name + "]") : cmdline;
-
-    // Get UID via stat() on /proc/pid — avoids opening a third file
-    struct stat proc_stat;
-    std::string proc_path = "/proc/" + std::to_string(pid);
-    if (::stat(proc_path.c_str(), &proc_stat) == 0) {
-        info.uid = proc_stat.st_uid;
-    }
+} // anonymous namespace
 
-    return info;
+void ProcessColumns::reserve(size_t n) {
+    pid.reserve(n);
+    ppid.reserve(n);
+    uid.reserve(n);
+    state.reserve(n);
+    rss_kb.reserve(n);
+    vsize_kb.reserve(n);
+    start_time.reserve(n);
+    cpu_percent.reserve(n);
+    name.codes.reserve(n);
+    cmdline.reserve(n, 64);
 }
 
-bool apply_rlimit(int resource, int64_t value) {
-    if (value < 0) return true;  // unlimited
-    struct rlimit rl;
-    rl.rlim_cur = static_cast<rlim_t>(value);
-    rl.rlim_max = static_cast<rlim_t>(value);
-    return setrlimit(resource, &rl) == 0;
+void ProcessColumns::push_back(const ProcessInfo& p) {
+    pid.push_back(p.pid);
+    ppid.push_back(p.ppid);
+    uid.push_back(p.uid);
+    state.push_back(static_cast<uint8_t>(p.state));
+    rss_kb.push_back(p.rss_kb);
+    vsize_kb.push_back(p.vsize_kb);
+    start_time.push_back(p.start_time);
+    cpu_percent.push_back(p.cpu_percent);
+    name.push_back(p.name);
+    cmdline.push_back(p.cmdline);
 }
 
-} // anonymous namespace
+std::vector<ProcessInfo> ProcessManager::list_all(bool parallel) {
+    ProbeTimer timer(Probe::ProcessListAll);
+    if (parallel) return ProcScanner::system().scan(ThreadPool::shared());
+    return ProcScanner::system().scan();
+}
 
-std::vector<ProcessInfo> ProcessManager::list_all() {
-    std::vector<ProcessInfo> procs;
-    DIR* dir = opendir("/proc");
-    if (!dir) return procs;
-
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (!is_pid_dir(entry->d_name)) continue;
-        pid_t pid = static_cast<pid_t>(std::stoi(entry->d_name));
-        try {
-            procs.push_back(parse_proc(pid));
-        } catch (...) {
-            // Process may have exited between readdir and reading /proc
-        }
-    }
-    closedir(dir);
-    return procs;
+ProcessColumns ProcessManager::list_columns(bool parallel) {
+    ProbeTimer timer(Probe::ProcessListColumns);
+    auto procs = list_all(parallel);
+    ProcessColumns cols;
+    cols.reserve(procs.size());
+    for (const auto& p : procs) cols.push_back(p);
+    return cols;
 }
 
 ProcessInfo ProcessManager::get_info(pid_t pid) {
-    return parse_proc(pid);
+    ProbeTimer timer(Probe::ProcessGetInfo);
+    ProcessInfo info{};
+    if (!ProcScanner::system().read(pid, info)) {
+        info = ProcessInfo{};
+        info.pid = pid;
+        info.name = "?";
+    }
+    return info;
 }
 
 bool ProcessManager::send_signal(pid_t pid, int sig) {
@@ -125,9 +143,22 @@ bool ProcessManager::send_signal(pid_t pid, int sig) {
 }
 
 std::vector<ProcessInfo> ProcessManager::children(pid_t parent_pid) {
-    auto all = list_all();
+    ProbeTimer timer(Probe::ProcessChildren);
+    const auto& scanner = ProcScanner::system();
+    std::vector<pid_t> kids;
     std::vector<ProcessInfo> result;
-    for (auto& p : all) {
+
+    if (scanner.children_of(parent_pid, kids)) {
+        result.reserve(kids.size());
+        for (pid_t pid : kids) {
+            result.emplace_back();
+            if (!scanner.read(pid, result.back())) result.pop_back();
+        }
+        return result;
+    }
+
+    // No children files: fall back to filtering a full scan
+    for (auto& p : scanner.scan()) {
         if (p.ppid == parent_pid) {
             result.push_back(std::move(p));
         }
@@ -135,63 +166,45 @@ std::vector<ProcessInfo> ProcessManager::children(pid_t parent_pid) {
     return result;
 }
 
-std::vector<ProcessTreeNode> ProcessManager::tree() {
-    auto all = list_all();
-
-    // Build parent->children map
-    std::unordered_map<pid_t, std::vector<size_t>> child_map;
-    std::unordered_map<pid_t, size_t> idx_map;
-    for (size_t i = 0; i < all.size(); ++i) {
-        idx_map[all[i].pid] = i;
-        child_map[all[i].ppid].push_back(i);
-    }
+std::vector<ProcessTreeNode> ProcessManager::tree(bool parallel) {
+    ProbeTimer timer(Probe::ProcessTree);
+    auto all = list_all(parallel);
+    return flatten_tree(all, 0);
+}
 
-    // DFS from root processes (ppid=0 or ppid not in list)
-    std::vector<ProcessTreeNode> result;
-    result.reserve(all.size());
-
-    std::function<void(pid_t, int)> dfs = [&](pid_t pid, int depth) {
-        auto it = idx_map.find(pid);
-        if (it == idx_map.end()) return;
-        result.push_back({std::move(all[it->second]), depth});
-        auto cit = child_map.find(pid);
-        if (cit != child_map.end()) {
-            for (size_t ci : cit->second) {
-                dfs(all[ci].pid, depth + 1);
-            }
-        }
-    };
+std::vector<ProcessTreeNode> ProcessManager::tree(pid_t root_pid) {
+    ProbeTimer timer(Probe::ProcessSubtree);
+    const auto& scanner = ProcScanner::system();
 
-    // Find root processes
-    for (auto& p : all) {
-        if (p.ppid == 0 || idx_map.find(p.ppid) == idx_map.end()) {
-            dfs(p.pid, 0);
+    // Walk down from the root via children files so only the subtree is read
+    std::vector<ProcessInfo> procs;
+    std::vector<pid_t> frontier{root_pid};
+    std::vector<pid_t> kids;
+    bool supported = true;
+    while (supported && !frontier.empty()) {
+        pid_t pid = frontier.back();
+        frontier.pop_back();
+        procs.emplace_back();
+        if (!scanner.read(pid, procs.back())) {
+            procs.pop_back();
+            continue;
         }
+        kids.clear();
+        supported = scanner.children_of(pid, kids);
+        frontier.insert(frontier.end(), kids.rbegin(), kids.rend());
     }
 
-    return result;
+    if (!supported) procs = scanner.scan();
+    return flatten_tree(procs, root_pid);
 }
 
 pid_t ProcessManager::spawn(const std::string& command, const ResourceLimits& limits) {
-    pid_t pid = fork();
-    if (pid < 0) {
-        throw std::runtime_error(std::string("fork failed: ") + strerror(errno));
-    }
-
-    if (pid == 0) {
-        // Child process: apply resource limits
-        apply_rlimit(RLIMIT_CPU, limits.max_cpu_seconds);
-        apply_rlimit(RLIMIT_AS, limits.max_memory_bytes);
-        apply_rlimit(RLIMIT_FSIZE, limits.max_file_size);
-        apply_rlimit(RLIMIT_NOFILE, limits.max_open_files);
-        apply_rlimit(RLIMIT_NPROC, limits.max_processes);
-
-        // Execute via shell
-        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
-        _exit(127); // exec failed
-    }
-
-    return pid;
+    ProbeTimer timer(Probe::ProcessSpawn);
+    SpawnOptions options;
+    options.path = "/bin/sh";
+    options.argv = {"sh", "-c", command};
+    options.limits = limits;
+    return spawn_process(options);
 }
 
 } // namespace agent_kernel
@@ -0,0 +1,320 @@
+#include "agent_kernel/process_events.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace agent_kernel {
+
+namespace {
+
+// glibc < 2.36 has neither pidfd_open() nor P_PIDFD.
+constexpr idtype_t kIdTypePidfd = static_cast<idtype_t>(3);
+
+int pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Kernel wait-status word -> exit code, or -signal for signal deaths.
+int decode_wait_status(uint32_t status) {
+    if ((status & 0x7f) == 0) return static_cast<int>((status >> 8) & 0xff);
+    return -static_cast<int>(status & 0x7f);
+}
+
+// Streams that want spawn_process children, for track_spawned().
+std::mutex g_streams_mtx;
+std::vector<ProcessEventStream*> g_streams;
+
+void add_to_epoll(int epfd, int fd) {
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+}
+
+// The kernel answers PROC_CN_MCAST_LISTEN with a PROC_EVENT_NONE ack, except
+// from a non-initial PID or user namespace, where it silently drops the
+// request and no event would ever arrive. Any event also proves delivery.
+bool await_listen_ack(int s) {
+    constexpr int kAckTimeoutMs = 200;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kAckTimeoutMs);
+    alignas(struct nlmsghdr) char buf[4096];
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) return false;
+        struct pollfd pfd{s, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(left)) <= 0) continue;
+        ssize_t len = recv(s, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return errno == ENOBUFS;  // overflowed with events: delivering
+        }
+        auto* nh = reinterpret_cast<struct nlmsghdr*>(buf);
+        for (; NLMSG_OK(nh, static_cast<unsigned>(len)); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == NLMSG_NOOP || nh->nlmsg_type == NLMSG_ERROR) continue;
+            auto* cn = static_cast<struct cn_msg*>(NLMSG_DATA(nh));
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            auto* ev = reinterpret_cast<struct proc_event*>(cn->data);
+            if (ev->what != proc_event::PROC_EVENT_NONE) return true;
+            return ev->event_data.ack.err == 0;
+        }
+    }
+}
+
+} // anonymous namespace
+
+ProcessEventStream::ProcessEventStream(ProcessTable& table, int rescan_interval_ms)
+    : table_(table) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+
+    // The timer drives full rescans in polling mode; in netlink mode it only
+    // revalidates zombies, since reaping produces no connector event.
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        close(epoll_fd_);
+        throw std::runtime_error(std::string("timerfd_create failed: ") + strerror(errno));
+    }
+    if (rescan_interval_ms <= 0) rescan_interval_ms = 1000;
+    struct itimerspec its{};
+    its.it_interval.tv_sec = rescan_interval_ms / 1000;
+    its.it_interval.tv_nsec = static_cast<long>(rescan_interval_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(timer_fd_, 0, &its, nullptr);
+    add_to_epoll(epoll_fd_, timer_fd_);
+
+    mode_ = open_netlink() ? Mode::Netlink : Mode::Polling;
+
+    // Seed after subscribing so nothing between the scan and the first
+    // event is lost.
+    table_.diff();
+
+    if (mode_ == Mode::Polling) {
+        std::lock_guard<std::mutex> lock(g_streams_mtx);
+        g_streams.push_back(this);
+    }
+}
+
+ProcessEventStream::~ProcessEventStream() {
+    {
+        std::lock_guard<std::mutex> lock(g_streams_mtx);
+        g_streams.erase(std::remove(g_streams.begin(), g_streams.end(), this), g_streams.end());
+    }
+    for (auto& [pfd, _] : pidfds_) close(pfd);
+    if (netlink_fd_ >= 0) close(netlink_fd_);
+    if (timer_fd_ >= 0) close(timer_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+bool ProcessEventStream::open_netlink() {
+    int s = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (s < 0) return false;
+
+    struct sockaddr_nl sa{};
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = CN_IDX_PROC;
+    sa.nl_pid = 0;  // let the kernel pick a port id
+    if (bind(s, reinterpret_cast<struct sockaddr*>(&sa), sizeof(sa)) != 0) {
+        close(s);
+        return false;
+    }
+
+    // Subscribe: nlmsghdr + cn_msg + PROC_CN_MCAST_LISTEN
+    alignas(struct nlmsghdr) char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))]{};
+    auto* nh = reinterpret_cast<struct nlmsghdr*>(buf);
+    nh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    nh->nlmsg_type = NLMSG_DONE;
+    auto* cn = static_cast<struct cn_msg*>(NLMSG_DATA(nh));
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(enum proc_cn_mcast_op);
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(cn->data, &op, sizeof(op));
+
+    if (send(s, nh, nh->nlmsg_len, 0) < 0 || !await_listen_ack(s)) {
+        close(s);
+        return false;
+    }
+
+    try {
+        add_to_epoll(epoll_fd_, s);
+    } catch (...) {
+        close(s);
+        return false;
+    }
+    netlink_fd_ = s;
+    return true;
+}
+
+ProcessEventStream::Mode ProcessEventStream::mode() const noexcept {
+    return mode_;
+}
+
+int ProcessEventStream::fd() const noexcept {
+    return epoll_fd_;
+}
+
+bool ProcessEventStream::track(pid_t pid) {
+    if (mode_ == Mode::Netlink) return true;
+    int pfd = pidfd_open(pid);
+    if (pfd < 0) return false;
+    // In the map before epoll can report it to a concurrent poll()
+    std::lock_guard<std::mutex> lock(pidfds_mtx_);
+    pidfds_[pfd] = pid;
+    try {
+        add_to_epoll(epoll_fd_, pfd);
+    } catch (...) {
+        pidfds_.erase(pfd);
+        close(pfd);
+        return false;
+    }
+    return true;
+}
+
+void ProcessEventStream::track_spawned(pid_t pid) {
+    std::lock_guard<std::mutex> lock(g_streams_mtx);
+    for (ProcessEventStream* stream : g_streams) stream->track(pid);
+}
+
+void ProcessEventStream::drain_netlink(std::vector<ProcEvent>& events,
+                                       std::vector<pid_t>& touched, bool& resync) {
+    alignas(struct nlmsghdr) char buf[16384];
+    for (;;) {
+        ssize_t len = recv(netlink_fd_, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {  // socket queue overflowed: events lost
+                resync = true;
+                continue;
+            }
+            return;  // EAGAIN: drained
+        }
+        if (len == 0) return;
+
+        auto* nh = reinterpret_cast<struct nlmsghdr*>(buf);
+        for (; NLMSG_OK(nh, static_cast<unsigned>(len)); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == NLMSG_NOOP || nh->nlmsg_type == NLMSG_ERROR) continue;
+            auto* cn = static_cast<struct cn_msg*>(NLMSG_DATA(nh));
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            auto* ev = reinterpret_cast<struct proc_event*>(cn->data);
+
+            // Thread creation/exit also shows up here; keep thread-group leaders.
+            switch (ev->what) {
+                case proc_event::PROC_EVENT_FORK: {
+                    const auto& f = ev->event_data.fork;
+                    if (f.child_pid != f.child_tgid) break;
+                    events.push_back({ProcEventType::Fork, f.child_tgid, f.parent_tgid, 0});
+                    touched.push_back(f.child_tgid);
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXEC: {
+                    const auto& e = ev->event_data.exec;
+                    events.push_back({ProcEventType::Exec, e.process_tgid, 0, 0});
+                    touched.push_back(e.process_tgid);
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXIT: {
+                    const auto& x = ev->event_data.exit;
+                    if (x.process_pid != x.process_tgid) break;
+                    events.push_back({ProcEventType::Exit, x.process_tgid, 0,
+                                      decode_wait_status(x.exit_code)});
+                    touched.push_back(x.process_tgid);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void ProcessEventStream::rescan(std::vector<ProcEvent>& events) {
+    auto delta = table_.diff();
+    for (const auto& p : delta.spawned) {
+        events.push_back({ProcEventType::Fork, p.pid, p.ppid, 0});
+    }
+    for (pid_t pid : delta.execed) {
+        events.push_back({ProcEventType::Exec, pid, 0, 0});
+    }
+    for (pid_t pid : delta.exited) {
+        events.push_back({ProcEventType::Exit, pid, 0, -1});
+    }
+}
+
+std::vector<ProcEvent> ProcessEventStream::poll(int timeout_ms) {
+    std::vector<ProcEvent> events;
+    std::vector<pid_t> touched;
+    bool timer_fired = false;
+    bool resync = false;
+
+    struct epoll_event ready[64];
+    int n = epoll_wait(epoll_fd_, ready, 64, timeout_ms);
+    for (int i = 0; i < n; ++i) {
+        int fd = ready[i].data.fd;
+        if (fd == timer_fd_) {
+            uint64_t expirations;
+            while (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {}
+            timer_fired = true;
+        } else if (fd == netlink_fd_) {
+            drain_netlink(events, touched, resync);
+        } else {
+            std::lock_guard<std::mutex> lock(pidfds_mtx_);
+            auto it = pidfds_.find(fd);
+            if (it == pidfds_.end()) continue;
+            // Peek at the exit status without reaping: the child belongs to
+            // whoever spawned it, and they may still waitpid() it.
+            siginfo_t info{};
+            int code = -1;
+            if (waitid(kIdTypePidfd, static_cast<id_t>(fd), &info, WEXITED | WNOWAIT | WNOHANG) == 0 &&
+                info.si_pid != 0) {
+                code = (info.si_code == CLD_EXITED) ? info.si_status : -info.si_status;
+            }
+            events.push_back({ProcEventType::Exit, it->second, 0, code});
+            touched.push_back(it->second);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            pidfds_.erase(it);
+        }
+    }
+
+    if (resync || (timer_fired && mode_ == Mode::Polling)) {
+        // A full diff supersedes per-PID updates and reports its own events.
+        if (resync) events.clear();
+        rescan(events);
+    } else if (!touched.empty() || timer_fired) {
+        auto delta = table_.update(touched);
+        // A pidfd exit can be the first we hear of a short-lived child.
+        if (mode_ == Mode::Polling) {
+            for (const auto& p : delta.spawned) {
+                events.push_back({ProcEventType::Fork, p.pid, p.ppid, 0});
+            }
+        }
+    }
+    return events;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,134 @@
+#include "agent_kernel/process_sampler.h"
+#include "agent_kernel/proc_scanner.h"
+
+#include <time.h>
+#include <unistd.h>
+
+namespace agent_kernel {
+
+namespace {
+
+constexpr size_t kInitialCapacity = 1024;  // must be a power of two
+
+size_t hash_pid(pid_t pid) {
+    return static_cast<size_t>(static_cast<uint32_t>(pid) * 2654435761u);
+}
+
+// Same clock the kernel uses for /proc/<pid>/stat starttime.
+double boottime_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+const double kClockTicks = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+} // anonymous namespace
+
+ProcessSampler::ProcessSampler() : slots_(kInitialCapacity, Slot{0, 0, 0, 0}) {}
+
+ProcessSampler::Slot* ProcessSampler::find_or_insert(pid_t pid) {
+    if ((count_ + 1) * 2 > slots_.size()) grow();
+
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash_pid(pid) & mask; ; i = (i + 1) & mask) {
+        Slot& s = slots_[i];
+        if (s.pid == pid) return &s;
+        if (s.pid == 0) {
+            s = Slot{pid, 0, 0, 0};  // generation 0 marks "not seen before"
+            ++count_;
+            return &s;
+        }
+    }
+}
+
+void ProcessSampler::erase_at(size_t idx) {
+    // Backward-shift deletion: pull later members of the probe run into the
+    // hole so lookups never need tombstones.
+    size_t mask = slots_.size() - 1;
+    size_t hole = idx;
+    for (size_t j = (hole + 1) & mask; slots_[j].pid != 0; j = (j + 1) & mask) {
+        size_t home = hash_pid(slots_[j].pid) & mask;
+        bool home_in_gap = (hole <= j) ? (hole < home && home <= j)
+                                       : (hole < home || home <= j);
+        if (home_in_gap) continue;
+        slots_[hole] = slots_[j];
+        hole = j;
+    }
+    slots_[hole].pid = 0;
+    --count_;
+}
+
+void ProcessSampler::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, 0, 0, 0});
+    old.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (const Slot& s : old) {
+        if (s.pid == 0) continue;
+        size_t i = hash_pid(s.pid) & mask;
+        while (slots_[i].pid != 0) i = (i + 1) & mask;
+        slots_[i] = s;
+    }
+}
+
+void ProcessSampler::sweep() {
+    // Removal only ever moves entries into the current position or further
+    // ahead, so re-checking the same index after an erase visits everything.
+    for (size_t i = 0; i < slots_.size(); ) {
+        if (slots_[i].pid != 0 && slots_[i].generation != generation_) {
+            erase_at(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+std::vector<ProcessInfo> ProcessSampler::sample() {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (++generation_ == 0) generation_ = 1;
+    double now = boottime_seconds();
+    double elapsed = prev_time_ > 0.0 ? now - prev_time_ : 0.0;
+
+    const auto& scanner = ProcScanner::system();
+    auto pid_list = scanner.pids();
+    std::vector<ProcessInfo> procs;
+    procs.reserve(pid_list.size());
+
+    for (pid_t pid : pid_list) {
+        procs.emplace_back();
+        ProcessInfo& info = procs.back();
+        ProcTimes times{};
+        if (!scanner.read(pid, info, &times)) {
+            procs.pop_back();
+            continue;
+        }
+
+        uint64_t ticks = times.utime + times.stime;
+        Slot* slot = find_or_insert(pid);
+        bool known = slot->generation != 0 && slot->start_time == info.start_time;
+
+        if (known && elapsed > 0.0 && ticks >= slot->ticks) {
+            info.cpu_percent = static_cast<double>(ticks - slot->ticks) / kClockTicks / elapsed * 100.0;
+        } else {
+            // First sighting (or PID reuse): average over the process lifetime.
+            double age = now - static_cast<double>(info.start_time) / kClockTicks;
+            info.cpu_percent = age > 0.0 ? static_cast<double>(ticks) / kClockTicks / age * 100.0 : 0.0;
+        }
+
+        slot->generation = generation_;
+        slot->start_time = info.start_time;
+        slot->ticks = ticks;
+    }
+
+    sweep();
+    prev_time_ = now;
+    return procs;
+}
+
+size_t ProcessSampler::tracked() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return count_;
+}
+
+} // namespace agent_kernel
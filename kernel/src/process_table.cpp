@@ -0,0 +1,175 @@
+#include "agent_kernel/process_table.h"
+#include "agent_kernel/proc_scanner.h"
+
+#include <algorithm>
+
+namespace agent_kernel {
+
+namespace {
+
+bool execed(const ProcessInfo& a, const ProcessInfo& b) {
+    return a.name != b.name || a.cmdline != b.cmdline;
+}
+
+// Busy processes flip between R and S every tick; only entering or leaving
+// zombie or uninterruptible sleep is worth reporting.
+bool notable_state(char state) {
+    return state == 'Z' || state == 'D';
+}
+
+bool differs(const ProcessInfo& a, const ProcessInfo& b) {
+    bool state_changed = a.state != b.state && (notable_state(a.state) || notable_state(b.state));
+    return state_changed || a.ppid != b.ppid || execed(a, b);
+}
+
+} // anonymous namespace
+
+ProcessDelta ProcessTable::diff() {
+    // Scan outside the table lock so queries are never blocked on procfs.
+    std::lock_guard<std::mutex> refresh(refresh_mtx_);
+    auto fresh = sampler_.sample();
+
+    std::unordered_map<pid_t, ProcessInfo> next;
+    next.reserve(fresh.size());
+    ProcessDelta delta;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& p : fresh) {
+        auto it = procs_.find(p.pid);
+        if (it == procs_.end()) {
+            delta.spawned.push_back(p);
+        } else if (it->second.start_time != p.start_time) {
+            delta.exited.push_back(p.pid);
+            delta.spawned.push_back(p);
+        } else if (differs(it->second, p)) {
+            if (execed(it->second, p)) delta.execed.push_back(p.pid);
+            delta.changed.push_back(p);
+        }
+        pid_t pid = p.pid;
+        next.emplace(pid, std::move(p));
+    }
+    for (const auto& [pid, _] : procs_) {
+        if (next.find(pid) == next.end()) delta.exited.push_back(pid);
+    }
+
+    procs_.swap(next);
+    return delta;
+}
+
+ProcessDelta ProcessTable::update(const std::vector<pid_t>& pids) {
+    std::lock_guard<std::mutex> refresh(refresh_mtx_);
+
+    std::vector<pid_t> targets = pids;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto& [pid, p] : procs_) {
+            if (p.state == 'Z') targets.push_back(pid);
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    // Read outside the table lock, as in diff().
+    const auto& scanner = ProcScanner::system();
+    std::vector<ProcessInfo> fresh(targets.size());
+    std::vector<bool> alive(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        alive[i] = scanner.read(targets[i], fresh[i]);
+    }
+
+    ProcessDelta delta;
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        pid_t pid = targets[i];
+        auto it = procs_.find(pid);
+        if (!alive[i]) {
+            if (it != procs_.end()) {
+                procs_.erase(it);
+                delta.exited.push_back(pid);
+            }
+            continue;
+        }
+
+        ProcessInfo& p = fresh[i];
+        if (it == procs_.end()) {
+            delta.spawned.push_back(p);
+            procs_.emplace(pid, std::move(p));
+        } else if (it->second.start_time != p.start_time) {
+            delta.exited.push_back(pid);
+            delta.spawned.push_back(p);
+            it->second = std::move(p);
+        } else {
+            p.cpu_percent = it->second.cpu_percent;
+            if (differs(it->second, p)) {
+                if (execed(it->second, p)) delta.execed.push_back(pid);
+                delta.changed.push_back(p);
+            }
+            it->second = std::move(p);
+        }
+    }
+    return delta;
+}
+
+size_t ProcessTable::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return procs_.size();
+}
+
+std::map<char, size_t> ProcessTable::state_counts() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::map<char, size_t> counts;
+    for (const auto& [_, p] : procs_) ++counts[p.state];
+    return counts;
+}
+
+size_t ProcessTable::count_state(char state) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t n = 0;
+    for (const auto& [_, p] : procs_) {
+        if (p.state == state) ++n;
+    }
+    return n;
+}
+
+template <typename Less>
+std::vector<ProcessInfo> ProcessTable::top_n(size_t n, Less less) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<const ProcessInfo*> ptrs;
+    ptrs.reserve(procs_.size());
+    for (const auto& [_, p] : procs_) ptrs.push_back(&p);
+
+    n = std::min(n, ptrs.size());
+    std::partial_sort(ptrs.begin(), ptrs.begin() + static_cast<std::ptrdiff_t>(n), ptrs.end(),
+                      [&](const ProcessInfo* a, const ProcessInfo* b) { return less(*b, *a); });
+
+    std::vector<ProcessInfo> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i) result.push_back(*ptrs[i]);
+    return result;
+}
+
+std::vector<ProcessInfo> ProcessTable::top_by_rss(size_t n) const {
+    return top_n(n, [](const ProcessInfo& a, const ProcessInfo& b) { return a.rss_kb < b.rss_kb; });
+}
+
+std::vector<ProcessInfo> ProcessTable::top_by_cpu(size_t n) const {
+    return top_n(n, [](const ProcessInfo& a, const ProcessInfo& b) { return a.cpu_percent < b.cpu_percent; });
+}
+
+std::vector<ProcessInfo> ProcessTable::snapshot() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<ProcessInfo> result;
+    result.reserve(procs_.size());
+    for (const auto& [_, p] : procs_) result.push_back(p);
+    return result;
+}
+
+ProcessColumns ProcessTable::columns() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ProcessColumns cols;
+    cols.reserve(procs_.size());
+    for (const auto& [_, p] : procs_) cols.push_back(p);
+    return cols;
+}
+
+} // namespace agent_kernel
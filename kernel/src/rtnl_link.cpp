@@ -0,0 +1,111 @@
+#include "agent_kernel/rtnl_link.h"
+#include "agent_kernel/stats.h"
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace agent_kernel {
+
+namespace {
+
+// Link messages carry many attributes; 32 KB holds a few dozen per recv().
+constexpr size_t kRecvBufSize = 32 * 1024;
+
+} // anonymous namespace
+
+RtnlLinkReader::RtnlLinkReader() : buf_(kRecvBufSize) {
+    fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_ROUTE);
+}
+
+RtnlLinkReader::~RtnlLinkReader() {
+    if (fd_ >= 0) close(fd_);
+}
+
+RtnlLinkReader& RtnlLinkReader::shared() {
+    static RtnlLinkReader reader;
+    return reader;
+}
+
+bool RtnlLinkReader::read(std::vector<LinkRecord>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out.clear();
+    if (fd_ < 0) return false;
+
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;
+    } msg{};
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = RTM_GETLINK;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.nlh.nlmsg_seq = ++seq_;
+    msg.ifi.ifi_family = AF_UNSPEC;
+
+    struct sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    Stats::count(Syscall::Send);
+    if (sendto(fd_, &msg, sizeof(msg), 0, reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    for (;;) {
+        ssize_t len = recv(fd_, buf_.data(), buf_.size(), 0);
+        Stats::count(Syscall::Recv);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            out.clear();
+            return false;
+        }
+
+        auto* nh = reinterpret_cast<struct nlmsghdr*>(buf_.data());
+        for (; NLMSG_OK(nh, static_cast<unsigned>(len)); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_seq != seq_) continue;  // stale reply from an aborted dump
+            if (nh->nlmsg_type == NLMSG_DONE) return !out.empty();
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                out.clear();
+                return false;
+            }
+            if (nh->nlmsg_type != RTM_NEWLINK) continue;
+
+            auto* ifi = static_cast<const struct ifinfomsg*>(NLMSG_DATA(nh));
+            LinkRecord rec{};
+            rec.ifindex = ifi->ifi_index;
+            rec.flags = ifi->ifi_flags;
+            bool has_stats = false;
+
+            int attr_len = static_cast<int>(IFLA_PAYLOAD(nh));
+            for (auto* attr = IFLA_RTA(ifi); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type == IFLA_IFNAME) {
+                    rec.stats.name.assign(static_cast<const char*>(RTA_DATA(attr)),
+                                          strnlen(static_cast<const char*>(RTA_DATA(attr)), RTA_PAYLOAD(attr)));
+                } else if (attr->rta_type == IFLA_STATS64) {
+                    // Older kernels send a shorter struct than these headers
+                    // describe; the missing tail stays zero. memcpy because
+                    // attribute data is only 4-byte aligned.
+                    struct rtnl_link_stats64 st{};
+                    std::memcpy(&st, RTA_DATA(attr), std::min<size_t>(RTA_PAYLOAD(attr), sizeof(st)));
+                    rec.stats.rx_bytes = st.rx_bytes;
+                    rec.stats.tx_bytes = st.tx_bytes;
+                    rec.stats.rx_packets = st.rx_packets;
+                    rec.stats.tx_packets = st.tx_packets;
+                    rec.stats.rx_errors = st.rx_errors;
+                    rec.stats.tx_errors = st.tx_errors;
+                    // Matches the /proc/net/dev "drop" column
+                    rec.stats.rx_dropped = st.rx_dropped + st.rx_missed_errors;
+                    rec.stats.tx_dropped = st.tx_dropped;
+                    has_stats = true;
+                }
+            }
+            if (has_stats) out.push_back(std::move(rec));
+        }
+    }
+}
+
+} // namespace agent_kernel
@@ -1,151 +1,387 @@
 #include "agent_kernel/sandbox.h"
+#include "agent_kernel/cgroup.h"
+#include "agent_kernel/output_buffer.h"
+#include "agent_kernel/spawn.h"
+#include "agent_kernel/stats.h"
 
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 #include <signal.h>
 
-#include <array>
+#include <algorithm>
 #include <chrono>
-#include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <exception>
+#include <memory>
 #include <stdexcept>
-#include <thread>
 
 namespace agent_kernel {
 
 namespace {
 
-bool apply_rlimit(int resource, int64_t value) {
-    if (value < 0) return true;  // unlimited — nothing to do
-    struct rlimit rl;
-    rl.rlim_cur = static_cast<rlim_t>(value);
-    rl.rlim_max = static_cast<rlim_t>(value);
-    return setrlimit(resource, &rl) == 0;
-}
+using Clock = std::chrono::steady_clock;
 
-std::string read_pipe(int fd) {
-    std::string result;
-    char buf[4096];
-    ssize_t n;
-    while ((n = read(fd, buf, sizeof(buf))) > 0) {
-        result.append(buf, static_cast<size_t>(n));
-    }
-    return result;
-}
+// Without pidfds, exits are noticed by polling waitpid at this interval.
+constexpr int kFallbackPollMs = 10;
 
-} // anonymous namespace
+// epoll tags: job index in the high bits, descriptor kind in the low two.
+constexpr uint64_t kTagStdout = 0;
+constexpr uint64_t kTagStderr = 1;
+constexpr uint64_t kTagPidfd = 2;
+constexpr uint64_t kTagTimer = ~uint64_t{0};
 
-ExecutionResult Sandbox::run(const std::string& command, const SandboxPolicy& policy) {
-    return run_with_timeout(command, 0, policy);
+struct Job {
+    pid_t pid = -1;
+    int out_fd = -1;
+    int err_fd = -1;
+    int pidfd = -1;
+    bool exited = false;
+    bool finished = false;
+    bool cgroup_killed = false;
+    Clock::time_point start;
+    std::unique_ptr<TransientCgroup> cgroup;
+    OutputBuffer out;
+    OutputBuffer err;
+    ExecutionResult result{};
+};
+
+int pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
 }
 
-ExecutionResult Sandbox::run_with_timeout(
-    const std::string& command,
-    int timeout_seconds,
-    const SandboxPolicy& policy
-) {
+void close_fd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Start `command` under /bin/sh with stdout/stderr on fresh non-blocking pipes.
+void spawn_job(const std::string& command, const SandboxPolicy& policy, Job& job) {
+    // O_CLOEXEC keeps concurrent spawns from inheriting each other's pipes,
+    // which would otherwise hold write ends open and delay EOF.
     int stdout_pipe[2], stderr_pipe[2];
-    if (pipe(stdout_pipe) != 0 || pipe(stderr_pipe) != 0) {
+    if (pipe2(stdout_pipe, O_CLOEXEC) != 0) {
+        throw std::runtime_error(std::string("pipe failed: ") + strerror(errno));
+    }
+    if (pipe2(stderr_pipe, O_CLOEXEC) != 0) {
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
         throw std::runtime_error(std::string("pipe failed: ") + strerror(errno));
     }
 
-    auto start = std::chrono::steady_clock::now();
+    SpawnOptions options;
+    options.path = "/bin/sh";
+    options.argv = {"sh", "-c", command};
+    options.env = policy.env;
+    options.working_dir = policy.working_dir;
+    options.limits = policy.limits;
+    options.stdout_fd = stdout_pipe[1];
+    options.stderr_fd = stderr_pipe[1];
 
-    pid_t pid = fork();
-    if (pid < 0) {
-        throw std::runtime_error(std::string("fork failed: ") + strerror(errno));
+    if (policy.use_cgroup) {
+        TransientCgroup::Limits cg_limits;
+        cg_limits.memory_max = policy.limits.max_memory_bytes;
+        cg_limits.cpu_max = policy.cpu_cores;
+        cg_limits.pids_max = policy.limits.max_processes;
+        job.cgroup = TransientCgroup::create(cg_limits);
+        if (job.cgroup) {
+            // memory.max charges real usage; RLIMIT_AS would also count
+            // reserved address space.
+            options.limits.max_memory_bytes = -1;
+            options.cgroup_procs_fd = job.cgroup->procs_fd();
+        }
     }
 
-    if (pid == 0) {
-        // Child: redirect stdout/stderr to pipes
-        close(stdout_pipe[0]);
-        close(stderr_pipe[0]);
-        dup2(stdout_pipe[1], STDOUT_FILENO);
-        dup2(stderr_pipe[1], STDERR_FILENO);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
-
-        // Apply resource limits
-        const auto& lim = policy.limits;
-        apply_rlimit(RLIMIT_CPU, lim.max_cpu_seconds);
-        apply_rlimit(RLIMIT_AS, lim.max_memory_bytes);
-        apply_rlimit(RLIMIT_FSIZE, lim.max_file_size);
-        apply_rlimit(RLIMIT_NOFILE, lim.max_open_files);
-        apply_rlimit(RLIMIT_NPROC, lim.max_processes);
-
-        // Change working directory
-        if (!policy.working_dir.empty()) {
-            if (chdir(policy.working_dir.c_str()) != 0) {
-                _exit(126);
-            }
+    job.start = Clock::now();
+    pid_t pid;
+    try {
+        try {
+            pid = spawn_process(options);
+        } catch (const std::exception&) {
+            if (!job.cgroup) throw;
+            // Could not join (or start at all): retry once on rlimits alone.
+            // The child never reached execve, so nothing ran twice.
+            job.cgroup.reset();
+            options.limits = policy.limits;
+            options.cgroup_procs_fd = -1;
+            pid = spawn_process(options);
         }
+    } catch (...) {
+        for (int fd : {stdout_pipe[0], stdout_pipe[1], stderr_pipe[0], stderr_pipe[1]}) close(fd);
+        throw;
+    }
 
-        // Set environment variables (use setenv which copies the value)
-        for (const auto& env : policy.env) {
-            auto eq = env.find('=');
-            if (eq != std::string::npos) {
-                setenv(env.substr(0, eq).c_str(), env.substr(eq + 1).c_str(), 1);
-            }
+    close(stdout_pipe[1]);
+    close(stderr_pipe[1]);
+    job.pid = pid;
+    job.out_fd = stdout_pipe[0];
+    job.err_fd = stderr_pipe[0];
+    fcntl(job.out_fd, F_SETFL, O_NONBLOCK);
+    fcntl(job.err_fd, F_SETFL, O_NONBLOCK);
+    job.pidfd = pidfd_open(pid);
+}
+
+// Drain a non-blocking pipe; closes it on EOF.
+void drain(int& fd, OutputBuffer& out, int stream, const OutputCallback* on_output) {
+    char buf[16384];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            out.append(buf, static_cast<size_t>(n));
+            if (on_output) (*on_output)(stream, buf, static_cast<size_t>(n));
+            continue;
         }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+        close_fd(fd);  // EOF or hard error
+        return;
+    }
+}
+
+double seconds(const struct timeval& tv) {
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
 
-        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
-        _exit(127);
+void reap(Job& job, bool block) {
+    int status = 0;
+    struct rusage ru{};
+    pid_t w = wait4(job.pid, &status, block ? 0 : WNOHANG, &ru);
+    if (w == 0 || (w < 0 && errno != ECHILD)) return;
+    job.exited = true;
+    ExecutionResult& r = job.result;
+    if (w < 0) {
+        // Someone else reaped it (e.g. SIGCHLD set to SIG_IGN)
+        r.exit_code = -1;
+    } else {
+        if (!r.timed_out) r.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        r.term_signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+        r.user_cpu_seconds = seconds(ru.ru_utime);
+        r.sys_cpu_seconds = seconds(ru.ru_stime);
+        r.max_rss_kb = ru.ru_maxrss;
+        r.minor_faults = ru.ru_minflt;
+        r.major_faults = ru.ru_majflt;
+        r.voluntary_switches = ru.ru_nvcsw;
+        r.involuntary_switches = ru.ru_nivcsw;
     }
+    close_fd(job.pidfd);
+}
 
-    // Parent: drain pipes FIRST (in threads) to avoid deadlock,
-    // then waitpid. If the child writes >64KB, write() blocks waiting
-    // for the parent to read — if we waitpid first, that's a deadlock.
-    close(stdout_pipe[1]);
-    close(stderr_pipe[1]);
+void epoll_add(int epfd, int fd, uint64_t tag) {
+    if (fd < 0) return;
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = tag;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
 
-    std::string out_str, err_str;
-    std::thread t_out([&]{ out_str = read_pipe(stdout_pipe[0]); });
-    std::thread t_err([&]{ err_str = read_pipe(stderr_pipe[0]); });
+// Supervise every job from this one thread: pipes and pidfds in epoll, and a
+// timerfd for the shared deadline. Output is read as it arrives, so a child
+// blocking on a full pipe never deadlocks against the wait.
+void supervise(std::vector<Job>& jobs, int timeout_seconds, const OutputCallback* on_output) {
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
 
-    ExecutionResult result{};
-    result.timed_out = false;
+    bool have_fallback = false;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        epoll_add(epfd, jobs[i].out_fd, (i << 2) | kTagStdout);
+        epoll_add(epfd, jobs[i].err_fd, (i << 2) | kTagStderr);
+        epoll_add(epfd, jobs[i].pidfd, (i << 2) | kTagPidfd);
+        if (jobs[i].pidfd < 0) have_fallback = true;
+    }
 
+    int timer_fd = -1;
+    bool deadline_passed = false;
     if (timeout_seconds > 0) {
-        auto deadline = start + std::chrono::seconds(timeout_seconds);
-        int status = 0;
-        bool exited = false;
-
-        while (std::chrono::steady_clock::now() < deadline) {
-            pid_t w = waitpid(pid, &status, WNOHANG);
-            if (w > 0) {
-                exited = true;
-                result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
-                break;
+        timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd >= 0) {
+            struct itimerspec its{};
+            its.it_value.tv_sec = timeout_seconds;
+            timerfd_settime(timer_fd, 0, &its, nullptr);
+            epoll_add(epfd, timer_fd, kTagTimer);
+        }
+    }
+    auto deadline = Clock::now() + std::chrono::seconds(timeout_seconds);
+
+    std::exception_ptr callback_error;
+    size_t remaining = jobs.size();
+    while (remaining > 0) {
+        struct epoll_event ready[32];
+        int wait_ms = have_fallback ? kFallbackPollMs : -1;
+        if (timer_fd < 0 && timeout_seconds > 0 && !deadline_passed) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            int left_ms = left > 0 ? static_cast<int>(left) : 0;
+            wait_ms = (wait_ms < 0) ? left_ms : std::min(wait_ms, left_ms);
+        }
+
+        int n = epoll_wait(epfd, ready, 32, wait_ms);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int k = 0; k < n; ++k) {
+            uint64_t tag = ready[k].data.u64;
+            if (tag == kTagTimer) {
+                deadline_passed = true;
+                continue;
+            }
+            Job& job = jobs[tag >> 2];
+            try {
+                switch (tag & 3) {
+                    case kTagStdout: drain(job.out_fd, job.out, 1, on_output); break;
+                    case kTagStderr: drain(job.err_fd, job.err, 2, on_output); break;
+                    case kTagPidfd:  reap(job, true); break;
+                }
+            } catch (...) {
+                // Stop feeding the callback and wind everything down.
+                callback_error = std::current_exception();
+                on_output = nullptr;
+                deadline_passed = true;
+            }
+        }
+
+        if (timer_fd < 0 && timeout_seconds > 0 && Clock::now() >= deadline) deadline_passed = true;
+
+        for (auto& job : jobs) {
+            if (job.finished) continue;
+            if (!job.exited && job.pidfd < 0) reap(job, false);
+
+            if (deadline_passed && !job.exited) {
+                if (job.cgroup) job.cgroup->kill_all();
+                kill(job.pid, SIGKILL);
+                job.result.timed_out = true;
+                job.result.exit_code = -1;
+                reap(job, true);
+            }
+            if (job.exited && job.cgroup && !job.cgroup_killed) {
+                // Leftover background processes go with the cgroup, which
+                // also releases any pipe ends they hold.
+                job.cgroup->kill_all();
+                job.cgroup_killed = true;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (job.exited && deadline_passed) {
+                // Past the deadline, don't wait on background grandchildren
+                // that still hold the pipes open.
+                if (job.out_fd >= 0) drain(job.out_fd, job.out, 1, nullptr);
+                if (job.err_fd >= 0) drain(job.err_fd, job.err, 2, nullptr);
+                close_fd(job.out_fd);
+                close_fd(job.err_fd);
+            }
+            if (job.exited && job.out_fd < 0 && job.err_fd < 0) {
+                job.finished = true;
+                job.result.truncated = job.out.truncated() || job.err.truncated();
+                job.result.stdout_output = job.out.take();
+                job.result.stderr_output = job.err.take();
+                if (job.cgroup) {
+                    job.result.memory_peak_bytes = job.cgroup->memory_peak_bytes();
+                    job.result.cpu_usage_usec = job.cgroup->cpu_usage_usec();
+                    job.result.cpu_throttled_usec = job.cgroup->cpu_throttled_usec();
+                }
+                job.result.elapsed_seconds =
+                    std::chrono::duration<double>(Clock::now() - job.start).count();
+                --remaining;
+            }
+        }
+        have_fallback = false;
+        for (const auto& job : jobs) {
+            if (!job.exited && job.pidfd < 0) have_fallback = true;
         }
+    }
 
-        if (!exited) {
-            kill(pid, SIGKILL);
-            waitpid(pid, &status, 0);
-            result.timed_out = true;
-            result.exit_code = -1;
+    for (auto& job : jobs) {
+        close_fd(job.out_fd);
+        close_fd(job.err_fd);
+        close_fd(job.pidfd);
+    }
+    // Removing a cgroup waits for its members to finish dying, so it happens
+    // once every job is done rather than between events.
+    for (auto& job : jobs) job.cgroup.reset();
+    if (timer_fd >= 0) close(timer_fd);
+    close(epfd);
+    if (callback_error) std::rethrow_exception(callback_error);
+}
+
+std::vector<ExecutionResult> run_jobs(
+    const std::vector<std::string>& commands,
+    int timeout_seconds,
+    const SandboxPolicy& policy,
+    const OutputCallback* on_output
+) {
+    std::vector<Job> jobs(commands.size());
+    for (size_t i = 0; i < commands.size(); ++i) {
+        jobs[i].out = OutputBuffer(policy.output_head_bytes, policy.output_tail_bytes);
+        jobs[i].err = OutputBuffer(policy.output_head_bytes, policy.output_tail_bytes);
+        jobs[i].result.memory_peak_bytes = -1;
+        jobs[i].result.cpu_usage_usec = -1;
+        jobs[i].result.cpu_throttled_usec = -1;
+        try {
+            spawn_job(commands[i], policy, jobs[i]);
+        } catch (...) {
+            // Don't leave already-started children unsupervised
+            for (size_t j = 0; j < i; ++j) {
+                kill(jobs[j].pid, SIGKILL);
+                waitpid(jobs[j].pid, nullptr, 0);
+                close_fd(jobs[j].out_fd);
+                close_fd(jobs[j].err_fd);
+                close_fd(jobs[j].pidfd);
+            }
+            throw;
         }
-    } else {
-        int status = 0;
-        waitpid(pid, &status, 0);
-        result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
     }
 
-    t_out.join();
-    t_err.join();
-    close(stdout_pipe[0]);
-    close(stderr_pipe[0]);
+    supervise(jobs, timeout_seconds, on_output);
 
-    result.stdout_output = std::move(out_str);
-    result.stderr_output = std::move(err_str);
+    std::vector<ExecutionResult> results;
+    results.reserve(jobs.size());
+    for (auto& job : jobs) results.push_back(std::move(job.result));
+    return results;
+}
+
+} // anonymous namespace
+
+ExecutionResult Sandbox::run(const std::string& command, const SandboxPolicy& policy) {
+    return run_with_timeout(command, 0, policy);
+}
+
+ExecutionResult Sandbox::run_with_timeout(
+    const std::string& command,
+    int timeout_seconds,
+    const SandboxPolicy& policy
+) {
+    ProbeTimer timer(Probe::SandboxRun);
+    return std::move(run_jobs({command}, timeout_seconds, policy, nullptr).front());
+}
 
-    auto end = std::chrono::steady_clock::now();
-    result.elapsed_seconds = std::chrono::duration<double>(end - start).count();
+ExecutionResult Sandbox::run_streaming(
+    const std::string& command,
+    int timeout_seconds,
+    const OutputCallback& on_output,
+    const SandboxPolicy& policy
+) {
+    ProbeTimer timer(Probe::SandboxRunStreaming);
+    const OutputCallback* cb = on_output ? &on_output : nullptr;
+    return std::move(run_jobs({command}, timeout_seconds, policy, cb).front());
+}
 
-    return result;
+std::vector<ExecutionResult> Sandbox::run_batch(
+    const std::vector<std::string>& commands,
+    int timeout_seconds,
+    const SandboxPolicy& policy
+) {
+    ProbeTimer timer(Probe::SandboxRunBatch);
+    return run_jobs(commands, timeout_seconds, policy, nullptr);
 }
 
 } // namespace agent_kernel
@@ -0,0 +1,453 @@
+#include "agent_kernel/sandbox_pool.h"
+#include "agent_kernel/cgroup.h"
+#include "agent_kernel/output_buffer.h"
+#include "agent_kernel/proc_file.h"
+#include "agent_kernel/spawn.h"
+#include "agent_kernel/stats.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+namespace agent_kernel {
+
+namespace {
+
+// Each command arrives as a line naming its cgroup directory (empty for
+// none), then the command's lines, then the sentinel line ($1). It runs in
+// a subshell with stdin from /dev/null that first moves itself into the
+// cgroup, reporting "C" if it could not; its status is reported back on
+// fd 0, which is the bidirectional socket.
+constexpr const char* kDriver =
+    "__ak_end=$1\n"
+    "while IFS= read -r __ak_cg; do\n"
+    "  __ak_cmd= __ak_got=\n"
+    "  while IFS= read -r __ak_line; do\n"
+    "    if [ \"$__ak_line\" = \"$__ak_end\" ]; then __ak_got=1; break; fi\n"
+    "    __ak_cmd=\"$__ak_cmd$__ak_line\n\"\n"
+    "  done\n"
+    "  [ -n \"$__ak_got\" ] || exit 0\n"
+    "  (\n"
+    "    if [ -n \"$__ak_cg\" ] && ! echo 0 2>/dev/null >\"$__ak_cg/cgroup.procs\"; then echo C >&3; fi\n"
+    "    exec 3>&-; set --; eval \"$__ak_cmd\"\n"
+    "  ) 3>&0 </dev/null\n"
+    "  printf 'X%d\\n' \"$?\" >&0\n"
+    "done\n";
+
+constexpr uint64_t kTagControl = 0;
+constexpr uint64_t kTagStdout = 1;
+constexpr uint64_t kTagStderr = 2;
+constexpr uint64_t kTagTimer = 3;
+
+// Resource use of a worker's reaped children, from /proc/<pid>/stat.
+struct ChildUsage {
+    uint64_t minor_faults;   // cminflt
+    uint64_t major_faults;   // cmajflt
+    uint64_t user_ticks;     // cutime
+    uint64_t sys_ticks;      // cstime
+};
+
+// Workers lead their own process group, and as subreapers inherit whatever
+// a command orphans, so the group reaches everything a command started.
+void kill_group(pid_t pid) {
+    if (kill(-pid, SIGKILL) != 0) kill(pid, SIGKILL);
+}
+
+// Background processes a command left running, now children of the worker.
+bool has_children(pid_t pid) {
+    std::string path = "/proc/" + std::to_string(pid) + "/task/" + std::to_string(pid) + "/children";
+    ProcFile children(path, 64);
+    return children.read() && children.size() > 0;
+}
+
+bool child_usage(pid_t pid, ChildUsage& out) {
+    ProcFile stat("/proc/" + std::to_string(pid) + "/stat", 512);
+    if (!stat.read()) return false;
+    // "pid (comm) state ..." where comm may contain ')'
+    auto* paren = static_cast<const char*>(memrchr(stat.data(), ')', stat.size()));
+    if (!paren) return false;
+    FieldCursor cur{paren + 1, stat.data() + stat.size()};
+    cur.skip_fields(7);                 // fields 3-9
+    cur.next_uint();                    // 10 minflt
+    out.minor_faults = cur.next_uint();
+    cur.next_uint();                    // 12 majflt
+    out.major_faults = cur.next_uint();
+    cur.skip_fields(2);                 // 14-15 utime, stime
+    out.user_ticks = cur.next_uint();
+    out.sys_ticks = cur.next_uint();
+    return !cur.at_end();
+}
+
+void close_fd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+void epoll_add(int epfd, int fd, uint64_t tag) {
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = tag;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+}
+
+// Read whatever is buffered; `out` may be null to discard.
+void drain(int fd, OutputBuffer* out, int stream, const OutputCallback* on_output) {
+    char buf[16384];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            if (!out) continue;
+            out->append(buf, static_cast<size_t>(n));
+            if (on_output) (*on_output)(stream, buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return;
+    }
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string make_sentinel() {
+    std::random_device rd;
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "__agent_kernel_end_%08x%08x%08x__", rd(), rd(), rd());
+    return buf;
+}
+
+} // anonymous namespace
+
+SandboxPool::SandboxPool(const SandboxPolicy& policy, size_t workers, size_t max_uses)
+    : policy_(policy), max_uses_(max_uses ? max_uses : 1), sentinel_(make_sentinel()),
+      workers_(workers ? workers : 1) {
+    try {
+        for (auto& w : workers_) start(w);
+    } catch (...) {
+        for (auto& w : workers_) stop(w);
+        throw;
+    }
+}
+
+SandboxPool::~SandboxPool() {
+    for (auto& w : workers_) stop(w);
+}
+
+size_t SandboxPool::size() const noexcept {
+    return workers_.size();
+}
+
+size_t SandboxPool::max_uses() const noexcept {
+    return max_uses_;
+}
+
+void SandboxPool::start(Worker& w) {
+    int sv[2], out[2], err[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        throw std::runtime_error(std::string("socketpair failed: ") + strerror(errno));
+    }
+    if (pipe2(out, O_CLOEXEC) != 0) {
+        int e = errno;
+        close(sv[0]);
+        close(sv[1]);
+        throw std::runtime_error(std::string("pipe failed: ") + strerror(e));
+    }
+    if (pipe2(err, O_CLOEXEC) != 0) {
+        int e = errno;
+        for (int fd : {sv[0], sv[1], out[0], out[1]}) close(fd);
+        throw std::runtime_error(std::string("pipe failed: ") + strerror(e));
+    }
+
+    SpawnOptions options;
+    options.path = "/bin/sh";
+    options.argv = {"sh", "-c", kDriver, "agent-kernel-worker", sentinel_};
+    options.env = policy_.env;
+    options.working_dir = policy_.working_dir;
+    options.limits = policy_.limits;
+    options.stdin_fd = sv[1];
+    options.stdout_fd = out[1];
+    options.stderr_fd = err[1];
+    options.close_other_fds = true;
+    options.new_process_group = true;
+    options.child_subreaper = true;
+
+    try {
+        w.pid = spawn_process(options);
+    } catch (...) {
+        for (int fd : {sv[0], sv[1], out[0], out[1], err[0], err[1]}) close(fd);
+        throw;
+    }
+    close(sv[1]);
+    close(out[1]);
+    close(err[1]);
+    w.control_fd = sv[0];
+    w.out_fd = out[0];
+    w.err_fd = err[0];
+    w.uses = 0;
+    w.pending.clear();
+    for (int fd : {w.control_fd, w.out_fd, w.err_fd}) fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    w.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    w.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (w.epoll_fd < 0 || w.timer_fd < 0) {
+        int e = errno;
+        stop(w);
+        throw std::runtime_error(std::string("epoll/timerfd setup failed: ") + strerror(e));
+    }
+    try {
+        epoll_add(w.epoll_fd, w.control_fd, kTagControl);
+        epoll_add(w.epoll_fd, w.out_fd, kTagStdout);
+        epoll_add(w.epoll_fd, w.err_fd, kTagStderr);
+        epoll_add(w.epoll_fd, w.timer_fd, kTagTimer);
+    } catch (...) {
+        stop(w);
+        throw;
+    }
+}
+
+void SandboxPool::stop(Worker& w) {
+    close_fd(w.control_fd);
+    close_fd(w.out_fd);
+    close_fd(w.err_fd);
+    close_fd(w.epoll_fd);
+    close_fd(w.timer_fd);
+    if (w.pid > 0) {
+        kill_group(w.pid);
+        waitpid(w.pid, nullptr, 0);
+        w.pid = -1;
+    }
+}
+
+// Returns false if the worker must be replaced.
+bool SandboxPool::execute(Worker& w, const std::string& command, int timeout_seconds,
+                          const OutputCallback* on_output, ExecutionResult& result) {
+    using Clock = std::chrono::steady_clock;
+
+    // Leftovers from processes that left an earlier command's group.
+    drain(w.out_fd, nullptr, 1, nullptr);
+    drain(w.err_fd, nullptr, 2, nullptr);
+    OutputBuffer out(policy_.output_head_bytes, policy_.output_tail_bytes);
+    OutputBuffer err(policy_.output_head_bytes, policy_.output_tail_bytes);
+
+    ChildUsage before{};
+    bool have_usage = child_usage(w.pid, before);
+
+    std::unique_ptr<TransientCgroup> cgroup;
+    if (policy_.use_cgroup) {
+        TransientCgroup::Limits cg_limits;
+        cg_limits.memory_max = policy_.limits.max_memory_bytes;
+        cg_limits.cpu_max = policy_.cpu_cores;
+        cg_limits.pids_max = policy_.limits.max_processes;
+        cgroup = TransientCgroup::create(cg_limits);
+    }
+
+    auto start = Clock::now();
+    std::string frame = cgroup ? cgroup->path() : std::string();
+    frame += '\n';
+    frame += command;
+    frame += '\n';
+    frame += sentinel_;
+    frame += '\n';
+    if (!send_all(w.control_fd, frame)) return false;
+
+    struct itimerspec its{};
+    its.it_value.tv_sec = timeout_seconds > 0 ? timeout_seconds : 0;
+    timerfd_settime(w.timer_fd, 0, &its, nullptr);
+
+    std::exception_ptr callback_error;
+    bool done = false;
+    bool alive = true;
+    while (!done && alive) {
+        struct epoll_event ready[4];
+        int n = epoll_wait(w.epoll_fd, ready, 4, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            alive = false;
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            switch (ready[k].data.u64) {
+                case kTagStdout:
+                case kTagStderr: {
+                    bool is_out = ready[k].data.u64 == kTagStdout;
+                    try {
+                        drain(is_out ? w.out_fd : w.err_fd, is_out ? &out : &err, is_out ? 1 : 2, on_output);
+                    } catch (...) {
+                        // Kill the command, then surface the error once the
+                        // worker is gone.
+                        callback_error = std::current_exception();
+                        on_output = nullptr;
+                        kill_group(w.pid);
+                        if (cgroup) cgroup->kill_all();
+                    }
+                    break;
+                }
+                case kTagTimer: {
+                    uint64_t expirations;
+                    while (read(w.timer_fd, &expirations, sizeof(expirations)) > 0) {}
+                    result.timed_out = true;
+                    kill_group(w.pid);
+                    if (cgroup) cgroup->kill_all();
+                    break;
+                }
+                case kTagControl: {
+                    char buf[256];
+                    ssize_t r;
+                    while ((r = read(w.control_fd, buf, sizeof(buf))) > 0) {
+                        w.pending.append(buf, static_cast<size_t>(r));
+                    }
+                    if (r == 0) alive = false;  // worker exited
+                    size_t nl;
+                    while ((nl = w.pending.find('\n')) != std::string::npos) {
+                        std::string line = w.pending.substr(0, nl);
+                        w.pending.erase(0, nl + 1);
+                        if (line == "C") {
+                            cgroup.reset();  // could not join; rlimits only
+                        } else if (line.size() >= 2 && line[0] == 'X') {
+                            result.exit_code = std::atoi(line.c_str() + 1);
+                            done = true;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    its.it_value.tv_sec = 0;
+    timerfd_settime(w.timer_fd, 0, &its, nullptr);
+
+    // The subshell has exited, so everything it wrote is already buffered.
+    if (!callback_error) {
+        try {
+            drain(w.out_fd, &out, 1, on_output);
+            drain(w.err_fd, &err, 2, on_output);
+        } catch (...) {
+            callback_error = std::current_exception();
+        }
+    }
+    if (callback_error) std::rethrow_exception(callback_error);
+
+    result.truncated = out.truncated() || err.truncated();
+    result.stdout_output = out.take();
+    result.stderr_output = err.take();
+    if (!done || result.timed_out) result.exit_code = -1;
+    if (result.timed_out) {
+        result.term_signal = SIGKILL;
+    } else if (result.exit_code > 128 && result.exit_code - 128 < NSIG) {
+        // $? is 128+N for a signal death; report it the way Sandbox does
+        result.term_signal = result.exit_code - 128;
+        result.exit_code = -1;
+    }
+    result.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // The worker has reaped the subshell, so its totals include it.
+    ChildUsage after{};
+    if (have_usage && done && child_usage(w.pid, after)) {
+        static const double tick = static_cast<double>(sysconf(_SC_CLK_TCK));
+        result.user_cpu_seconds = static_cast<double>(after.user_ticks - before.user_ticks) / tick;
+        result.sys_cpu_seconds = static_cast<double>(after.sys_ticks - before.sys_ticks) / tick;
+        result.minor_faults = static_cast<int64_t>(after.minor_faults - before.minor_faults);
+        result.major_faults = static_cast<int64_t>(after.major_faults - before.major_faults);
+    }
+    if (cgroup) {
+        result.memory_peak_bytes = cgroup->memory_peak_bytes();
+        if (result.memory_peak_bytes >= 0) result.max_rss_kb = result.memory_peak_bytes / 1024;
+        result.cpu_usage_usec = cgroup->cpu_usage_usec();
+        result.cpu_throttled_usec = cgroup->cpu_throttled_usec();
+        // As in Sandbox, leftover background processes go with the cgroup.
+        cgroup.reset();
+    }
+    // A killed or backgrounding command may leave processes behind, possibly
+    // holding the pipes; start from a clean worker.
+    return done && alive && !result.timed_out && !has_children(w.pid);
+}
+
+ExecutionResult SandboxPool::run(const std::string& command, int timeout_seconds) {
+    return run_streaming(command, timeout_seconds, nullptr);
+}
+
+ExecutionResult SandboxPool::run_streaming(const std::string& command, int timeout_seconds,
+                                           const OutputCallback& on_output) {
+    ProbeTimer timer(Probe::SandboxPoolRun);
+    Worker* w = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [&] {
+            for (auto& candidate : workers_) {
+                if (!candidate.busy) {
+                    w = &candidate;
+                    return true;
+                }
+            }
+            return false;
+        });
+        w->busy = true;
+    }
+
+    ExecutionResult result{};
+    result.memory_peak_bytes = -1;
+    result.cpu_usage_usec = -1;
+    result.cpu_throttled_usec = -1;
+    std::exception_ptr error;
+    try {
+        // Replace a worker that died while idle before handing it work.
+        if (w->pid > 0) {
+            pid_t reaped = waitpid(w->pid, nullptr, WNOHANG);
+            if (reaped != 0) {
+                // -1: not ours to wait for (SIGCHLD ignored, or reaped
+                // elsewhere), so it may still be running; kill it first.
+                if (reaped < 0) kill_group(w->pid);
+                w->pid = -1;
+                stop(*w);
+            }
+        }
+        if (w->pid < 0) start(*w);
+        bool reusable = execute(*w, command, timeout_seconds, on_output ? &on_output : nullptr, result);
+        if (!reusable || ++w->uses >= max_uses_) {
+            stop(*w);
+            start(*w);
+        }
+    } catch (...) {
+        error = std::current_exception();
+        stop(*w);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        w->busy = false;
+    }
+    cv_.notify_one();
+    if (error) std::rethrow_exception(error);
+    return result;
+}
+
+} // namespace agent_kernel
@@ -0,0 +1,118 @@
+#include "agent_kernel/sock_diag.h"
+#include "agent_kernel/stats.h"
+
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace agent_kernel {
+
+namespace {
+
+// Room for a few hundred records per recv(); dumps arrive in many batches.
+constexpr size_t kRecvBufSize = 64 * 1024;
+
+void fill_tcp_info(const struct rtattr* attr, SocketRecord& rec) {
+    struct tcp_info info{};
+    // Older kernels send a shorter struct; the missing tail stays zero.
+    std::memcpy(&info, RTA_DATA(attr), std::min<size_t>(RTA_PAYLOAD(attr), sizeof(info)));
+    rec.rtt_us = info.tcpi_rtt;
+    rec.retransmits = info.tcpi_total_retrans;
+    rec.bytes_acked = static_cast<int64_t>(info.tcpi_bytes_acked);
+    rec.bytes_received = static_cast<int64_t>(info.tcpi_bytes_received);
+}
+
+} // anonymous namespace
+
+SockDiag::SockDiag() : buf_(kRecvBufSize) {
+    fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+}
+
+SockDiag::~SockDiag() {
+    if (fd_ >= 0) close(fd_);
+}
+
+SockDiag& SockDiag::shared() {
+    static SockDiag diag;
+    return diag;
+}
+
+bool SockDiag::query(int family, int protocol, uint32_t states, bool tcp_info, std::vector<SocketRecord>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (fd_ < 0) return false;
+
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } msg{};
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.nlh.nlmsg_seq = ++seq_;
+    msg.req.sdiag_family = static_cast<uint8_t>(family);
+    msg.req.sdiag_protocol = static_cast<uint8_t>(protocol);
+    msg.req.idiag_states = states;
+    if (tcp_info && protocol == IPPROTO_TCP) msg.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+    struct sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    Stats::count(Syscall::Send);
+    if (sendto(fd_, &msg, sizeof(msg), 0, reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    const size_t base = out.size();
+    const size_t addr_len = family == AF_INET6 ? 16 : 4;
+    for (;;) {
+        ssize_t len = recv(fd_, buf_.data(), buf_.size(), 0);
+        Stats::count(Syscall::Recv);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            out.resize(base);
+            return false;
+        }
+
+        auto* nh = reinterpret_cast<struct nlmsghdr*>(buf_.data());
+        for (; NLMSG_OK(nh, static_cast<unsigned>(len)); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_seq != seq_) continue;  // stale reply from an aborted dump
+            if (nh->nlmsg_type == NLMSG_DONE) return true;
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                out.resize(base);
+                return false;
+            }
+            if (nh->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+
+            auto* d = static_cast<const struct inet_diag_msg*>(NLMSG_DATA(nh));
+            SocketRecord rec{};
+            rec.family = d->idiag_family;
+            rec.state = d->idiag_state;
+            rec.local_port = ntohs(d->id.idiag_sport);
+            rec.remote_port = ntohs(d->id.idiag_dport);
+            std::memcpy(rec.local_addr, d->id.idiag_src, addr_len);
+            std::memcpy(rec.remote_addr, d->id.idiag_dst, addr_len);
+            rec.uid = d->idiag_uid;
+            rec.inode = d->idiag_inode;
+            rec.rtt_us = rec.retransmits = rec.bytes_acked = rec.bytes_received = -1;
+
+            if (msg.req.idiag_ext) {
+                int attr_len = static_cast<int>(nh->nlmsg_len - NLMSG_LENGTH(sizeof(*d)));
+                auto* attr = reinterpret_cast<const struct rtattr*>(d + 1);
+                for (; RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                    if (attr->rta_type == INET_DIAG_INFO) fill_tcp_info(attr, rec);
+                }
+            }
+            out.push_back(rec);
+        }
+    }
+}
+
+} // namespace agent_kernel
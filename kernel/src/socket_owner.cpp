@@ -0,0 +1,211 @@
+#include "agent_kernel/socket_owner.h"
+#include "agent_kernel/proc_scanner.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace agent_kernel {
+
+namespace {
+
+// Layout returned by the getdents64 syscall (not exported by all libcs).
+struct linux_dirent64 {
+    ino64_t        d_ino;
+    off64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+constexpr size_t kDentsBufSize = 16384;
+
+// Cap on remembered misses; sockets close, so old entries go stale.
+constexpr size_t kMaxUnresolved = 65536;
+
+// "socket:[12345]" -> 12345; 0 for anything else.
+uint64_t socket_inode(const char* link, ssize_t len) {
+    static constexpr char kPrefix[] = "socket:[";
+    constexpr ssize_t kPrefixLen = sizeof(kPrefix) - 1;
+    if (len <= kPrefixLen + 1 || std::memcmp(link, kPrefix, kPrefixLen) != 0) return 0;
+    uint64_t inode = 0;
+    for (ssize_t i = kPrefixLen; i < len && link[i] != ']'; ++i) {
+        if (link[i] < '0' || link[i] > '9') return 0;
+        inode = inode * 10 + static_cast<uint64_t>(link[i] - '0');
+    }
+    return inode;
+}
+
+// Socket inodes held by `pid`, plus its comm. False if the fd table is
+// unreadable (exited, or another user's process without CAP_SYS_PTRACE).
+bool read_sockets(pid_t pid, std::vector<uint64_t>& inodes, std::string& name) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+    int dfd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) return false;
+
+    alignas(linux_dirent64) char dents[kDentsBufSize];
+    char link[64];
+    for (;;) {
+        long n = syscall(SYS_getdents64, dfd, dents, sizeof(dents));
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            auto* d = reinterpret_cast<linux_dirent64*>(dents + off);
+            off += d->d_reclen;
+            if (d->d_name[0] == '.') continue;
+            ssize_t len = readlinkat(dfd, d->d_name, link, sizeof(link));
+            if (uint64_t inode = len > 0 ? socket_inode(link, len) : 0) inodes.push_back(inode);
+        }
+    }
+    close(dfd);
+
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    name.clear();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char buf[64];
+        ssize_t len = ::read(fd, buf, sizeof(buf));
+        if (len > 0) name.assign(buf, static_cast<size_t>(buf[len - 1] == '\n' ? len - 1 : len));
+        close(fd);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+SocketOwnerIndex::SocketOwnerIndex(int full_rescan_interval_ms)
+    : full_rescan_interval_(full_rescan_interval_ms > 0 ? full_rescan_interval_ms : 0) {}
+
+void SocketOwnerIndex::drop_locked(pid_t pid) {
+    auto it = procs_.find(pid);
+    if (it == procs_.end()) return;
+    for (uint64_t inode : it->second.inodes) {
+        auto o = owners_.find(inode);
+        if (o != owners_.end() && o->second == pid) owners_.erase(o);
+    }
+    procs_.erase(it);
+}
+
+void SocketOwnerIndex::scan_locked(pid_t pid) {
+    drop_locked(pid);
+    Process proc;
+    if (!read_sockets(pid, proc.inodes, proc.name) || proc.inodes.empty()) return;
+    for (uint64_t inode : proc.inodes) {
+        auto [it, inserted] = owners_.emplace(inode, pid);
+        if (!inserted && pid < it->second) it->second = pid;
+        unresolved_.erase(inode);
+    }
+    procs_.emplace(pid, std::move(proc));
+}
+
+void SocketOwnerIndex::rebuild() {
+    auto pids = ProcScanner::system().pids();
+    std::lock_guard<std::mutex> lock(mtx_);
+    owners_.clear();
+    procs_.clear();
+    unresolved_.clear();
+    for (pid_t pid : pids) scan_locked(pid);
+    last_full_scan_ = std::chrono::steady_clock::now();
+}
+
+void SocketOwnerIndex::apply(const ProcessDelta& delta) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (pid_t pid : delta.exited) drop_locked(pid);
+    for (const auto& p : delta.spawned) scan_locked(p.pid);
+    for (pid_t pid : delta.execed) scan_locked(pid);  // CLOEXEC sockets are gone
+}
+
+void SocketOwnerIndex::apply(const std::vector<ProcEvent>& events) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto& e : events) {
+        if (e.type == ProcEventType::Exit) {
+            drop_locked(e.pid);
+        } else {
+            scan_locked(e.pid);
+        }
+    }
+}
+
+void SocketOwnerIndex::refresh(const std::vector<pid_t>& pids) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (pid_t pid : pids) scan_locked(pid);
+}
+
+bool SocketOwnerIndex::lookup(uint64_t inode, SocketOwner& out) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = owners_.find(inode);
+    if (it == owners_.end()) return false;
+    out.pid = it->second;
+    out.name = procs_.at(it->second).name;
+    return true;
+}
+
+size_t SocketOwnerIndex::annotate_locked(std::vector<ConnectionInfo>& conns, std::vector<uint64_t>* misses) {
+    size_t found = 0;
+    for (auto& c : conns) {
+        if (c.pid != 0) {
+            ++found;
+            continue;
+        }
+        // Inode 0: a connection still in an accept queue has no file yet
+        if (c.inode == 0) continue;
+        auto it = owners_.find(c.inode);
+        if (it != owners_.end()) {
+            c.pid = it->second;
+            c.process_name = procs_.at(it->second).name;
+            ++found;
+        } else if (misses) {
+            misses->push_back(c.inode);
+        }
+    }
+    return found;
+}
+
+size_t SocketOwnerIndex::annotate(std::vector<ConnectionInfo>& conns) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<uint64_t> misses;
+    size_t found = annotate_locked(conns, &misses);
+
+    // Inodes that already survived a full rescan (another netns, unreadable
+    // fd tables) are not worth another one.
+    misses.erase(std::remove_if(misses.begin(), misses.end(),
+                                [&](uint64_t inode) { return unresolved_.count(inode) != 0; }),
+                 misses.end());
+    if (misses.empty()) return found;
+
+    // New sockets mostly belong to processes that already hold some.
+    std::vector<pid_t> owners;
+    owners.reserve(procs_.size());
+    for (const auto& [pid, _] : procs_) owners.push_back(pid);
+    for (pid_t pid : owners) scan_locked(pid);
+    found = annotate_locked(conns, nullptr);
+
+    auto missing = [&](uint64_t inode) { return owners_.count(inode) == 0; };
+    auto now = std::chrono::steady_clock::now();
+    if (std::none_of(misses.begin(), misses.end(), missing) ||
+        now - last_full_scan_ < full_rescan_interval_) {
+        return found;
+    }
+
+    for (pid_t pid : ProcScanner::system().pids()) {
+        if (procs_.count(pid) == 0) scan_locked(pid);
+    }
+    last_full_scan_ = now;
+    if (unresolved_.size() > kMaxUnresolved) unresolved_.clear();
+    for (uint64_t inode : misses) {
+        if (missing(inode)) unresolved_.insert(inode);
+    }
+    return annotate_locked(conns, nullptr);
+}
+
+size_t SocketOwnerIndex::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return owners_.size();
+}
+
+} // namespace agent_kernel
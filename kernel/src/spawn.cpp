@@ -0,0 +1,174 @@
+#include "agent_kernel/spawn.h"
+#include "agent_kernel/process_events.h"
+#include "agent_kernel/stats.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+extern char** environ;
+
+namespace agent_kernel {
+
+namespace {
+
+// The child only runs a handful of syscalls before execve.
+constexpr size_t kChildStackSize = 64 * 1024;
+
+struct ChildArgs {
+    const SpawnOptions* options;
+    char* const* argv;
+    char* const* envp;
+    sigset_t parent_mask;
+    int exec_errno;    // written by the child; shared through CLONE_VM
+    int cgroup_errno;
+};
+
+void set_limit(int resource, int64_t value) {
+    if (value < 0) return;  // unlimited — nothing to do
+    struct rlimit rl;
+    rl.rlim_cur = static_cast<rlim_t>(value);
+    rl.rlim_max = static_cast<rlim_t>(value);
+    setrlimit(resource, &rl);
+}
+
+// Descriptors the parent leaked without O_CLOEXEC (Python opens plenty).
+void close_fds_from(int first) {
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, first, ~0U, 0) == 0) return;
+#endif
+    struct rlimit rl;
+    int limit = (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < 65536)
+        ? static_cast<int>(rl.rlim_cur) : 65536;
+    for (int fd = first; fd < limit; ++fd) close(fd);
+}
+
+// Runs on its own stack in the parent's address space until execve, so it
+// must not allocate, lock, or touch anything the parent might be using.
+int child_main(void* arg) {
+    auto* a = static_cast<ChildArgs*>(arg);
+    const SpawnOptions& o = *a->options;
+
+    // Parent handlers would run against the parent's memory; reset them
+    // (leaving SIG_IGN alone, as exec does) before unblocking.
+    struct sigaction dfl{};
+    dfl.sa_handler = SIG_DFL;
+    for (int sig = 1; sig < NSIG; ++sig) {
+        struct sigaction cur;
+        if (sigaction(sig, nullptr, &cur) == 0 && cur.sa_handler != SIG_IGN && cur.sa_handler != SIG_DFL) {
+            sigaction(sig, &dfl, nullptr);
+        }
+    }
+    sigprocmask(SIG_SETMASK, &a->parent_mask, nullptr);
+
+    if (o.stdin_fd >= 0) dup2(o.stdin_fd, STDIN_FILENO);
+    if (o.stdout_fd >= 0) dup2(o.stdout_fd, STDOUT_FILENO);
+    if (o.stderr_fd >= 0) dup2(o.stderr_fd, STDERR_FILENO);
+    // Join before exec so the command is accounted from its first page.
+    if (o.cgroup_procs_fd >= 0 && write(o.cgroup_procs_fd, "0", 1) != 1) {
+        a->cgroup_errno = errno;
+        _exit(125);
+    }
+    if (o.close_other_fds) close_fds_from(3);
+    if (o.new_process_group) setpgid(0, 0);
+    if (o.child_subreaper) prctl(PR_SET_CHILD_SUBREAPER, 1, 0, 0, 0);
+
+    // Limits go on before execve rather than through prlimit() afterwards,
+    // which would leave the new image running unlimited for a moment.
+    const ResourceLimits& lim = o.limits;
+    set_limit(RLIMIT_CPU, lim.max_cpu_seconds);
+    set_limit(RLIMIT_AS, lim.max_memory_bytes);
+    set_limit(RLIMIT_FSIZE, lim.max_file_size);
+    set_limit(RLIMIT_NOFILE, lim.max_open_files);
+    set_limit(RLIMIT_NPROC, lim.max_processes);
+
+    if (!o.working_dir.empty() && chdir(o.working_dir.c_str()) != 0) {
+        _exit(126);
+    }
+
+    execve(o.path.c_str(), a->argv, a->envp);
+    a->exec_errno = errno;
+    _exit(127);
+}
+
+// environ with `overrides` (KEY=VALUE) replacing or extending it.
+std::vector<std::string> merged_env(const std::vector<std::string>& overrides) {
+    std::vector<std::string> env;
+    for (char** e = environ; e && *e; ++e) {
+        const char* eq = std::strchr(*e, '=');
+        size_t key_len = eq ? static_cast<size_t>(eq - *e) : std::strlen(*e);
+        bool replaced = false;
+        for (const auto& o : overrides) {
+            if (o.size() > key_len && o[key_len] == '=' && o.compare(0, key_len, *e, key_len) == 0) {
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) env.emplace_back(*e);
+    }
+    for (const auto& o : overrides) {
+        if (o.find('=') != std::string::npos) env.push_back(o);
+    }
+    return env;
+}
+
+} // anonymous namespace
+
+pid_t spawn_process(const SpawnOptions& options) {
+    // Everything the child needs is materialized up front.
+    std::vector<char*> argv;
+    argv.reserve(options.argv.size() + 1);
+    for (const auto& s : options.argv) argv.push_back(const_cast<char*>(s.c_str()));
+    argv.push_back(nullptr);
+
+    std::vector<std::string> env_storage = merged_env(options.env);
+    std::vector<char*> envp;
+    envp.reserve(env_storage.size() + 1);
+    for (auto& s : env_storage) envp.push_back(s.data());
+    envp.push_back(nullptr);
+
+    void* stack = mmap(nullptr, kChildStackSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        throw std::runtime_error(std::string("mmap failed: ") + strerror(errno));
+    }
+
+    ChildArgs args{&options, argv.data(), envp.data(), {}, 0, 0};
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &args.parent_mask);
+
+    // CLONE_VFORK suspends us until the child has exec'd or exited.
+    pid_t pid = clone(child_main, static_cast<char*>(stack) + kChildStackSize,
+                      CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+    int clone_errno = errno;
+    Stats::count(Syscall::Clone);
+
+    pthread_sigmask(SIG_SETMASK, &args.parent_mask, nullptr);
+    munmap(stack, kChildStackSize);
+
+    if (pid < 0) {
+        throw std::runtime_error(std::string("clone failed: ") + strerror(clone_errno));
+    }
+    if (args.cgroup_errno != 0) {
+        waitpid(pid, nullptr, 0);
+        throw std::runtime_error(std::string("joining cgroup failed: ") + strerror(args.cgroup_errno));
+    }
+    if (args.exec_errno != 0) {
+        waitpid(pid, nullptr, 0);
+        throw std::runtime_error("exec " + options.path + " failed: " + strerror(args.exec_errno));
+    }
+    ProcessEventStream::track_spawned(pid);
+    return pid;
+}
+
+} // namespace agent_kernel
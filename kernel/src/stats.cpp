@@ -0,0 +1,287 @@
+#include "agent_kernel/stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace agent_kernel {
+
+namespace {
+
+constexpr size_t kProbes = static_cast<size_t>(Probe::kCount);
+constexpr size_t kSyscalls = static_cast<size_t>(Syscall::kCount);
+
+const char* const kProbeNames[kProbes] = {
+    "metrics.cpu",
+    "metrics.memory",
+    "metrics.disk",
+    "metrics.all_disks",
+    "metrics.snapshot",
+    "process.list_all",
+    "process.list_columns",
+    "process.get_info",
+    "process.children",
+    "process.tree",
+    "process.subtree",
+    "process.spawn",
+    "sandbox.run",
+    "sandbox.run_streaming",
+    "sandbox.run_batch",
+    "sandbox_pool.run",
+    "network.connections",
+    "network.connection_columns",
+    "network.listening_ports",
+    "network.interfaces",
+    "network.parse_table",
+    "file.search",
+    "file.tail",
+    "file.grep",
+    "file.dir_size",
+};
+
+const char* const kSyscallNames[kSyscalls] = {
+    "openat", "read", "getdents64", "fstatat", "sendto", "recv", "clone",
+};
+
+// Single writer (the owning thread), any number of readers: a plain
+// load/store pair keeps the hot path free of locked instructions.
+struct Counter {
+    std::atomic<uint64_t> v{0};
+
+    void add(uint64_t n) noexcept { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void raise(uint64_t n) noexcept {
+        if (n > v.load(std::memory_order_relaxed)) v.store(n, std::memory_order_relaxed);
+    }
+    uint64_t get() const noexcept { return v.load(std::memory_order_relaxed); }
+};
+
+struct ProbeBlock {
+    Counter calls, errors, total_ns, max_ns;
+    Counter buckets[Stats::kBuckets];
+};
+
+struct Block {
+    ProbeBlock probes[kProbes];
+    Counter syscalls[kSyscalls];
+    Counter procfs_bytes;
+};
+
+void merge(Block& into, const Block& from) noexcept {
+    for (size_t p = 0; p < kProbes; ++p) {
+        auto& a = into.probes[p];
+        const auto& b = from.probes[p];
+        a.calls.add(b.calls.get());
+        a.errors.add(b.errors.get());
+        a.total_ns.add(b.total_ns.get());
+        a.max_ns.raise(b.max_ns.get());
+        for (size_t i = 0; i < Stats::kBuckets; ++i) a.buckets[i].add(b.buckets[i].get());
+    }
+    for (size_t s = 0; s < kSyscalls; ++s) into.syscalls[s].add(from.syscalls[s].get());
+    into.procfs_bytes.add(from.procfs_bytes.get());
+}
+
+// Leaked on purpose: threads can still exit, and retire their block,
+// after static destructors have run.
+struct Registry {
+    std::mutex mtx;
+    std::vector<Block*> live;
+    Block retired;          // totals of exited threads
+    size_t threads = 0;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// The pointer and flag are trivially destructible, so they stay readable
+// while the thread's other thread_locals are torn down; the Retirer moves
+// the block into the registry's totals when the thread exits.
+thread_local Block* t_block = nullptr;
+thread_local bool t_retired = false;
+
+struct Retirer {
+    ~Retirer() {
+        Block* block = t_block;
+        t_block = nullptr;
+        t_retired = true;
+        if (!block) return;
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mtx);
+        merge(r.retired, *block);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), block));
+        delete block;
+    }
+};
+
+thread_local Retirer t_retirer;
+
+// This thread's block, registered on first use. Null if that failed for
+// lack of memory or the thread is already exiting; either way nothing is
+// recorded.
+Block* local() noexcept {
+    if (t_block) return t_block;
+    if (t_retired) return nullptr;
+    auto* b = new (std::nothrow) Block;
+    if (!b) return nullptr;
+    auto& r = registry();
+    try {
+        std::lock_guard<std::mutex> lock(r.mtx);
+        r.live.push_back(b);
+        ++r.threads;
+    } catch (...) {
+        delete b;
+        return nullptr;
+    }
+    (void)&t_retirer;  // construct it, so this thread retires its block
+    return t_block = b;
+}
+
+} // anonymous namespace
+
+uint64_t ProbeStats::quantile_ns(double q) const {
+    if (calls == 0) return 0;
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(calls)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1)) return std::min(Stats::bucket_upper_ns(i), max_ns);
+    }
+    return max_ns;
+}
+
+size_t Stats::bucket_index(uint64_t ns) noexcept {
+    if (ns < 1024) return 0;
+    int msb = 63 - __builtin_clzll(ns);
+    size_t sub = (ns >> (msb - 2)) & 3;
+    size_t index = 1 + static_cast<size_t>(msb - 10) * 4 + sub;
+    return std::min(index, kBuckets - 1);
+}
+
+uint64_t Stats::bucket_upper_ns(size_t index) noexcept {
+    if (index == 0) return 1024;
+    int msb = 10 + static_cast<int>((index - 1) / 4);
+    uint64_t sub = (index - 1) % 4;
+    return (4 + sub + 1) << (msb - 2);
+}
+
+void Stats::record_call(Probe p, uint64_t ns, bool failed) noexcept {
+    Block* b = local();
+    if (!b) return;
+    auto& pb = b->probes[static_cast<size_t>(p)];
+    pb.calls.add(1);
+    if (failed) pb.errors.add(1);
+    pb.total_ns.add(ns);
+    pb.max_ns.raise(ns);
+    pb.buckets[bucket_index(ns)].add(1);
+}
+
+void Stats::count(Syscall s, uint64_t n) noexcept {
+    if (Block* b = local()) b->syscalls[static_cast<size_t>(s)].add(n);
+}
+
+void Stats::count_procfs_bytes(uint64_t n) noexcept {
+    if (Block* b = local()) b->procfs_bytes.add(n);
+}
+
+KernelStats Stats::snapshot() {
+    Block total;
+    size_t threads;
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mtx);
+        merge(total, r.retired);
+        for (const Block* b : r.live) merge(total, *b);
+        threads = r.threads;
+    }
+
+    KernelStats out;
+    out.threads = threads;
+    out.probes.resize(kProbes);
+    for (size_t p = 0; p < kProbes; ++p) {
+        const auto& pb = total.probes[p];
+        auto& ps = out.probes[p];
+        ps.name = kProbeNames[p];
+        ps.calls = pb.calls.get();
+        ps.errors = pb.errors.get();
+        ps.total_ns = pb.total_ns.get();
+        ps.max_ns = pb.max_ns.get();
+        ps.buckets.resize(kBuckets);
+        for (size_t i = 0; i < kBuckets; ++i) ps.buckets[i] = pb.buckets[i].get();
+    }
+    for (size_t s = 0; s < kSyscalls; ++s) out.syscalls.emplace_back(kSyscallNames[s], total.syscalls[s].get());
+    out.procfs_bytes = total.procfs_bytes.get();
+    return out;
+}
+
+std::string Stats::prometheus() {
+    KernelStats st = snapshot();
+    std::string out;
+    char line[256];
+    auto emit = [&](const char* fmt, auto... args) {
+        int n = std::snprintf(line, sizeof(line), fmt, args...);
+        out.append(line, static_cast<size_t>(std::min<int>(n, sizeof(line) - 1)));
+    };
+
+    out += "# HELP agent_kernel_calls_total Calls into each kernel entry point.\n"
+           "# TYPE agent_kernel_calls_total counter\n";
+    for (const auto& p : st.probes) {
+        if (p.calls) emit("agent_kernel_calls_total{probe=\"%s\"} %llu\n", p.name.c_str(), (unsigned long long)p.calls);
+    }
+    out += "# HELP agent_kernel_call_errors_total Calls that ended in an exception.\n"
+           "# TYPE agent_kernel_call_errors_total counter\n";
+    for (const auto& p : st.probes) {
+        if (p.calls) emit("agent_kernel_call_errors_total{probe=\"%s\"} %llu\n", p.name.c_str(), (unsigned long long)p.errors);
+    }
+
+    // Exposed at every second power of two from 1.024 us: bucket 8k of the
+    // fine histogram ends exactly at 2^(10+2k) ns.
+    out += "# HELP agent_kernel_call_seconds Latency of each kernel entry point.\n"
+           "# TYPE agent_kernel_call_seconds histogram\n";
+    for (const auto& p : st.probes) {
+        if (!p.calls) continue;
+        uint64_t cumulative = 0;
+        size_t next = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            cumulative += p.buckets[i];
+            if (i != next) continue;
+            emit("agent_kernel_call_seconds_bucket{probe=\"%s\",le=\"%.9g\"} %llu\n", p.name.c_str(),
+                 static_cast<double>(bucket_upper_ns(i)) / 1e9, (unsigned long long)cumulative);
+            next += 8;
+        }
+        // The bucket total, not p.calls: a call recorded mid-snapshot may
+        // be in one and not the other, and +Inf must not undercut a bucket.
+        emit("agent_kernel_call_seconds_bucket{probe=\"%s\",le=\"+Inf\"} %llu\n", p.name.c_str(),
+             (unsigned long long)cumulative);
+        emit("agent_kernel_call_seconds_sum{probe=\"%s\"} %.9f\n", p.name.c_str(),
+             static_cast<double>(p.total_ns) / 1e9);
+        emit("agent_kernel_call_seconds_count{probe=\"%s\"} %llu\n", p.name.c_str(),
+             (unsigned long long)cumulative);
+    }
+
+    out += "# HELP agent_kernel_syscalls_total System calls issued by the kernel's own code.\n"
+           "# TYPE agent_kernel_syscalls_total counter\n";
+    for (const auto& s : st.syscalls) {
+        emit("agent_kernel_syscalls_total{call=\"%s\"} %llu\n", s.first.c_str(), (unsigned long long)s.second);
+    }
+    out += "# HELP agent_kernel_procfs_read_bytes_total Bytes read from procfs, sysfs and cgroupfs.\n"
+           "# TYPE agent_kernel_procfs_read_bytes_total counter\n";
+    emit("agent_kernel_procfs_read_bytes_total %llu\n", (unsigned long long)st.procfs_bytes);
+    return out;
+}
+
+const char* Stats::probe_name(Probe p) noexcept {
+    auto i = static_cast<size_t>(p);
+    return i < kProbes ? kProbeNames[i] : "?";
+}
+
+const char* Stats::syscall_name(Syscall s) noexcept {
+    auto i = static_cast<size_t>(s);
+    return i < kSyscalls ? kSyscallNames[i] : "?";
+}
+
+} // namespace agent_kernel
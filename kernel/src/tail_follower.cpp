@@ -0,0 +1,123 @@
+#include "agent_kernel/tail_follower.h"
+#include "agent_kernel/file_utils.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace agent_kernel {
+
+namespace {
+
+std::string parent_dir(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+} // anonymous namespace
+
+TailFollower::TailFollower(const std::string& path, bool from_end) : path_(path) {
+    fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open file: " + path_ + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        int err = errno;
+        close(fd_);
+        throw std::runtime_error("fstat failed for " + path_ + ": " + strerror(err));
+    }
+    dev_ = st.st_dev;
+    ino_ = st.st_ino;
+    offset_ = from_end ? static_cast<uint64_t>(st.st_size) : 0;
+
+    try {
+        file_wd_ = watcher_.watch(path_, static_cast<uint32_t>(FSEventType::Modified));
+        // A rotated-in file shows up as a create or rename in the directory
+        watcher_.watch(parent_dir(path_),
+                       static_cast<uint32_t>(FSEventType::Created) | static_cast<uint32_t>(FSEventType::Moved));
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+TailFollower::~TailFollower() {
+    if (fd_ >= 0) close(fd_);
+}
+
+uint64_t TailFollower::offset() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return offset_;
+}
+
+// Switch to a new file at path_ once the old one has been read to its end.
+bool TailFollower::reopen_if_rotated() {
+    struct stat st;
+    if (stat(path_.c_str(), &st) != 0) return false;
+    if (st.st_dev == dev_ && st.st_ino == ino_) return false;
+
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    close(fd_);
+    fd_ = fd;
+    dev_ = st.st_dev;
+    ino_ = st.st_ino;
+    offset_ = 0;
+
+    if (file_wd_ >= 0) watcher_.unwatch(file_wd_);
+    try {
+        file_wd_ = watcher_.watch(path_, static_cast<uint32_t>(FSEventType::Modified));
+    } catch (const std::runtime_error&) {
+        file_wd_ = -1;   // still woken by the directory watch on rotation
+    }
+    return true;
+}
+
+std::string TailFollower::read_available(size_t max_bytes) {
+    std::string out;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        struct stat st;
+        if (fstat(fd_, &st) != 0) return out;
+        auto size = static_cast<uint64_t>(st.st_size);
+        if (size < offset_) offset_ = 0;   // truncated
+
+        if (size > offset_) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(size - offset_, max_bytes));
+            out.resize(want);
+            size_t got = pread_full(fd_, &out[0], want, static_cast<off_t>(offset_));
+            out.resize(got);
+            offset_ += got;
+            return out;
+        }
+        // At the end of this file: continue with its replacement, if any
+        if (!reopen_if_rotated()) return out;
+    }
+    return out;
+}
+
+std::string TailFollower::read(int timeout_ms, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (max_bytes == 0) return "";
+    std::string out = read_available(max_bytes);
+
+    // Events for other files in the directory wake us too; wait out the rest
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (out.empty()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+        if (left <= 0) break;
+        if (watcher_.poll_into(events_, static_cast<int>(left)) == 0) break;
+        out = read_available(max_bytes);
+    }
+    return out;
+}
+
+} // namespace agent_kernel
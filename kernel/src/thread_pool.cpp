@@ -0,0 +1,134 @@
+#include "agent_kernel/thread_pool.h"
+#include "agent_kernel/cgroup.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <memory>
+
+namespace agent_kernel {
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;  // stopping and drained
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+unsigned ThreadPool::size() const noexcept {
+    return static_cast<unsigned>(workers_.size());
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0) return;
+    if (n == 1) {
+        fn(0);
+        return;
+    }
+
+    // Helpers may be dequeued long after this call returns (e.g. when the
+    // pool is busy), so they hold the state by shared_ptr and only touch
+    // `fn` after successfully claiming an index — which can only happen
+    // while the caller is still waiting.
+    struct State {
+        const std::function<void(size_t)>* fn;
+        size_t n;
+        std::atomic<size_t> next{0};
+        size_t done = 0;
+        std::exception_ptr error;
+        std::mutex mtx;
+        std::condition_variable cv;
+    };
+    auto st = std::make_shared<State>();
+    st->fn = &fn;
+    st->n = n;
+
+    auto drain = [](State& s) {
+        for (;;) {
+            size_t i = s.next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= s.n) return;
+            std::exception_ptr err;
+            try {
+                (*s.fn)(i);
+            } catch (...) {
+                err = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(s.mtx);
+            if (err && !s.error) s.error = err;
+            if (++s.done == s.n) s.cv.notify_all();
+        }
+    };
+
+    size_t helpers = std::min<size_t>(n - 1, workers_.size());
+    for (size_t h = 0; h < helpers; ++h) {
+        submit([st, drain] { drain(*st); });
+    }
+    drain(*st);
+
+    std::unique_lock<std::mutex> lock(st->mtx);
+    st->cv.wait(lock, [&] { return st->done == st->n; });
+    if (st->error) std::rethrow_exception(st->error);
+}
+
+ThreadPool& ThreadPool::shared() {
+    // parallel_for callers work too, so one fewer keeps scans at one
+    // thread per usable CPU.
+    static ThreadPool pool(std::max(usable_cpus(), 2u) - 1);
+    return pool;
+}
+
+unsigned usable_cpus() {
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (cpus == 0) cpus = 1;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        unsigned affinity = static_cast<unsigned>(CPU_COUNT(&set));
+        if (affinity > 0 && affinity < cpus) cpus = affinity;
+    }
+
+    double quota = CgroupManager::info().cpu_quota;
+    if (quota > 0) {
+        unsigned limit = static_cast<unsigned>(std::ceil(quota));
+        if (limit > 0 && limit < cpus) cpus = limit;
+    }
+    return cpus;
+}
+
+} // namespace agent_kernel